@@ -206,6 +206,8 @@ class JscEngine : public ::script::ScriptEngine {
 
   friend class ::script::ScriptClass;
 
+  friend class ::script::Json;
+
   friend class JscStringRefHolder;
 
   friend class JscWeakRef;
@@ -20,6 +20,7 @@
 
 #include "../../src/Native.hpp"
 #include "../../src/Reference.h"
+#include "../../src/Serializer.h"
 #include "../../src/Utils.h"
 #include "../../src/Value.h"
 #include "JscEngine.h"
@@ -165,6 +166,11 @@ REF_IMPL_BASIC_NOT_VALUE(ByteBuffer)
 REF_IMPL_BASIC_EQUALS(ByteBuffer)
 REF_IMPL_TO_VALUE(ByteBuffer)
 
+REF_IMPL_BASIC_FUNC(Promise)
+REF_IMPL_BASIC_NOT_VALUE(Promise)
+REF_IMPL_BASIC_EQUALS(Promise)
+REF_IMPL_TO_VALUE(Promise)
+
 REF_IMPL_BASIC_FUNC(Unsupported)
 REF_IMPL_BASIC_NOT_VALUE(Unsupported)
 REF_IMPL_BASIC_EQUALS(Unsupported)
@@ -262,6 +268,12 @@ bool Local<Value>::isByteBuffer() const {
   return false;
 }
 
+bool Local<Value>::isPromise() const {
+  if (!isObject()) return false;
+  // no JSC api for promises
+  return asObject().instanceOf(jsc_backend::currentEngine()->getGlobal().get("Promise"));
+}
+
 bool Local<Value>::isObject() const {
   return val_ != nullptr && JSValueIsObject(jsc_backend::currentEngineContextChecked(), val_);
 }
@@ -306,6 +318,14 @@ Local<ByteBuffer> Local<Value>::asByteBuffer() const {
   throw Exception("can't cast value as ByteBuffer");
 }
 
+Local<Promise> Local<Value>::asPromise() const {
+  if (isPromise()) {
+    return Local<Promise>{
+        jsc_backend::valueToObj(jsc_backend::currentEngineContextChecked(), val_)};
+  }
+  throw Exception("can't cast value as Promise");
+}
+
 Local<Object> Local<Value>::asObject() const {
   if (isObject()) {
     return Local<Object>{jsc_backend::valueToObj(jsc_backend::currentEngineContextChecked(), val_)};
@@ -484,6 +504,18 @@ void Local<Array>::clear() const {
   jsc_backend::JscEngine::checkException(jscException);
 }
 
+void Local<Array>::forEachImpl(ForEachCallback callback, void* data) const {
+  auto context = jsc_backend::currentEngineContextChecked();
+  auto length = size();
+  for (size_t i = 0; i < length; ++i) {
+    JSValueRef jscException = nullptr;
+    auto element =
+        JSObjectGetPropertyAtIndex(context, val_, static_cast<unsigned>(i), &jscException);
+    jsc_backend::JscEngine::checkException(jscException);
+    callback(data, i, Local<Value>(element));
+  }
+}
+
 namespace {
 ByteBuffer::Type mapType(JSTypedArrayType type) {
   switch (type) {
@@ -591,4 +623,33 @@ void Local<ByteBuffer>::commit() const {}
 
 void Local<ByteBuffer>::sync() const {}
 
+Promise::State Local<Promise>::getState() const {
+  throw Exception("Promise state is not supported by JavaScriptCore");
+}
+
+Local<Value> Local<Promise>::getResult() const {
+  throw Exception("Promise state is not supported by JavaScriptCore");
+}
+
+Local<Promise> Local<Promise>::then(const Local<Value>& onFulfilled,
+                                    const Local<Value>& onRejected) const {
+  auto then = asValue().asObject().get("then").asFunction();
+  return then.call(*this, {onFulfilled, onRejected}).asPromise();
+}
+
+// handle is [resolve, reject], see Promise::newPromise
+void Promise::Resolver::resolve(const Local<Value>& value) const {
+  handle_.get().asArray().get(0).asFunction().call({}, value);
+}
+
+void Promise::Resolver::reject(const Local<Value>& reason) const {
+  handle_.get().asArray().get(1).asFunction().call({}, reason);
+}
+
+size_t internal::identityHash(const Local<Value>& value) {
+  // JSValueRef of an object is the pointer to the object
+  auto context = jsc_backend::currentEngineContextChecked();
+  return reinterpret_cast<size_t>(jsc_interop::toJsc(context, value));
+}
+
 }  // namespace script
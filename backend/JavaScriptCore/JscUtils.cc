@@ -18,6 +18,7 @@
 #include <JavaScriptCore/JavaScript.h>
 #include "../../src/Reference.h"
 #include "../../src/Utils.h"
+#include "JscEngine.h"
 #include "JscHelper.h"
 
 namespace script {
@@ -88,4 +89,34 @@ std::u8string_view StringHolder::u8stringView() const {
 const char8_t *StringHolder::c_u8str() const { return reinterpret_cast<const char8_t *>(c_str()); }
 #endif
 
+Local<Value> Json::parse(std::string_view json) {
+  auto context = jsc_backend::currentEngineContextChecked();
+  auto source = JSStringCreateWithUTF8CString(std::string(json).c_str());
+  auto ret = JSValueMakeFromJSONString(context, source);
+  JSStringRelease(source);
+  if (!ret) {
+    // JSValueMakeFromJSONString doesn't tell why
+    throw Exception("invalid json");
+  }
+  return jsc_backend::JscEngine::make<Local<Value>>(ret);
+}
+
+std::string Json::stringify(const Local<Value> &value) {
+  auto context = jsc_backend::currentEngineContextChecked();
+  JSValueRef exception = nullptr;
+  auto str = JSValueCreateJSONString(context, jsc_backend::JscEngine::toJsc(context, value), 0,
+                                     &exception);
+  jsc_backend::JscEngine::checkException(exception);
+  if (!str) {
+    return {};
+  }
+
+  std::string json(JSStringGetMaximumUTF8CStringSize(str), '\0');
+  auto length = JSStringGetUTF8CString(str, json.data(), json.size());
+  JSStringRelease(str);
+  // length includes the null terminator
+  json.resize(length > 0 ? length - 1 : 0);
+  return json;
+}
+
 }  // namespace script
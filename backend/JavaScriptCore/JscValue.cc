@@ -80,6 +80,16 @@ Local<String> String::newString(const std::u8string& utf8) { return newString(ut
 
 #endif
 
+Local<String> String::newExternalString(std::shared_ptr<const std::string> utf8) {
+  if (!utf8) throw Exception("null pointer");
+  // JSStringCreateWithCharactersNoCopy needs utf16, which is a copy anyway
+  return newString(*utf8);
+}
+
+Local<String> String::newExternalStaticString(std::string_view staticUtf8) {
+  return newString(staticUtf8);
+}
+
 Local<Number> Number::newNumber(float value) { return newNumber(static_cast<double>(value)); }
 
 Local<Number> Number::newNumber(double value) {
@@ -176,6 +186,19 @@ Local<Array> Array::newArrayImpl(size_t size, const Local<Value>* args) {
       });
 }
 
+Promise::Resolver Promise::newPromise() {
+  // no native api, take the resolving functions out of an executor, it's called synchronously
+  auto functions = Array::newArray(2);
+  auto executor = Function::newFunction([functions](const Arguments& args) -> Local<Value> {
+    functions.set(0, args[0]);
+    functions.set(1, args[1]);
+    return {};
+  });
+  auto promiseClass = jsc_backend::currentEngine()->getGlobal().get("Promise");
+  auto promise = Object::newObject(promiseClass, {executor});
+  return Resolver(promise.asValue().asPromise(), functions);
+}
+
 Local<ByteBuffer> ByteBuffer::newByteBuffer(size_t size) {
   // NOLINTNEXTLINE (cppcoreguidelines-avoid-c-arrays)
   auto ptr = std::make_unique<uint8_t[]>(size);
@@ -54,6 +54,11 @@ struct RefTypeMap<ByteBuffer> {
   using jscType = JSObjectRef;
 };
 
+template <>
+struct RefTypeMap<Promise> {
+  using jscType = JSObjectRef;
+};
+
 class StringLocalRef {
  public:
   class SharedStringRef {
@@ -174,6 +174,7 @@ void LuaEngine::defineInstanceConstructor(
             void* thiz;
             auto argsBase = 2;
             auto argsCount = lua_gettop(lua) - 1;
+            auto engine = static_cast<LuaEngine*>(lua_touserdata(lua, lua_upvalueindex(3)));
 
             if (argsCount == 3 && lua_islightuserdata(lua, -2) &&
                 lua_touserdata(lua, -2) == kLuaNativeConstructorMarker_) {
@@ -183,8 +184,6 @@ void LuaEngine::defineInstanceConstructor(
             } else {
               // this logic is for
               // ScriptClass::ScriptClass(const Local<Object>& thiz)
-
-              auto engine = static_cast<LuaEngine*>(lua_touserdata(lua, lua_upvalueindex(3)));
               thiz = define->instanceDefine.constructor(
                   makeArguments(engine, argsBase, argsCount, true));
             }
@@ -203,6 +202,9 @@ void LuaEngine::defineInstanceConstructor(
 
             lua_pushlightuserdata(lua, define);
             lua_rawsetp(lua, 1, kLuaTableNativeClassDefinePtrToken_);
+
+            engine->adjustAssociatedMemory(
+                static_cast<int64_t>(define->instanceDefine.instanceSize));
             return 1;
           } catch (const Exception& e) {
             exception = e.message();
@@ -221,8 +223,15 @@ void LuaEngine::defineInstanceConstructor(
 
     lua_pushcfunction(lua_, [](lua_State* lua) {
       lua_rawgetp(lua, 1, kLuaTableNativeScriptClassPtrToken_);
+      auto scriptClass = static_cast<ScriptClass*>(lua_touserdata(lua, -1));
+      if (scriptClass) {
+        lua_rawgetp(lua, 1, kLuaTableNativeClassDefinePtrToken_);
+        auto define = static_cast<internal::ClassDefineState*>(lua_touserdata(lua, -1));
+        scriptClass->internalState_.scriptEngine_->adjustAssociatedMemory(
+            -static_cast<int64_t>(define->instanceDefine.instanceSize));
+      }
       ExitEngineScope exit;
-      delete static_cast<ScriptClass*>(lua_touserdata(lua, -1));
+      delete scriptClass;
       return 0;
     });
     lua_rawset(lua_, instanceMeta);
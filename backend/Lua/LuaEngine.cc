@@ -16,7 +16,12 @@
  */
 
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include "../../src/Engine.hpp"
@@ -25,6 +30,7 @@
 #include "../../src/Utils.h"
 #include "LuaByteBufferImpl.h"
 #include "LuaHelper.hpp"
+#include "LuaPromise.h"
 #include "LuaReference.hpp"
 #include "LuaScope.hpp"
 
@@ -41,6 +47,51 @@ lua_State* newCommonLua() {
   return lua;
 }
 
+// lua_Alloc on top of utils::Allocator, ud is the allocator
+void* allocatorAdapter(void* ud, void* ptr, size_t osize, size_t nsize) {
+  auto allocator = static_cast<utils::Allocator*>(ud);
+  if (nsize == 0) {
+    if (ptr) {
+      allocator->deallocate(ptr, osize);
+    }
+    return nullptr;
+  }
+  // osize is the type of the new object when ptr is null (since Lua 5.2)
+  return ptr ? allocator->reallocate(ptr, osize, nsize) : allocator->allocate(nsize);
+}
+
+lua_State* newLuaWithAllocator(utils::Allocator* allocator) {
+  // LuaJIT on x64 without GC64 refuses custom allocators and returns nullptr
+  auto lua = lua_newstate(&allocatorAdapter, allocator);
+  if (!lua) {
+    throw std::logic_error("LuaEngine: can't create lua_State with a custom allocator");
+  }
+  luaL_openlibs(lua);
+  return lua;
+}
+
+// coroutine.wrap of the standard library resumes through C and would bypass resumeCoroutine
+constexpr auto kCoroutineSource = R"lua(
+local coroutine, resume = ...
+local create, error = coroutine.create, error
+
+coroutine.resume = resume
+
+local function unwrap(ok, ...)
+  if not ok then
+    error((...), 0)
+  end
+  return ...
+end
+
+coroutine.wrap = function(f)
+  local co = create(f)
+  return function(...)
+    return unwrap(resume(co, ...))
+  end
+end
+)lua";
+
 }  // namespace
 
 const void* const LuaEngine::kLuaTableNativeThisPtrToken_ =
@@ -69,22 +120,37 @@ const void* const LuaEngine::kLuaWeakRegistryToken_ =
 
 LuaEngine::LuaEngine(std::shared_ptr<::script::utils::MessageQueue> queue,
                      const std::function<lua_State*()>& luaStateFactory,
-                     std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate)
+                     std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate,
+                     std::shared_ptr<utils::Allocator> allocator)
     : messageQueue_(queue ? std::move(queue) : std::make_shared<utils::MessageQueue>()),
       byteBufferDelegate_(byteBufferDelegate ? std::move(byteBufferDelegate)
-                                             : std::make_unique<LuaByteBufferImpl>()) {
+                                             : std::make_unique<LuaByteBufferImpl>()),
+      allocator_(std::move(allocator)) {
+  if (luaStateFactory && allocator_) {
+    throw std::logic_error("LuaEngine: allocator can't be used with a luaStateFactory");
+  }
   if (luaStateFactory) {
     lua_ = luaStateFactory();
     assert(lua_);
+  } else if (allocator_) {
+    lua_ = newLuaWithAllocator(allocator_.get());
   } else {
     lua_ = newCommonLua();
   }
 
+  baseAllocator_ = lua_getallocf(lua_, &baseAllocatorData_);
+  heapUsage_ = static_cast<size_t>(lua_gc(lua_, LUA_GCCOUNT, 0)) * 1024 +
+               static_cast<size_t>(lua_gc(lua_, LUA_GCCOUNTB, 0));
+  lua_setallocf(lua_, &LuaEngine::allocate, this);
+  runningThread_ = lua_;
+
   {
     EngineScope engineScope(this);
     initGlobalRegistry();
     byteBufferDelegate_->init(this);
     registerNativeClass(builtInFunctions());
+    initCoroutine();
+    promise_ = std::make_unique<LuaPromise>(this);
   }
 }
 
@@ -97,6 +163,7 @@ void LuaEngine::destroy() {
     EngineScope scope(this);
     isDestroying_ = true;
     nativeDefineRegistry_.clear();
+    promise_.reset();
 
     globalWeakBookkeeping_.clear();
   }
@@ -139,6 +206,29 @@ void LuaEngine::initGlobalRegistry() {
   });
 }
 
+void LuaEngine::initCoroutine() {
+  luaStackScope(lua_, [this]() {
+    luaEnsureStack(lua_, 4);
+    lua_getglobal(lua_, "coroutine");
+    if (!lua_istable(lua_, -1)) {
+      // a luaStateFactory may leave the coroutine library out
+      return;
+    }
+    auto coroutine = lua_gettop(lua_);
+
+    if (luaL_loadbuffer(lua_, kCoroutineSource, std::strlen(kCoroutineSource),
+                        "=ScriptX.coroutine") != LUA_OK) {
+      rethrowException(lua_);
+    }
+    lua_pushvalue(lua_, coroutine);
+    lua_getfield(lua_, coroutine, "resume");
+    lua_pushcclosure(lua_, &LuaEngine::resumeCoroutine, 1);
+    if (lua_pcall(lua_, 2, 0, 0) != LUA_OK) {
+      rethrowException(lua_);
+    }
+  });
+}
+
 size_t LuaEngine::putGlobalOrWeakTable(const Local<Value>& localReference,
                                        const void* registryToken) {
   size_t id = 0;
@@ -253,14 +343,145 @@ Local<Value> LuaEngine::eval(const Local<String>& script, const Local<Value>& so
   if (sourceFileName.empty()) {
     sourceFileName = "unknown.lua";
   }
+  if (codeCache_) {
+    loadWithCodeCache(sourceStringHolder, sourceFileName);
+  } else if (luaL_loadbuffer(lua_, sourceStringHolder.c_str(), sourceStringHolder.length(),
+                             sourceFileName.c_str()) != LUA_OK) {
+    lua_backend::rethrowException(lua_);
+  }
+
+  return lua_backend::callFunction({}, {}, 0, nullptr);
+}
+
+std::string LuaEngine::codeCacheKey(std::string_view source, const std::string& chunkName) {
+  // binary chunk contains the chunk name
+  return utils::CodeCache::hashKey(source, std::string(LUA_RELEASE ":") + chunkName);
+}
+
+void LuaEngine::loadWithCodeCache(std::string_view source, const std::string& chunkName) {
+  auto key = codeCacheKey(source, chunkName);
+
+  std::string chunk;
+  if (codeCache_->load(key, chunk)) {
+    if (luaL_loadbufferx(lua_, chunk.data(), chunk.size(), chunkName.c_str(), "b") == LUA_OK) {
+      codeCache_->recordHit();
+      return;
+    }
+    // error message, "bad binary format", "version mismatch", etc.
+    lua_pop(lua_, 1);
+    codeCache_->recordRejected();
+    codeCache_->remove(key);
+  } else {
+    codeCache_->recordMiss();
+  }
+
+  if (luaL_loadbuffer(lua_, source.data(), source.length(), chunkName.c_str()) != LUA_OK) {
+    lua_backend::rethrowException(lua_);
+  }
+
+  chunk = dumpChunk(false);
+  if (!chunk.empty()) {
+    codeCache_->store(key, chunk);
+    codeCache_->recordProduced();
+  }
+}
+
+std::string LuaEngine::dumpChunk(bool strip) {
+  std::string chunk;
+  auto writer = [](lua_State*, const void* p, size_t size, void* ud) -> int {
+    static_cast<std::string*>(ud)->append(static_cast<const char*>(p), size);
+    return 0;
+  };
+#if LUA_VERSION_NUM >= 503
+  lua_dump(lua_, writer, &chunk, strip ? 1 : 0);
+#else
+  SCRIPTX_UNUSED(strip);
+  lua_dump(lua_, writer, &chunk);
+#endif
+  return chunk;
+}
+
+Local<ByteBuffer> LuaEngine::compileChunk(const Local<String>& script,
+                                          const Local<Value>& sourceFile, bool strip) {
+  Tracer trace(this, "LuaEngine::compileChunk");
+  auto sourceStringHolder = script.toString();
+  std::string sourceFileName;
+  if (sourceFile.isString()) {
+    sourceFileName = sourceFile.asString().toString();
+  }
+  if (sourceFileName.empty()) {
+    sourceFileName = "unknown.lua";
+  }
   if (luaL_loadbuffer(lua_, sourceStringHolder.c_str(), sourceStringHolder.length(),
                       sourceFileName.c_str()) != LUA_OK) {
     lua_backend::rethrowException(lua_);
   }
 
+  auto chunk = dumpChunk(strip);
+  lua_pop(lua_, 1);
+  return ByteBuffer::newByteBuffer(chunk.data(), chunk.size());
+}
+
+Local<Value> LuaEngine::evalChunk(const Local<ByteBuffer>& chunk, const Local<Value>& sourceFile) {
+  Tracer trace(this, "LuaEngine::evalChunk");
+  std::string sourceFileName;
+  if (sourceFile.isString()) {
+    sourceFileName = sourceFile.asString().toString();
+  }
+  if (sourceFileName.empty()) {
+    sourceFileName = "unknown.lua";
+  }
+  if (luaL_loadbufferx(lua_, static_cast<const char*>(chunk.getRawBytes()), chunk.byteLength(),
+                       sourceFileName.c_str(), "b") != LUA_OK) {
+    lua_backend::rethrowException(lua_);
+  }
+
   return lua_backend::callFunction({}, {}, 0, nullptr);
 }
 
+void LuaEngine::setCodeCache(std::shared_ptr<utils::CodeCache> codeCache) {
+  codeCache_ = std::move(codeCache);
+}
+
+std::shared_ptr<utils::CodeCache> LuaEngine::getCodeCache() const { return codeCache_; }
+
+size_t LuaEngine::precompileDirectory(const std::string& directory, utils::CodeCache& cache,
+                                      const std::string& extension) {
+  namespace fs = std::filesystem;
+  EngineScope scope(this);
+
+  size_t count = 0;
+  std::error_code ec;
+  auto root = fs::path(directory);
+  for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+    if (!it->is_regular_file() || it->path().extension() != extension) {
+      continue;
+    }
+
+    std::ifstream file(it->path(), std::ios::binary);
+    if (!file) {
+      throw Exception("can't read file: " + it->path().string());
+    }
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    auto chunkName = it->path().lexically_relative(root).generic_string();
+    if (luaL_loadbuffer(lua_, source.data(), source.size(), chunkName.c_str()) != LUA_OK) {
+      lua_backend::rethrowException(lua_);
+    }
+    auto chunk = dumpChunk(false);
+    lua_pop(lua_, 1);
+
+    cache.store(codeCacheKey(source, chunkName), chunk);
+    cache.recordProduced();
+    count++;
+  }
+
+  if (ec) {
+    throw Exception("can't iterate directory: " + directory + ", " + ec.message());
+  }
+  return count;
+}
+
 Arguments LuaEngine::makeArguments(LuaEngine* engine, int stackBase, size_t paramCount,
                                    bool isInstanceFunc) {
   lua_backend::ArgumentsData argumentsData{engine, stackBase, paramCount, isInstanceFunc};
@@ -583,7 +804,137 @@ size_t LuaEngine::getHeapSize() {
   return lua_gc(lua_, LUA_GCCOUNT, 0) * 1024;  // NOLINT
 }
 
-void LuaEngine::adjustAssociatedMemory(int64_t count) {}
+void LuaEngine::adjustAssociatedMemory(int64_t count) {
+  if (isDestroying()) return;
+  EngineScope scope(this);
+  if (count <= 0) {
+    // the collector can't be paid back, just cancel what is not paid yet
+    associatedMemoryDebt_ = std::max<int64_t>(associatedMemoryDebt_ + count, 0);
+    return;
+  }
+
+  associatedMemoryDebt_ += count;
+  if (associatedMemoryDebt_ >= kAssociatedMemoryStepSize) {
+    // as much GC work as if Lua had allocated the memory itself
+    lua_gc(lua_, LUA_GCSTEP, static_cast<int>(associatedMemoryDebt_ / 1024));
+    associatedMemoryDebt_ %= 1024;
+  }
+}
+
+bool LuaEngine::performIdleGc(std::chrono::steady_clock::time_point deadline) {
+  // don't start a new cycle until the heap grew, otherwise we'd collect an idle heap forever
+  if (idleGcHeapSize_ != 0 && getHeapSize() <= idleGcHeapSize_ + idleGcHeapSize_ / 10) {
+    return false;
+  }
+  do {
+    // a basic step, returns 1 when a cycle finished
+    if (lua_gc(lua_, LUA_GCSTEP, 0)) {
+      idleGcHeapSize_ = getHeapSize();
+      idleGcCycles_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  } while (std::chrono::steady_clock::now() < deadline);
+  return true;
+}
+
+void* LuaEngine::allocate(void* data, void* ptr, size_t osize, size_t nsize) {
+  auto engine = static_cast<LuaEngine*>(data);
+  // osize is the type of the new object when ptr is null (since Lua 5.2)
+  auto oldSize = ptr ? osize : 0;
+  auto hardLimit = engine->heapLimit_.hardLimit;
+  if (hardLimit != 0 && nsize > oldSize && engine->heapUsage_ + (nsize - oldSize) > hardLimit) {
+    engine->notifyHeapLimitReached(engine->heapUsage_);
+    // lua raises "not enough memory" (after an emergency gc since Lua 5.4)
+    return nullptr;
+  }
+
+  auto ret = engine->baseAllocator_(engine->baseAllocatorData_, ptr, osize, nsize);
+  if (ret || nsize == 0) {
+    auto usage = engine->heapUsage_ > oldSize ? engine->heapUsage_ - oldSize : 0;
+    engine->heapUsage_ = usage + nsize;
+    engine->updateHeapUsage(engine->heapUsage_);
+  }
+  return ret;
+}
+
+void LuaEngine::requestInterrupt() {
+  lua_sethook(lua_, &LuaEngine::interruptHook, LUA_MASKCOUNT, 1);
+  auto running = runningThread_.load();
+  if (running != lua_) {
+    lua_sethook(running, &LuaEngine::interruptHook, LUA_MASKCOUNT, 1);
+  }
+}
+
+void LuaEngine::beginExecution(bool timeoutEnabled) {
+  runningThread_ = lua_;
+  if (timeoutEnabled) {
+    // coroutines created during the execution inherit the hook
+    lua_sethook(lua_, &LuaEngine::interruptHook, LUA_MASKCOUNT, kInterruptCheckInstructions);
+  } else {
+    endExecution();
+  }
+}
+
+void LuaEngine::endExecution() {
+  runningThread_ = lua_;
+  // leave hooks set by script (debug.sethook) alone
+  if (lua_gethook(lua_) == &LuaEngine::interruptHook) {
+    lua_sethook(lua_, nullptr, 0, 0);
+  }
+}
+
+void LuaEngine::interruptHook(lua_State* lua, lua_Debug* /*debug*/) {
+  if (!lua_backend::currentEngine()->getInterruptReason()) {
+    return;
+  }
+  // fire again on the next instruction, in case script catches the error with pcall
+  lua_sethook(lua, &LuaEngine::interruptHook, LUA_MASKCOUNT, 1);
+  luaL_error(lua, "script execution terminated");
+}
+
+int LuaEngine::resumeCoroutine(lua_State* lua) {
+  auto engine = static_cast<LuaEngine*>(lua_backend::currentEngine());
+  auto co = lua_tothread(lua, 1);
+  if (co && co != lua) {
+    if (lua_gethook(lua) == &LuaEngine::interruptHook) {
+      auto count = engine->getInterruptReason() ? 1 : lua_gethookcount(lua);
+      lua_sethook(co, &LuaEngine::interruptHook, LUA_MASKCOUNT, count);
+    } else if (lua_gethook(co) == &LuaEngine::interruptHook) {
+      // left by an execution which ended while the coroutine was suspended
+      lua_sethook(co, nullptr, 0, 0);
+    }
+  }
+
+  luaEnsureStack(lua, 1);
+  lua_pushvalue(lua, lua_upvalueindex(1));
+  lua_insert(lua, 1);
+  auto caller = engine->runningThread_.exchange(co ? co : lua);
+  // protected, runningThread_ must not keep pointing to a coroutine that may be collected
+  auto status = lua_pcall(lua, lua_gettop(lua) - 1, LUA_MULTRET, 0);
+  engine->runningThread_ = caller;
+  if (status != LUA_OK) {
+    lua_error(lua);
+  }
+
+  if (engine->getInterruptReason()) {
+    // requestInterrupt only reached the innermost coroutine
+    lua_sethook(lua, &LuaEngine::interruptHook, LUA_MASKCOUNT, 1);
+  }
+  return lua_gettop(lua);
+}
+
+void LuaEngine::setMicrotaskPolicy(const MicrotaskPolicy& policy) {
+  ScriptEngine::setMicrotaskPolicy(policy);
+  if (promise_) {
+    // pick up jobs queued in explicit mode
+    promise_->scheduleJobs();
+  }
+}
+
+bool LuaEngine::performMicrotaskCheckpoint() {
+  EngineScope scope(this);
+  return promise_ && promise_->runJobs();
+}
 
 ScriptLanguage LuaEngine::getLanguageType() { return ScriptLanguage::kLua; }
 
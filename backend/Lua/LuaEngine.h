@@ -16,10 +16,13 @@
  */
 
 #pragma once
+#include <atomic>
 #include <unordered_map>
 #include "../../src/Engine.h"
 #include "../../src/Exception.h"
 #include "../../src/Native.h"
+#include "../../src/utils/Allocator.h"
+#include "../../src/utils/CodeCache.h"
 #include "../../src/utils/GlobalWeakBookkeeping.hpp"
 #include "../../src/utils/MessageQueue.h"
 #include "LuaHelper.h"
@@ -27,6 +30,7 @@
 namespace script::lua_backend {
 
 class LuaByteBufferDelegate;
+class LuaPromise;
 
 class LuaEngine : public ScriptEngine {
  private:
@@ -50,17 +54,37 @@ class LuaEngine : public ScriptEngine {
   std::unordered_map<const internal::ClassDefineState*, Global<Object>> nativeDefineRegistry_;
   ::script::internal::GlobalWeakBookkeeping globalWeakBookkeeping_;
   std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate_;
+  std::shared_ptr<utils::CodeCache> codeCache_;
+  std::unique_ptr<LuaPromise> promise_;
 
   size_t globalRefCount_ = 0;
   size_t weakRefCount_ = 0;
   bool isDestroying_ = false;
+  // heap size when the last idle GC cycle finished
+  size_t idleGcHeapSize_ = 0;
+  // associated memory not paid with GC work yet, see adjustAssociatedMemory
+  int64_t associatedMemoryDebt_ = 0;
 
+  // must outlive lua_
+  std::shared_ptr<utils::Allocator> allocator_;
   lua_State* lua_ = nullptr;
+  // thread (lua_ or a coroutine) executing script, where requestInterrupt installs the hook
+  std::atomic<lua_State*> runningThread_{nullptr};
+
+  // the original allocator of lua_, wrapped by allocate for HeapLimit
+  lua_Alloc baseAllocator_ = nullptr;
+  void* baseAllocatorData_ = nullptr;
+  size_t heapUsage_ = 0;
 
  public:
+  /**
+   * @param allocator memory allocator of the lua_State, can't be used together with
+   * luaStateFactory. empty means the default one of luaL_newstate.
+   */
   explicit LuaEngine(std::shared_ptr<::script::utils::MessageQueue> queue = {},
                      const std::function<lua_State*()>& luaStateFactory = {},
-                     std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate = {});
+                     std::unique_ptr<LuaByteBufferDelegate> byteBufferDelegate = {},
+                     std::shared_ptr<utils::Allocator> allocator = {});
 
   SCRIPTX_DISALLOW_COPY_AND_MOVE(LuaEngine);
 
@@ -78,14 +102,80 @@ class LuaEngine : public ScriptEngine {
   Local<Value> eval(const Local<String>& script) override;
   using ScriptEngine::eval;
 
+  /**
+   * Compile script into a Lua binary chunk (see lua_dump), without running it.
+   *
+   * @param script the script
+   * @param sourceFile the chunk name, used in error messages. Can be null.
+   * @param strip strip debug information to get a smaller chunk (Lua 5.3+),
+   * error messages will lose line info.
+   * @return the binary chunk
+   */
+  Local<ByteBuffer> compileChunk(const Local<String>& script, const Local<Value>& sourceFile = {},
+                                 bool strip = false);
+
+  /**
+   * Run a binary chunk produced by compileChunk (or luac of the SAME lua version).
+   * Text chunks are not accepted.
+   *
+   * NOTE: Lua trusts the binary chunk, DO NOT run chunks from untrusted source.
+   * @return the result of the chunk
+   */
+  Local<Value> evalChunk(const Local<ByteBuffer>& chunk, const Local<Value>& sourceFile = {});
+
+  /**
+   * Enable binary chunk cache for eval. (disabled by default)
+   *
+   * When enabled, eval looks up the cache by the hash of script source (and Lua version, source
+   * file name), and loads the cached binary chunk if any, which skips parsing.
+   * Otherwise the script is compiled and the binary chunk is written back to the cache.
+   *
+   * Use utils::TieredCodeCache to combine an in-memory and an on-disk cache.
+   * see CodeCache::getStatistics for hit/miss/rejected counters.
+   *
+   * @param codeCache the cache to use, can be shared by multiple engines. null to disable.
+   */
+  void setCodeCache(std::shared_ptr<utils::CodeCache> codeCache);
+
+  std::shared_ptr<utils::CodeCache> getCodeCache() const;
+
+  /**
+   * Precompile all scripts under a directory (recursively) into the given cache,
+   * typically at build time, with a utils::DirectoryCodeCache.
+   *
+   * The source file name of each script is its path relative to the directory, with '/' as
+   * separator (eg: "lib/util.lua"). Later eval with the same source and source file name
+   * hits the cache.
+   *
+   * @param directory the script directory
+   * @param cache the output cache
+   * @param extension only files with this extension are compiled
+   * @return count of compiled scripts
+   * @throws Exception on IO error or syntax error
+   */
+  size_t precompileDirectory(const std::string& directory, utils::CodeCache& cache,
+                             const std::string& extension = ".lua");
+
   std::shared_ptr<utils::MessageQueue> messageQueue() override;
 
   void gc() override;
 
   size_t getHeapSize() override;
 
+  /**
+   * runs an incremental step (LUA_GCSTEP) sized to the associated memory allocated since the
+   * last step, once it reaches kAssociatedMemoryStepSize.
+   * native class instances report their instanceSize here.
+   */
   void adjustAssociatedMemory(int64_t count) override;
 
+  /**
+   * the policy applies to the jobs of the built-in Promise, see LuaPromise.
+   */
+  void setMicrotaskPolicy(const MicrotaskPolicy& policy) override;
+
+  bool performMicrotaskCheckpoint() override;
+
   ScriptLanguage getLanguageType() override;
 
   std::string getEngineVersion() override;
@@ -107,9 +197,63 @@ class LuaEngine : public ScriptEngine {
   void* performGetNativeInstance(const Local<Value>& value,
                                  const internal::ClassDefineState* classDefine) override;
 
+  /**
+   * install interruptHook to fire on the next instruction, like lua.c does in its signal handler.
+   * hooks are per thread, so it goes to both lua_ and the coroutine currently running;
+   * coroutine.resume carries it further to coroutines resumed afterwards.
+   */
+  void requestInterrupt() override;
+
+  void beginExecution(bool timeoutEnabled) override;
+
+  void endExecution() override;
+
+  bool performIdleGc(std::chrono::steady_clock::time_point deadline) override;
+
  private:
+  /**
+   * instructions between two checks of the timeout
+   */
+  static constexpr int kInterruptCheckInstructions = 1000;
+
+  /**
+   * associated memory to accumulate before a GC step, small instances don't step one by one.
+   */
+  static constexpr int64_t kAssociatedMemoryStepSize = 64 * 1024;
+
+  /**
+   * count hook raising an error while the execution is interrupted.
+   */
+  static void interruptHook(lua_State* lua, lua_Debug* debug);
+
+  /**
+   * replacement of coroutine.resume (the original is upvalue 1), syncs interruptHook from the
+   * resuming thread to the coroutine and drops a stale one left by an earlier execution.
+   */
+  static int resumeCoroutine(lua_State* lua);
+
+  void initCoroutine();
+
+  /**
+   * lua_Alloc wrapping baseAllocator_, does the accounting and refuses to grow beyond hardLimit.
+   */
+  static void* allocate(void* data, void* ptr, size_t osize, size_t nsize);
+
   void initGlobalRegistry();
 
+  static std::string codeCacheKey(std::string_view source, const std::string& chunkName);
+
+  /**
+   * load script, with code cache
+   * [0, +1, -]
+   */
+  void loadWithCodeCache(std::string_view source, const std::string& chunkName);
+
+  /**
+   * dump the function on stack top into binary chunk
+   */
+  std::string dumpChunk(bool strip);
+
   Local<Value> get(const char* key);
 
   void set(const char* key, const Local<Value>& value);
@@ -206,6 +350,8 @@ class LuaEngine : public ScriptEngine {
 
   friend class ::script::ByteBuffer;
 
+  friend class ::script::Promise;
+
   friend class ::script::ScriptEngine;
 
   friend class ::script::Exception;
@@ -222,6 +368,8 @@ class LuaEngine : public ScriptEngine {
 
   friend class LuaByteBufferImpl;
 
+  friend class LuaPromise;
+
   friend lua_State* currentLua();
 
   friend void pushValue(lua_State* lua, const Local<Value>& local);
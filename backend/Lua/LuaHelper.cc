@@ -51,6 +51,7 @@ int luaErrorMessageHandler(lua_State* L) {
 Local<Value> callFunction(const Local<Value>& func, const Local<Value>& thiz, size_t argsCount,
                           const Local<Value>* begin) {
   auto lua = currentLua();
+  internal::ExecutionScope executionScope(currentEngine());
 
   int base = lua_gettop(lua);
 
@@ -101,6 +101,10 @@ void pushValues(lua_State* lua, size_t count, It begin) {
 }
 
 inline void rethrowException(lua_State* lua) {
+  if (auto reason = currentEngine()->getInterruptReason()) {
+    lua_pop(lua, 1);
+    throw TerminationException(*reason);
+  }
   Exception exp(LuaEngine::make<Local<Value>>(lua_gettop(lua)));
   lua_pop(lua, 1);
   throw exp;  // NOLINT
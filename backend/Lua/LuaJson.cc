@@ -0,0 +1,635 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ScriptX/ScriptX.h>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "LuaHelper.hpp"
+
+namespace script::lua_backend {
+
+namespace {
+
+// deeper nesting is more likely a circular structure, also guards the c++ stack
+constexpr int kMaxJsonDepth = 1000;
+// registry table with weak keys, parsed arrays which contain null or are empty -> their length
+constexpr const char* kJsonArrayLengths = "ScriptX.JsonArrayLengths";
+
+// [0, +1, m]
+void pushArrayLengths(lua_State* lua) {
+  luaEnsureStack(lua, 3);
+  lua_getfield(lua, LUA_REGISTRYINDEX, kJsonArrayLengths);
+  if (lua_istable(lua, -1)) {
+    return;
+  }
+  lua_pop(lua, 1);
+  lua_newtable(lua);
+  lua_newtable(lua);
+  lua_pushstring(lua, "__mode");
+  lua_pushstring(lua, "k");
+  lua_rawset(lua, -3);
+  lua_setmetatable(lua, -2);
+  lua_pushvalue(lua, -1);
+  lua_setfield(lua, LUA_REGISTRYINDEX, kJsonArrayLengths);
+}
+
+class JsonParser {
+  lua_State* lua_;
+  const char* begin_;
+  const char* cur_;
+  const char* end_;
+  int depth_ = 0;
+  // reused for strings with escapes and numbers
+  std::string buffer_;
+
+ public:
+  JsonParser(lua_State* lua, std::string_view json)
+      : lua_(lua), begin_(json.data()), cur_(json.data()), end_(json.data() + json.size()) {}
+
+  // [0, +1, e]
+  void parse() {
+    luaEnsureStack(lua_, 1);
+    parseValue();
+    skipSpace();
+    if (cur_ != end_) {
+      fail("unexpected character");
+    }
+  }
+
+ private:
+  [[noreturn]] void fail(const char* message) const {
+    throw Exception(std::string("invalid json, ") + message + " at position " +
+                    std::to_string(cur_ - begin_));
+  }
+
+  static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+  void skipSpace() {
+    while (cur_ != end_ && (*cur_ == ' ' || *cur_ == '\n' || *cur_ == '\r' || *cur_ == '\t')) {
+      ++cur_;
+    }
+  }
+
+  bool consume(char c) {
+    if (cur_ != end_ && *cur_ == c) {
+      ++cur_;
+      return true;
+    }
+    return false;
+  }
+
+  void skipDigits() {
+    while (cur_ != end_ && isDigit(*cur_)) {
+      ++cur_;
+    }
+  }
+
+  void expectLiteral(std::string_view literal) {
+    if (static_cast<size_t>(end_ - cur_) < literal.size() ||
+        std::string_view(cur_, literal.size()) != literal) {
+      fail("unexpected character");
+    }
+    cur_ += literal.size();
+  }
+
+  void enterNested() {
+    if (++depth_ > kMaxJsonDepth) {
+      fail("nesting too deep");
+    }
+    // table, key, value, nested values check again
+    luaEnsureStack(lua_, 3);
+  }
+
+  void parseValue() {
+    skipSpace();
+    if (cur_ == end_) {
+      fail("unexpected end");
+    }
+    switch (*cur_) {
+      case '{':
+        parseObject();
+        break;
+      case '[':
+        parseArray();
+        break;
+      case '"':
+        parseString();
+        break;
+      case 't':
+        expectLiteral("true");
+        lua_pushboolean(lua_, 1);
+        break;
+      case 'f':
+        expectLiteral("false");
+        lua_pushboolean(lua_, 0);
+        break;
+      case 'n':
+        expectLiteral("null");
+        lua_pushnil(lua_);
+        break;
+      default:
+        parseNumber();
+        break;
+    }
+  }
+
+  void parseObject() {
+    enterNested();
+    ++cur_;
+    lua_newtable(lua_);
+    skipSpace();
+    if (!consume('}')) {
+      while (true) {
+        skipSpace();
+        if (cur_ == end_ || *cur_ != '"') {
+          fail("expect property name");
+        }
+        parseString();
+        skipSpace();
+        if (!consume(':')) {
+          fail("expect ':'");
+        }
+        parseValue();
+        // null values are dropped, same as assigning nil in lua
+        lua_rawset(lua_, -3);
+
+        skipSpace();
+        if (consume(',')) continue;
+        if (consume('}')) break;
+        fail("expect ',' or '}'");
+      }
+    }
+    --depth_;
+  }
+
+  void parseArray() {
+    enterNested();
+    ++cur_;
+    lua_newtable(lua_);
+    skipSpace();
+    lua_Integer index = 0;
+    bool hasNull = false;
+    if (!consume(']')) {
+      while (true) {
+        parseValue();
+        if (lua_isnil(lua_, -1)) hasNull = true;
+        lua_rawseti(lua_, -2, ++index);
+
+        skipSpace();
+        if (consume(',')) continue;
+        if (consume(']')) break;
+        fail("expect ',' or ']'");
+      }
+    }
+    if (hasNull || index == 0) {
+      // null leaves a hole, and an empty table reads as an object. record the length for the
+      // writer aside, the table itself stays as plain as the input.
+      pushArrayLengths(lua_);
+      lua_pushvalue(lua_, -2);
+      lua_pushinteger(lua_, index);
+      lua_rawset(lua_, -3);
+      lua_pop(lua_, 1);
+    }
+    --depth_;
+  }
+
+  void parseString() {
+    ++cur_;
+    auto begin = cur_;
+    while (cur_ != end_ && *cur_ != '"' && *cur_ != '\\' &&
+           static_cast<unsigned char>(*cur_) >= 0x20) {
+      ++cur_;
+    }
+    if (cur_ != end_ && *cur_ == '"') {
+      // no escapes, push directly from the source
+      lua_pushlstring(lua_, begin, static_cast<size_t>(cur_ - begin));
+      ++cur_;
+      return;
+    }
+
+    buffer_.assign(begin, cur_);
+    while (true) {
+      if (cur_ == end_) {
+        fail("unterminated string");
+      }
+      auto c = *cur_++;
+      if (c == '"') {
+        break;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        --cur_;
+        fail("control character in string");
+      }
+      if (c != '\\') {
+        buffer_.push_back(c);
+        continue;
+      }
+      if (cur_ == end_) {
+        fail("unterminated string");
+      }
+      switch (*cur_++) {
+        case '"':
+          buffer_.push_back('"');
+          break;
+        case '\\':
+          buffer_.push_back('\\');
+          break;
+        case '/':
+          buffer_.push_back('/');
+          break;
+        case 'b':
+          buffer_.push_back('\b');
+          break;
+        case 'f':
+          buffer_.push_back('\f');
+          break;
+        case 'n':
+          buffer_.push_back('\n');
+          break;
+        case 'r':
+          buffer_.push_back('\r');
+          break;
+        case 't':
+          buffer_.push_back('\t');
+          break;
+        case 'u':
+          parseUnicodeEscape();
+          break;
+        default:
+          --cur_;
+          fail("invalid escape");
+      }
+    }
+    lua_pushlstring(lua_, buffer_.data(), buffer_.size());
+  }
+
+  uint32_t parseHex4() {
+    if (end_ - cur_ < 4) {
+      fail("invalid unicode escape");
+    }
+    uint32_t code = 0;
+    for (int i = 0; i < 4; ++i) {
+      auto c = *cur_++;
+      code <<= 4;
+      if (c >= '0' && c <= '9') {
+        code |= static_cast<uint32_t>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        code |= static_cast<uint32_t>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+        code |= static_cast<uint32_t>(c - 'A' + 10);
+      } else {
+        --cur_;
+        fail("invalid unicode escape");
+      }
+    }
+    return code;
+  }
+
+  void parseUnicodeEscape() {
+    auto code = parseHex4();
+    if (code >= 0xD800 && code <= 0xDBFF) {
+      if (end_ - cur_ >= 6 && cur_[0] == '\\' && cur_[1] == 'u') {
+        auto save = cur_;
+        cur_ += 2;
+        auto low = parseHex4();
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        } else {
+          // parse the second escape on its own
+          cur_ = save;
+          code = 0xFFFD;
+        }
+      } else {
+        code = 0xFFFD;
+      }
+    } else if (code >= 0xDC00 && code <= 0xDFFF) {
+      // lone surrogates can't be encoded in utf8
+      code = 0xFFFD;
+    }
+
+    if (code < 0x80) {
+      buffer_.push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      buffer_.push_back(static_cast<char>(0xC0 | (code >> 6)));
+      buffer_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      buffer_.push_back(static_cast<char>(0xE0 | (code >> 12)));
+      buffer_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      buffer_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+      buffer_.push_back(static_cast<char>(0xF0 | (code >> 18)));
+      buffer_.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+      buffer_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+      buffer_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+  }
+
+  void parseNumber() {
+    auto begin = cur_;
+    consume('-');
+    if (cur_ == end_ || !isDigit(*cur_)) {
+      fail("unexpected character");
+    }
+    if (!consume('0')) {
+      skipDigits();
+    }
+    if (consume('.')) {
+      if (cur_ == end_ || !isDigit(*cur_)) {
+        fail("invalid number");
+      }
+      skipDigits();
+    }
+    if (consume('e') || consume('E')) {
+      if (!consume('+')) {
+        consume('-');
+      }
+      if (cur_ == end_ || !isDigit(*cur_)) {
+        fail("invalid number");
+      }
+      skipDigits();
+    }
+
+    // the source is not null terminated
+    buffer_.assign(begin, cur_);
+#if LUA_VERSION_NUM >= 503
+    // integers stay integers, and the conversion is locale independent
+    if (lua_stringtonumber(lua_, buffer_.c_str()) == 0) {
+      fail("invalid number");
+    }
+#else
+    lua_pushnumber(lua_, std::strtod(buffer_.c_str(), nullptr));
+#endif
+  }
+};
+
+class JsonWriter {
+  lua_State* lua_;
+  std::string& out_;
+  int depth_ = 0;
+  // stack index of the kJsonArrayLengths table
+  int arrayLengths_;
+
+ public:
+  // [0, +1, m] leaves the kJsonArrayLengths table on the stack
+  JsonWriter(lua_State* lua, std::string& out) : lua_(lua), out_(out) {
+    pushArrayLengths(lua_);
+    arrayLengths_ = lua_gettop(lua_);
+  }
+
+  static bool isSerializable(int type) {
+    return type == LUA_TNIL || type == LUA_TBOOLEAN || type == LUA_TNUMBER ||
+           type == LUA_TSTRING || type == LUA_TTABLE;
+  }
+
+  /**
+   * @param index absolute stack index
+   * @return false if the value has no JSON representation, nothing is written.
+   */
+  bool write(int index) {
+    switch (lua_type(lua_, index)) {
+      case LUA_TNIL:
+        out_.append("null");
+        return true;
+      case LUA_TBOOLEAN:
+        out_.append(lua_toboolean(lua_, index) ? "true" : "false");
+        return true;
+      case LUA_TNUMBER:
+        writeNumber(index);
+        return true;
+      case LUA_TSTRING: {
+        size_t length = 0;
+        auto str = lua_tolstring(lua_, index, &length);
+        writeString(std::string_view(str, length));
+        return true;
+      }
+      case LUA_TTABLE:
+        writeTable(index);
+        return true;
+      default:
+        // functions, userdata, threads
+        return false;
+    }
+  }
+
+ private:
+  void writeNumber(int index) {
+    char buffer[32];
+#if LUA_VERSION_NUM >= 503
+    if (lua_isinteger(lua_, index)) {
+      auto ret = std::to_chars(buffer, buffer + sizeof(buffer),
+                               static_cast<long long>(lua_tointeger(lua_, index)));
+      out_.append(buffer, ret.ptr);
+      return;
+    }
+#endif
+    auto value = static_cast<double>(lua_tonumber(lua_, index));
+    if (!std::isfinite(value)) {
+      // same as JSON.stringify
+      out_.append("null");
+      return;
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+      // integral, print without fraction like JavaScript does
+      auto ret = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<long long>(value));
+      out_.append(buffer, ret.ptr);
+      return;
+    }
+
+    // the shortest of %.15g and %.17g that reads back the same value
+    auto length = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    if (std::strtod(buffer, nullptr) != value) {
+      length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    for (int i = 0; i < length; ++i) {
+      // the decimal separator depends on locale
+      if (buffer[i] == ',') buffer[i] = '.';
+    }
+    out_.append(buffer, static_cast<size_t>(length));
+  }
+
+  void writeString(std::string_view str) {
+    constexpr char kHex[] = "0123456789abcdef";
+    out_.push_back('"');
+    size_t run = 0;
+    for (size_t i = 0; i < str.size(); ++i) {
+      auto c = static_cast<unsigned char>(str[i]);
+      if (c >= 0x20 && c != '"' && c != '\\') {
+        continue;
+      }
+      out_.append(str.data() + run, i - run);
+      run = i + 1;
+      switch (c) {
+        case '"':
+          out_.append("\\\"");
+          break;
+        case '\\':
+          out_.append("\\\\");
+          break;
+        case '\b':
+          out_.append("\\b");
+          break;
+        case '\f':
+          out_.append("\\f");
+          break;
+        case '\n':
+          out_.append("\\n");
+          break;
+        case '\r':
+          out_.append("\\r");
+          break;
+        case '\t':
+          out_.append("\\t");
+          break;
+        default:
+          out_.append("\\u00");
+          out_.push_back(kHex[c >> 4]);
+          out_.push_back(kHex[c & 0xF]);
+          break;
+      }
+    }
+    out_.append(str.data() + run, str.size() - run);
+    out_.push_back('"');
+  }
+
+  /**
+   * a table is an array if its keys are exactly 1..n.
+   * empty tables are objects.
+   * arrays from the parser with holes or no elements have their length in kJsonArrayLengths,
+   * holes are written as null.
+   */
+  bool isArray(int index, size_t& length) {
+    lua_pushvalue(lua_, index);
+    lua_rawget(lua_, arrayLengths_);
+    bool packed = lua_type(lua_, -1) == LUA_TNUMBER;
+    if (packed) {
+      // elements may have been appended since
+      length = std::max(length, static_cast<size_t>(lua_tointeger(lua_, -1)));
+    }
+    lua_pop(lua_, 1);
+    if (!packed && length == 0) {
+      return false;
+    }
+
+    size_t count = 0;
+    lua_pushnil(lua_);
+    while (lua_next(lua_, index)) {
+      lua_pop(lua_, 1);
+      if (lua_type(lua_, -1) != LUA_TNUMBER) {
+        lua_pop(lua_, 1);
+        return false;
+      }
+      auto key = lua_tonumber(lua_, -1);
+      if (key < 1 || key > static_cast<lua_Number>(length) || key != std::floor(key)) {
+        lua_pop(lua_, 1);
+        return false;
+      }
+      ++count;
+    }
+    return packed || count == length;
+  }
+
+  void writeTable(int index) {
+    if (++depth_ > kMaxJsonDepth) {
+      throw Exception("json stringify, nesting too deep, maybe a circular structure");
+    }
+    // key, value
+    luaEnsureStack(lua_, 2);
+
+    auto length = static_cast<size_t>(lua_rawlen(lua_, index));
+    if (isArray(index, length)) {
+      out_.push_back('[');
+      for (size_t i = 1; i <= length; ++i) {
+        if (i > 1) out_.push_back(',');
+        lua_rawgeti(lua_, index, static_cast<lua_Integer>(i));
+        if (!write(lua_gettop(lua_))) {
+          out_.append("null");
+        }
+        lua_pop(lua_, 1);
+      }
+      out_.push_back(']');
+    } else {
+      out_.push_back('{');
+      bool first = true;
+      lua_pushnil(lua_);
+      while (lua_next(lua_, index)) {
+        auto keyType = lua_type(lua_, -2);
+        if ((keyType == LUA_TSTRING || keyType == LUA_TNUMBER) &&
+            isSerializable(lua_type(lua_, -1))) {
+          if (!first) out_.push_back(',');
+          first = false;
+          if (keyType == LUA_TSTRING) {
+            size_t keyLength = 0;
+            auto key = lua_tolstring(lua_, -2, &keyLength);
+            writeString(std::string_view(key, keyLength));
+          } else {
+            // lua_tolstring would change the key in place and break lua_next
+            out_.push_back('"');
+            writeNumber(lua_gettop(lua_) - 1);
+            out_.push_back('"');
+          }
+          out_.push_back(':');
+          write(lua_gettop(lua_));
+        }
+        lua_pop(lua_, 1);
+      }
+      out_.push_back('}');
+    }
+    --depth_;
+  }
+};
+
+}  // namespace
+
+}  // namespace script::lua_backend
+
+namespace script {
+
+Local<Value> Json::parse(std::string_view json) {
+  auto lua = lua_backend::currentLua();
+  auto top = lua_gettop(lua);
+  try {
+    lua_backend::JsonParser(lua, json).parse();
+  } catch (...) {
+    lua_settop(lua, top);
+    throw;
+  }
+  return lua_interop::makeLocal<Value>(lua_gettop(lua));
+}
+
+std::string Json::stringify(const Local<Value>& value) {
+  auto lua = lua_backend::currentLua();
+  auto top = lua_gettop(lua);
+  std::string json;
+  lua_backend::pushValue(lua, value);
+  try {
+    if (!lua_backend::JsonWriter(lua, json).write(lua_gettop(lua))) {
+      json.clear();
+    }
+  } catch (...) {
+    lua_settop(lua, top);
+    throw;
+  }
+  lua_settop(lua, top);
+  return json;
+}
+
+}  // namespace script
@@ -17,6 +17,7 @@
 
 #include <ScriptX/ScriptX.h>
 #include "LuaHelper.hpp"
+#include "LuaPromise.h"
 
 namespace script {
 
@@ -110,6 +111,11 @@ REF_IMPL_BASIC_NOT_VALUE(ByteBuffer)
 REF_IMPL_BASIC_EQUALS(ByteBuffer)
 REF_IMPL_TO_VALUE(ByteBuffer)
 
+REF_IMPL_BASIC_FUNC(Promise)
+REF_IMPL_BASIC_NOT_VALUE(Promise)
+REF_IMPL_BASIC_EQUALS(Promise)
+REF_IMPL_TO_VALUE(Promise)
+
 REF_IMPL_BASIC_FUNC(Unsupported)
 REF_IMPL_BASIC_NOT_VALUE(Unsupported)
 REF_IMPL_BASIC_EQUALS(Unsupported)
@@ -183,6 +189,12 @@ bool Local<Value>::isByteBuffer() const {
   return engine->byteBufferDelegate_->isByteBuffer(engine, *this);
 }
 
+bool Local<Value>::isPromise() const {
+  auto engine = lua_backend::currentEngine();
+  // null while the engine is being destroyed
+  return engine->promise_ && engine->promise_->isPromise(*this);
+}
+
 bool Local<Value>::isObject() const {
   return val_ != 0 && lua_type(lua_backend::currentLua(), val_) == LUA_TTABLE;
 }
@@ -219,6 +231,11 @@ Local<ByteBuffer> Local<Value>::asByteBuffer() const {
   throw Exception("can't cast value as ByteBuffer");
 }
 
+Local<Promise> Local<Value>::asPromise() const {
+  if (isPromise()) return Local<Promise>{val_};
+  throw Exception("can't cast value as Promise");
+}
+
 Local<Object> Local<Value>::asObject() const {
   if (isObject()) return Local<Object>{val_};
   throw Exception("can't cast value as Object");
@@ -417,6 +434,24 @@ void Local<Array>::clear() const {
   }
 }
 
+void Local<Array>::forEachImpl(ForEachCallback callback, void* data) const {
+  auto lua = lua_backend::currentLua();
+  auto length = size();
+  // also when the callback throws
+  struct StackRestore {
+    lua_State* lua;
+    int top;
+    ~StackRestore() { lua_settop(lua, top); }
+  } restore{lua, lua_gettop(lua)};
+  lua_backend::luaEnsureStack(lua, 1);
+  for (size_t i = 0; i < length; ++i) {
+    lua_rawgeti(lua, val_, static_cast<lua_Integer>(i + 1));
+    callback(data, i, Local<Value>{lua_gettop(lua)});
+    // pop the element (and anything the callback pushed), so the stack won't grow with the array
+    lua_settop(lua, restore.top);
+  }
+}
+
 ByteBuffer::Type Local<ByteBuffer>::getType() const { return ByteBuffer::Type::kUnspecified; }
 
 size_t Local<ByteBuffer>::byteLength() const {
@@ -437,4 +472,38 @@ void Local<ByteBuffer>::commit() const {}
 
 void Local<ByteBuffer>::sync() const {}
 
+Promise::State Local<Promise>::getState() const {
+  return lua_backend::currentEngine()->promise_->getState(asValue());
+}
+
+Local<Value> Local<Promise>::getResult() const {
+  if (getState() == Promise::State::kPending) {
+    return {};
+  }
+  return lua_backend::currentEngine()->promise_->getResult(asValue());
+}
+
+Local<Promise> Local<Promise>::then(const Local<Value>& onFulfilled,
+                                    const Local<Value>& onRejected) const {
+  auto engine = lua_backend::currentEngine();
+  return engine->promise_->then(asValue(), onFulfilled, onRejected).asPromise();
+}
+
+// handle is {resolve, reject, promise}, see LuaPromise::newPromise
+void Promise::Resolver::resolve(const Local<Value>& value) const {
+  handle_.get().asArray().get(0).asFunction().call({}, value);
+}
+
+void Promise::Resolver::reject(const Local<Value>& reason) const {
+  handle_.get().asArray().get(1).asFunction().call({}, reason);
+}
+
+size_t internal::identityHash(const Local<Value>& value) {
+  auto index = lua_interop::toLua(value);
+  if (index == 0) {
+    return 0;
+  }
+  return reinterpret_cast<size_t>(lua_topointer(lua_backend::currentLua(), index));
+}
+
 }  // namespace script
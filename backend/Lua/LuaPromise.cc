@@ -0,0 +1,362 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LuaPromise.h"
+#include <ScriptX/ScriptX.h>
+#include <cstring>
+#include "LuaHelper.hpp"
+
+namespace script::lua_backend {
+
+namespace {
+
+// the chunk is called with a native `schedule` function, which is called
+// when the job queue becomes non-empty. it returns the module table used by c++.
+constexpr auto kPromiseSource = R"lua(
+local schedule = ...
+
+local PENDING, FULFILLED, REJECTED = 0, 1, 2
+
+local Promise = {}
+Promise.__index = Promise
+
+-- promise -> {state, value, reactions}, keeps the promise table itself clean
+local records = setmetatable({}, {__mode = "k"})
+
+local jobs, first, last, queued = {}, 1, 0, 0
+
+local function enqueue(reaction, state, value)
+  last = last + 1
+  queued = queued + 1
+  jobs[last] = {reaction, state, value}
+  if last == first then
+    schedule()
+  end
+end
+
+-- runs at most limit jobs, returns the number of jobs run, jobs left and jobs ever queued
+local function runJobs(limit)
+  local count = 0
+  while first <= last and count < limit do
+    local job = jobs[first]
+    jobs[first] = nil
+    first = first + 1
+    count = count + 1
+    job[1].run(job[1], job[2], job[3])
+  end
+  if first > last then
+    first, last = 1, 0
+  end
+  return count, last - first + 1, queued
+end
+
+local function newPromise()
+  local promise = setmetatable({}, Promise)
+  records[promise] = {state = PENDING, reactions = {}}
+  return promise
+end
+
+local function isPromise(value)
+  return value ~= nil and records[value] ~= nil
+end
+
+local function addReaction(promise, reaction)
+  local record = records[promise]
+  if record.state == PENDING then
+    record.reactions[#record.reactions + 1] = reaction
+  else
+    enqueue(reaction, record.state, record.value)
+  end
+end
+
+local function settle(promise, state, value)
+  local record = records[promise]
+  if record.state ~= PENDING then
+    return
+  end
+  local reactions = record.reactions
+  record.state, record.value, record.reactions = state, value, nil
+  for i = 1, #reactions do
+    enqueue(reactions[i], state, value)
+  end
+end
+
+local resolve
+
+-- reaction of promise:next(), the derived promise follows the handler's result
+local function runNext(reaction, state, value)
+  local handler = reaction[state]
+  if type(handler) == "function" then
+    local ok, result = pcall(handler, value)
+    state, value = ok and FULFILLED or REJECTED, result
+  end
+  if state == FULFILLED then
+    resolve(reaction.derived, value)
+  else
+    settle(reaction.derived, REJECTED, value)
+  end
+end
+
+function resolve(promise, value)
+  if value == promise then
+    settle(promise, REJECTED, "a promise can't be resolved with itself")
+  elseif isPromise(value) then
+    -- adopt the state of value
+    addReaction(value, {run = runNext, derived = promise})
+  else
+    settle(promise, FULFILLED, value)
+  end
+end
+
+local function resolvingFunctions(promise)
+  local done = false
+  return function(value)
+    if not done then
+      done = true
+      resolve(promise, value)
+    end
+  end, function(reason)
+    if not done then
+      done = true
+      settle(promise, REJECTED, reason)
+    end
+  end
+end
+
+local function checkPromise(value)
+  if not isPromise(value) then
+    error("not a Promise", 3)
+  end
+  return records[value]
+end
+
+function Promise.new(executor)
+  local promise = newPromise()
+  local resolveFunction, rejectFunction = resolvingFunctions(promise)
+  local ok, err = pcall(executor, resolveFunction, rejectFunction)
+  if not ok then
+    rejectFunction(err)
+  end
+  return promise
+end
+
+function Promise.resolve(value)
+  if isPromise(value) then
+    return value
+  end
+  local promise = newPromise()
+  settle(promise, FULFILLED, value)
+  return promise
+end
+
+function Promise.reject(reason)
+  local promise = newPromise()
+  settle(promise, REJECTED, reason)
+  return promise
+end
+
+-- `then` is a keyword in lua
+function Promise:next(onFulfilled, onRejected)
+  checkPromise(self)
+  local derived = newPromise()
+  addReaction(self, {onFulfilled, onRejected, run = runNext, derived = derived})
+  return derived
+end
+
+function Promise:catch(onRejected)
+  return self:next(nil, onRejected)
+end
+
+-- async/await on coroutines, await yields the token and the awaited promise
+local awaitToken = {}
+local asyncCoroutines = setmetatable({}, {__mode = "k"})
+
+local function runAwait(reaction, state, value)
+  reaction.step(coroutine.resume(reaction.co, state == FULFILLED, value))
+end
+
+function Promise.async(fn, ...)
+  local promise = newPromise()
+  local co = coroutine.create(fn)
+  asyncCoroutines[co] = true
+
+  local step
+  function step(ok, token, value)
+    if not ok then
+      settle(promise, REJECTED, token)
+    elseif coroutine.status(co) == "dead" then
+      resolve(promise, token)
+    elseif token == awaitToken then
+      addReaction(value, {run = runAwait, co = co, step = step})
+    else
+      settle(promise, REJECTED, "use Promise.await instead of coroutine.yield in Promise.async")
+    end
+  end
+
+  step(coroutine.resume(co, ...))
+  return promise
+end
+
+function Promise.await(value)
+  if not asyncCoroutines[coroutine.running()] then
+    error("Promise.await can only be called in Promise.async", 2)
+  end
+  local ok, result = coroutine.yield(awaitToken, Promise.resolve(value))
+  if not ok then
+    error(result, 0)
+  end
+  return result
+end
+
+setmetatable(Promise, {
+  __call = function(_, executor)
+    return Promise.new(executor)
+  end
+})
+
+return {
+  Promise = Promise,
+  runJobs = runJobs,
+  newPromise = function()
+    local promise = newPromise()
+    local resolveFunction, rejectFunction = resolvingFunctions(promise)
+    return {resolveFunction, rejectFunction, promise}
+  end,
+  state = function(promise)
+    return checkPromise(promise).state
+  end,
+  result = function(promise)
+    return checkPromise(promise).value
+  end,
+}
+)lua";
+
+}  // namespace
+
+LuaPromise::LuaPromise(LuaEngine* engine) : engine_(engine) {
+  auto lua = engine->lua_;
+  StackFrameScope stack;
+
+  luaEnsureStack(lua, 1);
+  if (luaL_loadbuffer(lua, kPromiseSource, std::strlen(kPromiseSource), "=ScriptX.Promise") !=
+      LUA_OK) {
+    rethrowException(lua);
+  }
+  auto chunk = lua_interop::makeLocal<Function>(lua_gettop(lua));
+
+  auto schedule = Function::newFunction([engine](const Arguments&) -> Local<Value> {
+    // the chunk may run after destroy() reset it
+    if (engine->promise_) {
+      engine->promise_->hasJobs_ = true;
+      engine->promise_->scheduleJobs();
+    }
+    return {};
+  });
+
+  auto module = chunk.call({}, schedule).asObject();
+  module_ = module;
+  class_ = module.get("Promise").asObject();
+  engine->set("Promise", class_.get());
+}
+
+bool LuaPromise::isPromise(const Local<Value>& value) const {
+  auto lua = engine_->lua_;
+  auto index = lua_interop::toLua(value);
+  if (index == 0 || lua_type(lua, index) != LUA_TTABLE) {
+    return false;
+  }
+
+  luaEnsureStack(lua, 2);
+  if (!lua_getmetatable(lua, index)) {
+    return false;
+  }
+  lua_backend::pushValue(lua, class_.get());
+  bool ret = lua_rawequal(lua, -1, -2);
+  lua_pop(lua, 2);
+  return ret;
+}
+
+Local<Array> LuaPromise::newPromise() const {
+  return module_.get().get("newPromise").asFunction().call().asArray();
+}
+
+Promise::State LuaPromise::getState(const Local<Value>& promise) const {
+  auto state = module_.get().get("state").asFunction().call({}, promise);
+  switch (state.asNumber().toInt32()) {
+    case 1:
+      return Promise::State::kFulfilled;
+    case 2:
+      return Promise::State::kRejected;
+    default:
+      return Promise::State::kPending;
+  }
+}
+
+Local<Value> LuaPromise::getResult(const Local<Value>& promise) const {
+  return module_.get().get("result").asFunction().call({}, promise);
+}
+
+Local<Value> LuaPromise::then(const Local<Value>& promise, const Local<Value>& onFulfilled,
+                              const Local<Value>& onRejected) const {
+  // Promise.next(promise, onFulfilled, onRejected)
+  auto next = class_.get().get("next").asFunction();
+  return next.call(promise, onFulfilled, onRejected);
+}
+
+void LuaPromise::scheduleJobs() {
+  auto explicitMode =
+      engine_->getMicrotaskPolicy().mode == LuaEngine::MicrotaskPolicy::Mode::kExplicit;
+  if (!hasJobs_ || explicitMode) {
+    return;
+  }
+  if (jobsScheduled_.exchange(true)) {
+    return;
+  }
+
+  utils::Message message(
+      [](auto& msg) {
+        auto engine = static_cast<LuaEngine*>(msg.ptr0);
+        EngineScope scope(engine);
+        auto& promise = engine->promise_;
+        if (promise) {
+          // clear first, so that jobs left by the budget can be scheduled again
+          promise->jobsScheduled_ = false;
+          promise->runJobs();
+        }
+      },
+      nullptr);
+  message.name = "PromiseJobs";
+  message.ptr0 = engine_;
+  message.tag = engine_;
+  engine_->messageQueue()->postMessage(message);
+}
+
+bool LuaPromise::runJobs() {
+  auto run = module_.get().get("runJobs").asFunction();
+  hasJobs_ = engine_->runMicrotasks([this, &run](size_t maxJobs, bool& hasMore) {
+    auto ret = run.call({}, Number::newNumber(static_cast<double>(maxJobs))).asArray();
+    hasMore = ret.get(1).asNumber().toInt64() > 0;
+    engine_->microtasksQueued_.store(static_cast<uint64_t>(ret.get(2).asNumber().toInt64()),
+                                     std::memory_order_relaxed);
+    return static_cast<size_t>(ret.get(0).asNumber().toInt64());
+  });
+  // left by the budget
+  scheduleJobs();
+  return hasJobs_;
+}
+
+}  // namespace script::lua_backend
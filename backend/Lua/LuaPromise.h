@@ -0,0 +1,75 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include "../../src/Reference.h"
+#include "LuaEngine.h"
+
+namespace script::lua_backend {
+
+/**
+ * Lua has no Promise, this is an emulation written in lua (see LuaPromise.cc),
+ * it is exposed as the global `Promise`, with coroutine based async/await.
+ *
+ * Jobs (reactions) are drained by a message posted to the engine's MessageQueue,
+ * just like microtasks in JavaScript engines, following the engine's MicrotaskPolicy.
+ */
+class LuaPromise {
+ public:
+  explicit LuaPromise(LuaEngine* engine);
+
+  LuaPromise(const LuaPromise&) = delete;
+  LuaPromise& operator=(const LuaPromise&) = delete;
+
+  ~LuaPromise() = default;
+
+  bool isPromise(const Local<Value>& value) const;
+
+  /**
+   * @return {resolve, reject, promise}
+   */
+  Local<Array> newPromise() const;
+
+  Promise::State getState(const Local<Value>& promise) const;
+
+  Local<Value> getResult(const Local<Value>& promise) const;
+
+  Local<Value> then(const Local<Value>& promise, const Local<Value>& onFulfilled,
+                    const Local<Value>& onRejected) const;
+
+  /**
+   * post a message to run the jobs, unless there is no job or the policy is kExplicit.
+   */
+  void scheduleJobs();
+
+  /**
+   * run jobs within the budget of the engine's MicrotaskPolicy.
+   * @return true if there are jobs left
+   */
+  bool runJobs();
+
+ private:
+  LuaEngine* engine_;
+  Global<Object> module_;
+  Global<Object> class_;
+  bool hasJobs_ = false;
+  std::atomic_bool jobsScheduled_ = false;
+};
+
+}  // namespace script::lua_backend
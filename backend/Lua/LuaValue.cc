@@ -18,6 +18,7 @@
 #include <ScriptX/ScriptX.h>
 
 #include "LuaHelper.hpp"
+#include "LuaPromise.h"
 
 namespace script {
 
@@ -73,6 +74,16 @@ Local<String> String::newString(const std::u8string& utf8) {
 
 #endif
 
+Local<String> String::newExternalString(std::shared_ptr<const std::string> utf8) {
+  if (!utf8) throw Exception("null pointer");
+  // lua strings are always interned into the lua heap, copy it
+  return newString(*utf8);
+}
+
+Local<String> String::newExternalStaticString(std::string_view staticUtf8) {
+  return newString(staticUtf8);
+}
+
 Local<Number> Number::newNumber(float value) { return newNumber(static_cast<double>(value)); }
 
 Local<Number> Number::newNumber(double value) {
@@ -152,13 +163,22 @@ Local<Array> Array::newArray(size_t size) {
 }
 
 Local<Array> Array::newArrayImpl(size_t size, const Local<Value>* args) {
+  auto lua = lua_backend::currentLua();
   auto ret = newArray(size);
+  // the new table is on the top, rawseti directly, add() would compute the length every time
+  auto table = lua_gettop(lua);
   for (size_t i = 0; i < size; ++i) {
-    ret.add(args[i]);
+    lua_backend::pushValue(lua, args[i]);
+    lua_rawseti(lua, table, static_cast<lua_Integer>(i + 1));
   }
   return ret;
 }
 
+Promise::Resolver Promise::newPromise() {
+  auto handle = lua_backend::currentEngine()->promise_->newPromise();
+  return Resolver(handle.get(2).asPromise(), handle);
+}
+
 Local<ByteBuffer> ByteBuffer::newByteBuffer(size_t size) {
   try {
     return newByteBuffer(
@@ -17,6 +17,20 @@
 
 #include "QjsEngine.h"
 #include <ScriptX/ScriptX.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define SCRIPTX_QJS_MALLOC_USABLE_SIZE(ptr) malloc_size(ptr)
+#elif defined(_WIN32)
+#include <malloc.h>
+#define SCRIPTX_QJS_MALLOC_USABLE_SIZE(ptr) _msize(ptr)
+#elif defined(__linux__) && !defined(__EMSCRIPTEN__)
+#include <malloc.h>
+#define SCRIPTX_QJS_MALLOC_USABLE_SIZE(ptr) malloc_usable_size(ptr)
+#endif
 
 namespace script::qjs_backend {
 
@@ -78,12 +92,167 @@ constexpr auto kGetByteBufferInfo = R"(
 })
 )";
 
-QjsEngine::QjsEngine(std::shared_ptr<utils::MessageQueue> queue, const QjsFactory& factory)
-    : queue_(queue ? std::move(queue) : std::make_shared<utils::MessageQueue>()) {
+// JSMallocFunctions doing the accounting for HeapLimit, like js_def_malloc of QuickJs.
+// s->opaque is the engine. kFunctions prefixes every block with its size, which the engine's
+// allocator needs back; kMallocFunctions counts malloc_usable_size like QuickJs does.
+struct QjsEngine::MallocFunctions {
+  static constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+  static utils::Allocator* allocatorOf(JSMallocState* s) {
+    return static_cast<QjsEngine*>(s->opaque)->allocator_.get();
+  }
+
+  static size_t& blockSize(void* block) { return *static_cast<size_t*>(block); }
+
+  static void* toPointer(void* block) { return static_cast<char*>(block) + kHeaderSize; }
+
+  static void* toBlock(void* ptr) { return static_cast<char*>(ptr) - kHeaderSize; }
+
+  static bool reserve(JSMallocState* s, size_t grow) {
+    if (s->malloc_size + grow > s->malloc_limit) {
+      static_cast<QjsEngine*>(s->opaque)->notifyHeapLimitReached(s->malloc_size);
+      return false;
+    }
+    return true;
+  }
+
+  static void* jsMalloc(JSMallocState* s, size_t size) {
+    if (!reserve(s, size + kHeaderSize)) {
+      return nullptr;
+    }
+    auto allocator = allocatorOf(s);
+    auto block =
+        allocator ? allocator->allocate(size + kHeaderSize) : std::malloc(size + kHeaderSize);
+    if (!block) {
+      return nullptr;
+    }
+    blockSize(block) = size;
+    s->malloc_count++;
+    s->malloc_size += size + kHeaderSize;
+    static_cast<QjsEngine*>(s->opaque)->updateHeapUsage(s->malloc_size);
+    return toPointer(block);
+  }
+
+  static void jsFree(JSMallocState* s, void* ptr) {
+    if (!ptr) {
+      return;
+    }
+    auto block = toBlock(ptr);
+    s->malloc_count--;
+    auto size = blockSize(block) + kHeaderSize;
+    s->malloc_size -= size;
+    if (auto allocator = allocatorOf(s)) {
+      allocator->deallocate(block, size);
+    } else {
+      std::free(block);
+    }
+    static_cast<QjsEngine*>(s->opaque)->updateHeapUsage(s->malloc_size);
+  }
+
+  static void* jsRealloc(JSMallocState* s, void* ptr, size_t size) {
+    if (!ptr) {
+      return size == 0 ? nullptr : jsMalloc(s, size);
+    }
+    if (size == 0) {
+      jsFree(s, ptr);
+      return nullptr;
+    }
+
+    auto block = toBlock(ptr);
+    auto oldSize = blockSize(block);
+    if (size > oldSize && !reserve(s, size - oldSize)) {
+      return nullptr;
+    }
+    auto allocator = allocatorOf(s);
+    block = allocator ? allocator->reallocate(block, oldSize + kHeaderSize, size + kHeaderSize)
+                      : std::realloc(block, size + kHeaderSize);
+    if (!block) {
+      return nullptr;
+    }
+    blockSize(block) = size;
+    s->malloc_size = s->malloc_size - oldSize + size;
+    static_cast<QjsEngine*>(s->opaque)->updateHeapUsage(s->malloc_size);
+    return toPointer(block);
+  }
+
+  static size_t jsMallocUsableSize(const void* ptr) {
+    return ptr ? blockSize(toBlock(const_cast<void*>(ptr))) : 0;
+  }
+
+  static constexpr JSMallocFunctions kFunctions = {jsMalloc, jsFree, jsRealloc,
+                                                   jsMallocUsableSize};
+
+#ifdef SCRIPTX_QJS_MALLOC_USABLE_SIZE
+  static size_t usableSize(const void* ptr) {
+    return SCRIPTX_QJS_MALLOC_USABLE_SIZE(const_cast<void*>(ptr));
+  }
+
+  static void* mallocMalloc(JSMallocState* s, size_t size) {
+    if (!reserve(s, size)) {
+      return nullptr;
+    }
+    auto ptr = std::malloc(size);
+    if (!ptr) {
+      return nullptr;
+    }
+    s->malloc_count++;
+    s->malloc_size += usableSize(ptr);
+    static_cast<QjsEngine*>(s->opaque)->updateHeapUsage(s->malloc_size);
+    return ptr;
+  }
+
+  static void mallocFree(JSMallocState* s, void* ptr) {
+    if (!ptr) {
+      return;
+    }
+    s->malloc_count--;
+    s->malloc_size -= usableSize(ptr);
+    std::free(ptr);
+    static_cast<QjsEngine*>(s->opaque)->updateHeapUsage(s->malloc_size);
+  }
+
+  static void* mallocRealloc(JSMallocState* s, void* ptr, size_t size) {
+    if (!ptr) {
+      return size == 0 ? nullptr : mallocMalloc(s, size);
+    }
+    if (size == 0) {
+      mallocFree(s, ptr);
+      return nullptr;
+    }
+
+    auto oldSize = usableSize(ptr);
+    if (size > oldSize && !reserve(s, size - oldSize)) {
+      return nullptr;
+    }
+    ptr = std::realloc(ptr, size);
+    if (!ptr) {
+      return nullptr;
+    }
+    s->malloc_size = s->malloc_size - oldSize + usableSize(ptr);
+    static_cast<QjsEngine*>(s->opaque)->updateHeapUsage(s->malloc_size);
+    return ptr;
+  }
+
+  static constexpr JSMallocFunctions kMallocFunctions = {mallocMalloc, mallocFree, mallocRealloc,
+                                                         usableSize};
+#else
+  static constexpr JSMallocFunctions kMallocFunctions = kFunctions;
+#endif
+};
+
+QjsEngine::QjsEngine(std::shared_ptr<utils::MessageQueue> queue, const QjsFactory& factory,
+                     std::shared_ptr<utils::Allocator> allocator)
+    : queue_(queue ? std::move(queue) : std::make_shared<utils::MessageQueue>()),
+      allocator_(std::move(allocator)) {
+  if (factory && allocator_) {
+    throw std::logic_error("QjsEngine: allocator can't be used with a factory");
+  }
   if (factory) {
     std::tie(runtime_, context_) = factory();
   } else {
-    runtime_ = JS_NewRuntime();
+    // no header on every block unless the allocator needs the size back
+    runtime_ = JS_NewRuntime2(
+        allocator_ ? &MallocFunctions::kFunctions : &MallocFunctions::kMallocFunctions, this);
     if (runtime_) {
       context_ = JS_NewContext(runtime_);
     }
@@ -92,6 +261,7 @@ QjsEngine::QjsEngine(std::shared_ptr<utils::MessageQueue> queue, const QjsFactor
   if (!runtime_ || !context_) {
     throw std::logic_error("QjsEngine: runtime or context is nullptr");
   }
+  JS_SetInterruptHandler(runtime_, &QjsEngine::interruptHandler, this);
 
   initEngineResource();
 }
@@ -124,8 +294,12 @@ void QjsEngine::initEngineResource() {
     if (ptr) {
       auto opaque = static_cast<InstanceClassOpaque*>(ptr);
       // reset the weak reference
-      PauseGc pauseGc(opaque->scriptClassPointer->internalState_.engine);
+      auto engine = opaque->scriptClassPointer->internalState_.engine;
+      PauseGc pauseGc(engine);
       opaque->scriptClassPointer->internalState_.weakRef_ = JS_UNDEFINED;
+      engine->adjustAssociatedMemory(-static_cast<int64_t>(
+          static_cast<const internal::ClassDefineState*>(opaque->classDefine)
+              ->instanceDefine.instanceSize));
       delete opaque->scriptClassPointer;
       delete opaque;
     }
@@ -192,26 +366,78 @@ void QjsEngine::destroy() noexcept {
 }
 
 void QjsEngine::scheduleTick() {
+  if (microtaskPolicy_.mode == MicrotaskPolicy::Mode::kExplicit) {
+    return;
+  }
   bool no = false;
   if (tickScheduled_.compare_exchange_strong(no, true)) {
     utils::Message tick(
         [](auto& m) {
           auto eng = static_cast<QjsEngine*>(m.ptr0);
-          JSContext* ctx = nullptr;
           EngineScope scope(eng);
-          while (JS_ExecutePendingJob(eng->runtime_, &ctx) > 0) {
-          }
+          auto hasMore = eng->runPendingJobs();
           eng->tickScheduled_ = false;
+          if (hasMore) {
+            // out of budget, let other messages run first
+            eng->scheduleTick();
+          }
         },
         [](auto& m) {
 
         });
+    tick.name = "MicrotaskCheckpoint";
     tick.ptr0 = this;
     tick.tag = this;
     queue_->postMessage(tick);
   }
 }
 
+bool QjsEngine::runPendingJobs() {
+  internal::ExecutionScope executionScope(this);
+  return runMicrotasks([this](size_t maxJobs, bool& hasMore) {
+    size_t count = 0;
+    JSContext* ctx = nullptr;
+    while (count < maxJobs) {
+      auto ret = JS_ExecutePendingJob(runtime_, &ctx);
+      if (ret == 0) {
+        break;
+      }
+      count++;
+      if (ret < 0) {
+        // like js_std_loop, an error in one job doesn't stop the others
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        if (getInterruptReason()) {
+          // but an interruption does, the rest run in the next drain
+          break;
+        }
+      }
+    }
+    hasMore = JS_IsJobPending(runtime_);
+#ifdef QUICK_JS_HAS_SCRIPTX_JOB_COUNT_PATCH
+    microtasksQueued_.store(JS_GetEnqueuedJobCount(runtime_), std::memory_order_relaxed);
+#endif
+    return count;
+  });
+}
+
+int QjsEngine::interruptHandler(JSRuntime* /*runtime*/, void* opaque) {
+  // called every few thousand bytecodes, keep it cheap
+  return static_cast<QjsEngine*>(opaque)->getInterruptReason() ? 1 : 0;
+}
+
+void QjsEngine::setMicrotaskPolicy(const MicrotaskPolicy& policy) {
+  ScriptEngine::setMicrotaskPolicy(policy);
+  // pick up jobs queued in explicit mode
+  if (JS_IsJobPending(runtime_)) {
+    scheduleTick();
+  }
+}
+
+bool QjsEngine::performMicrotaskCheckpoint() {
+  EngineScope scope(this);
+  return runPendingJobs();
+}
+
 void QjsEngine::extendLifeTimeToNextLoop(JSValue value) {
   // schedule -> JS_Free(ref)
   class ExtendLifeTime {
@@ -252,13 +478,20 @@ Local<Value> QjsEngine::eval(const Local<String>& script, const Local<String>& s
 
 Local<Value> QjsEngine::eval(const Local<String>& script, const Local<Value>& sourceFile) {
   Tracer trace(this, "QjsEngine::eval");
+  internal::ExecutionScope executionScope(this);
   JSValue ret = JS_UNDEFINED;
   StringHolder sh(script);
 
   if (sourceFile.isString()) {
     StringHolder source(sourceFile.asString());
+    if (codeCache_) {
+      return evalWithCodeCache(sh, source.c_str());
+    }
     ret = JS_Eval(context_, sh.c_str(), sh.length(), source.c_str(), JS_EVAL_TYPE_GLOBAL);
   } else {
+    if (codeCache_) {
+      return evalWithCodeCache(sh, "<unknown>");
+    }
     ret = JS_Eval(context_, sh.c_str(), sh.length(), "<unknown>", JS_EVAL_TYPE_GLOBAL);
   }
   qjs_backend::checkException(ret);
@@ -268,12 +501,130 @@ Local<Value> QjsEngine::eval(const Local<String>& script, const Local<Value>& so
   return Local<Value>(ret);
 }
 
+Local<Value> QjsEngine::evalWithCodeCache(const StringHolder& script, const char* sourceFile) {
+  // bytecode contains the file name
+  auto key = utils::CodeCache::hashKey(
+      script.stringView(), std::string("QuickJS:") + bytecodeVersion() + ":" + sourceFile);
+
+  std::string bytecode;
+  if (codeCache_->load(key, bytecode)) {
+    auto function =
+        JS_ReadObject(context_, reinterpret_cast<const uint8_t*>(bytecode.data()),
+                      bytecode.size(), JS_READ_OBJ_BYTECODE);
+    if (!JS_IsException(function)) {
+      codeCache_->recordHit();
+      return runFunction(function);
+    }
+    // incompatible bytecode version, etc.
+    JS_FreeValue(context_, JS_GetException(context_));
+    codeCache_->recordRejected();
+    codeCache_->remove(key);
+  } else {
+    codeCache_->recordMiss();
+  }
+
+  auto function = compileFunction(script, sourceFile);
+  bytecode = writeBytecode(function);
+  if (!bytecode.empty()) {
+    codeCache_->store(key, bytecode);
+    codeCache_->recordProduced();
+  } else {
+    // not cacheable, just run it
+    JS_FreeValue(context_, JS_GetException(context_));
+  }
+  return runFunction(function);
+}
+
+JSValue QjsEngine::compileFunction(const StringHolder& script, const char* sourceFile) {
+  auto function = JS_Eval(context_, script.c_str(), script.length(), sourceFile,
+                          JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+  qjs_backend::checkException(function);
+  return function;
+}
+
+std::string QjsEngine::writeBytecode(JSValue function) {
+  size_t size = 0;
+  auto buffer = JS_WriteObject(context_, &size, function, JS_WRITE_OBJ_BYTECODE);
+  if (!buffer) {
+    return {};
+  }
+  std::string bytecode(reinterpret_cast<const char*>(buffer), size);
+  js_free(context_, buffer);
+  return bytecode;
+}
+
+const std::string& QjsEngine::bytecodeVersion() {
+  if (bytecodeVersion_.empty()) {
+    constexpr std::string_view kProbe = "(function (a, b) { return [a + b, `${a}`, {b}]; })";
+    auto function = JS_Eval(context_, kProbe.data(), kProbe.size(), "<probe>",
+                            JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+    std::string bytecode;
+    if (!JS_IsException(function)) {
+      bytecode = writeBytecode(function);
+      JS_FreeValue(context_, function);
+    }
+    if (bytecode.empty()) {
+      JS_FreeValue(context_, JS_GetException(context_));
+    }
+    bytecodeVersion_ = utils::CodeCache::hashKey(bytecode, "QuickJS");
+  }
+  return bytecodeVersion_;
+}
+
+Local<Value> QjsEngine::runFunction(JSValue function) {
+  internal::ExecutionScope executionScope(this);
+  // JS_EvalFunction takes the ownership of function
+  auto ret = JS_EvalFunction(context_, function);
+  qjs_backend::checkException(ret);
+
+  scheduleTick();
+
+  return Local<Value>(ret);
+}
+
+Local<ByteBuffer> QjsEngine::compileBytecode(const Local<String>& script,
+                                             const Local<Value>& sourceFile) {
+  Tracer trace(this, "QjsEngine::compileBytecode");
+  StringHolder sh(script);
+
+  JSValue function;
+  if (sourceFile.isString()) {
+    StringHolder source(sourceFile.asString());
+    function = compileFunction(sh, source.c_str());
+  } else {
+    function = compileFunction(sh, "<unknown>");
+  }
+
+  auto bytecode = writeBytecode(function);
+  JS_FreeValue(context_, function);
+  if (bytecode.empty()) {
+    qjs_backend::checkException(-1, "can't write bytecode");
+  }
+  return ByteBuffer::newByteBuffer(bytecode.data(), bytecode.size());
+}
+
+Local<Value> QjsEngine::evalBytecode(const Local<ByteBuffer>& bytecode) {
+  Tracer trace(this, "QjsEngine::evalBytecode");
+  auto function =
+      JS_ReadObject(context_, static_cast<const uint8_t*>(bytecode.getRawBytes()),
+                    bytecode.byteLength(), JS_READ_OBJ_BYTECODE);
+  qjs_backend::checkException(function);
+  return runFunction(function);
+}
+
+void QjsEngine::setCodeCache(std::shared_ptr<utils::CodeCache> codeCache) {
+  codeCache_ = std::move(codeCache);
+}
+
+std::shared_ptr<utils::CodeCache> QjsEngine::getCodeCache() const { return codeCache_; }
+
 std::shared_ptr<utils::MessageQueue> QjsEngine::messageQueue() { return queue_; }
 
 void QjsEngine::gc() {
   EngineScope scope(this);
   if (isDestroying() || pauseGcCount_ != 0) return;
   JS_RunGC(runtime_);
+  associatedMemoryAtGc_ = associatedMemory_;
 }
 
 size_t QjsEngine::getHeapSize() {
@@ -283,7 +634,42 @@ size_t QjsEngine::getHeapSize() {
   return usage.memory_used_size;
 }
 
-void QjsEngine::adjustAssociatedMemory(int64_t count) {}
+void QjsEngine::adjustAssociatedMemory(int64_t count) {
+  if (isDestroying()) return;
+  EngineScope scope(this);
+  associatedMemory_ += count;
+  if (associatedMemory_ < associatedMemoryAtGc_) {
+    // freed by a GC of QuickJs itself
+    associatedMemoryAtGc_ = associatedMemory_;
+  }
+  if (count <= 0 || pauseGcCount_ != 0) return;
+
+  // like the GC threshold of QuickJs, collect when it grew by half since the last collection
+  auto threshold = std::max(kAssociatedMemoryGcThreshold, associatedMemoryAtGc_ / 2);
+  if (associatedMemory_ - associatedMemoryAtGc_ > threshold) {
+    JS_RunGC(runtime_);
+    // finalizers have adjusted associatedMemory_ meanwhile
+    associatedMemoryAtGc_ = associatedMemory_;
+  }
+}
+
+bool QjsEngine::performIdleGc(std::chrono::steady_clock::time_point /*deadline*/) {
+  // QuickJs has no incremental GC, run a full one only when there is enough garbage
+  if (pauseGcCount_ != 0) return false;
+  auto size = getHeapSize();
+  if (size > idleGcHeapSize_ + idleGcHeapSize_ / 10) {
+    JS_RunGC(runtime_);
+    idleGcHeapSize_ = getHeapSize();
+    idleGcCycles_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return false;
+}
+
+void QjsEngine::setHeapLimit(const HeapLimit& limit) {
+  ScriptEngine::setHeapLimit(limit);
+  EngineScope scope(this);
+  JS_SetMemoryLimit(runtime_, limit.hardLimit != 0 ? limit.hardLimit : static_cast<size_t>(-1));
+}
 
 ScriptLanguage QjsEngine::getLanguageType() { return ScriptLanguage::kJavaScript; }
 
@@ -365,6 +751,8 @@ Local<Object> QjsEngine::newConstructor(
         opaque->scriptClassPointer = instanceTypeToScriptClass(instance);
         opaque->classDefine = classDefine;
         JS_SetOpaque(obj, opaque);
+        engine->adjustAssociatedMemory(
+            static_cast<int64_t>(classDefine->instanceDefine.instanceSize));
 
         return qjs_interop::makeLocal<Value>(obj);
       });
@@ -24,6 +24,8 @@
 
 #include "../../src/Engine.h"
 #include "../../src/Exception.h"
+#include "../../src/utils/Allocator.h"
+#include "../../src/utils/CodeCache.h"
 #include "../../src/utils/GlobalWeakBookkeeping.hpp"
 #include "../../src/utils/MessageQueue.h"
 #include "QjsHelper.h"
@@ -44,6 +46,8 @@ class QjsEngine : public ScriptEngine {
   static JSClassID kInstanceClassId;
 
   std::shared_ptr<::script::utils::MessageQueue> queue_;
+  // must outlive runtime_
+  std::shared_ptr<::script::utils::Allocator> allocator_;
   JSRuntime* runtime_ = nullptr;
   JSContext* context_ = nullptr;
 
@@ -51,6 +55,11 @@ class QjsEngine : public ScriptEngine {
 
   // state
   int pauseGcCount_ = 0;
+  // heap size after the last idle GC
+  size_t idleGcHeapSize_ = 0;
+  // see adjustAssociatedMemory
+  int64_t associatedMemory_ = 0;
+  int64_t associatedMemoryAtGc_ = 0;
   bool isDestroying_ = false;
   std::atomic_bool tickScheduled_ = false;
 
@@ -69,12 +78,21 @@ class QjsEngine : public ScriptEngine {
   JSValue helperFunctionGetByteBufferInfo_ = {};
   JSAtom helperSymbolInternalStore_ = JS_ATOM_NULL;
 
+  std::shared_ptr<utils::CodeCache> codeCache_;
+  // see bytecodeVersion
+  std::string bytecodeVersion_;
+
  public:
   using QjsFactory = std::function<std::pair<JSRuntime*, JSContext*>()>;
 
  public:
+  /**
+   * @param allocator memory allocator of the runtime, can't be used together with factory.
+   * nullptr means malloc.
+   */
   explicit QjsEngine(std::shared_ptr<::script::utils::MessageQueue> queue = nullptr,
-                     const QjsFactory& factory = nullptr);
+                     const QjsFactory& factory = nullptr,
+                     std::shared_ptr<::script::utils::Allocator> allocator = nullptr);
 
   SCRIPTX_DISALLOW_COPY_AND_MOVE(QjsEngine);
 
@@ -94,14 +112,66 @@ class QjsEngine : public ScriptEngine {
   Local<Value> eval(const Local<String>& script) override;
   using ScriptEngine::eval;
 
+  /**
+   * Compile script into QuickJs bytecode, without running it.
+   * The result can be stored (eg: shipped by an ahead-of-time build step)
+   * and later run by evalBytecode.
+   *
+   * @param script the script
+   * @param sourceFile source file name, used in error stack. Can be null.
+   * @return the serialized bytecode
+   */
+  Local<ByteBuffer> compileBytecode(const Local<String>& script,
+                                    const Local<Value>& sourceFile = {});
+
+  /**
+   * Run bytecode produced by compileBytecode.
+   *
+   * NOTE: QuickJs trusts the bytecode, DO NOT run bytecode from untrusted source.
+   * @return the result of the script
+   */
+  Local<Value> evalBytecode(const Local<ByteBuffer>& bytecode);
+
+  /**
+   * Enable bytecode cache for eval. (disabled by default)
+   *
+   * When enabled, eval looks up the cache by the hash of script source (and source file name),
+   * and runs the cached bytecode if any, which skips parsing.
+   * Otherwise the script is compiled and the bytecode is written back to the cache.
+   *
+   * see CodeCache::getStatistics for hit/miss/rejected counters.
+   *
+   * @param codeCache the cache to use, can be shared by multiple engines. null to disable.
+   */
+  void setCodeCache(std::shared_ptr<utils::CodeCache> codeCache);
+
+  std::shared_ptr<utils::CodeCache> getCodeCache() const;
+
   std::shared_ptr<utils::MessageQueue> messageQueue() override;
 
   void gc() override;
 
   size_t getHeapSize() override;
 
+  /**
+   * runs JS_RunGC when the associated memory grew by half since the last GC
+   * (at least kAssociatedMemoryGcThreshold), QuickJs doesn't count it by itself.
+   * native class instances report their instanceSize here.
+   */
   void adjustAssociatedMemory(int64_t count) override;
 
+  /**
+   * the hardLimit is set by JS_SetMemoryLimit, QuickJs throws InternalError "out of memory".
+   */
+  void setHeapLimit(const HeapLimit& limit) override;
+
+  void setMicrotaskPolicy(const MicrotaskPolicy& policy) override;
+
+  /**
+   * run pending jobs (JS_ExecutePendingJob) within the budget of the policy.
+   */
+  bool performMicrotaskCheckpoint() override;
+
   ScriptLanguage getLanguageType() override;
 
   std::string getEngineVersion() override;
@@ -123,8 +193,11 @@ class QjsEngine : public ScriptEngine {
                                       const internal::ClassDefineState* classDefine, size_t size,
                                       const Local<script::Value>* args) override;
 
+  bool performIdleGc(std::chrono::steady_clock::time_point deadline) override;
+
  private:
   struct BookKeepFetcher;
+  struct MallocFunctions;
   friend struct QjsBookKeepFetcher;
 
   void registerNativeStatic(const Local<Object>& module,
@@ -137,11 +210,50 @@ class QjsEngine : public ScriptEngine {
 
   void initEngineResource();
 
+  Local<Value> evalWithCodeCache(const StringHolder& script, const char* sourceFile);
+
+  /**
+   * @return compiled function, caller owns the returned value
+   */
+  JSValue compileFunction(const StringHolder& script, const char* sourceFile);
+
+  /**
+   * @return bytecode, or empty string on failure with pending exception
+   */
+  std::string writeBytecode(JSValue function);
+
+  /**
+   * a fingerprint of the bytecode format, part of the code cache key.
+   * QuickJs doesn't expose its version, so it is the hash of the bytecode of a probe script,
+   * which starts with the bytecode version and changes with the build options.
+   */
+  const std::string& bytecodeVersion();
+
   /**
-   * similar to js_std_loop
+   * run compiled function, the function is freed.
+   */
+  Local<Value> runFunction(JSValue function);
+
+  /**
+   * similar to js_std_loop, post a message to run pending jobs, unless the policy is kExplicit.
    */
   void scheduleTick();
 
+  /**
+   * @return true if there are jobs left
+   */
+  bool runPendingJobs();
+
+  /**
+   * JSInterruptHandler, QuickJs throws an uncatchable error when it returns non-zero.
+   */
+  static int interruptHandler(JSRuntime* runtime, void* opaque);
+
+  /**
+   * associated memory growth that triggers a GC at least, see adjustAssociatedMemory.
+   */
+  static constexpr int64_t kAssociatedMemoryGcThreshold = 8 * 1024 * 1024;
+
   void extendLifeTimeToNextLoop(JSValue value);
 
   template <typename T, typename... Args>
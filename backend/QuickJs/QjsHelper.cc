@@ -40,6 +40,11 @@ void checkException(int ret, const char* message) {
     auto context = currentContext();
     auto pending = JS_GetException(currentContext());
 
+    if (auto reason = currentEngine().getInterruptReason()) {
+      JS_FreeValue(context, pending);
+      throw TerminationException(*reason);
+    }
+
     if (JS_IsObject(pending)) {
       throw Exception(qjs_interop::makeLocal<Value>(pending));
     } else {
@@ -94,6 +94,11 @@ REF_IMPL_BASIC_NOT_VALUE(ByteBuffer)
 REF_IMPL_BASIC_EQUALS(ByteBuffer)
 REF_IMPL_TO_VALUE(ByteBuffer)
 
+REF_IMPL_BASIC_FUNC(Promise)
+REF_IMPL_BASIC_NOT_VALUE(Promise)
+REF_IMPL_BASIC_EQUALS(Promise)
+REF_IMPL_TO_VALUE(Promise)
+
 REF_IMPL_BASIC_FUNC(Unsupported)
 REF_IMPL_BASIC_NOT_VALUE(Unsupported)
 REF_IMPL_BASIC_EQUALS(Unsupported)
@@ -158,6 +163,17 @@ bool Local<Value>::isByteBuffer() const {
   return fun.call({}, *this).asBoolean().value();
 }
 
+bool Local<Value>::isPromise() const {
+  if (!isObject()) return false;
+
+#ifdef QUICK_JS_HAS_SCRIPTX_PROMISE_PATCH
+  return JS_GetPromiseState(qjs_backend::currentContext(), val_) >= 0;
+#else
+  auto& engine = qjs_backend::currentEngine();
+  return Local<Object>(qjs_backend::dupValue(val_)).instanceOf(engine.getGlobal().get("Promise"));
+#endif
+}
+
 bool Local<Value>::isObject() const { return JS_IsObject(val_); }
 
 bool Local<Value>::isUnsupported() const { return getKind() == ValueKind::kUnsupported; }
@@ -197,6 +213,11 @@ Local<ByteBuffer> Local<Value>::asByteBuffer() const {
   throw Exception("can't cast value as ByteBuffer");
 }
 
+Local<Promise> Local<Value>::asPromise() const {
+  if (isPromise()) return Local<Promise>(qjs_backend::dupValue(val_));
+  throw Exception("can't cast value as Promise");
+}
+
 Local<Object> Local<Value>::asObject() const {
   if (isObject()) return Local<Object>(qjs_backend::dupValue(val_));
   throw Exception("can't cast value as Object");
@@ -319,6 +340,7 @@ Local<Value> Local<Function>::callImpl(const Local<Value>& thiz, size_t size,
   auto& engine = qjs_backend::currentEngine();
   auto context = engine.context_;
   JSValue ret = JS_UNDEFINED;
+  internal::ExecutionScope executionScope(&engine);
 
   internal::withNArray<JSValue>(
       size, [this, &engine, context, &ret, &thiz, size, args](JSValue* array) {
@@ -376,6 +398,17 @@ void Local<Array>::clear() const {
   qjs_backend::checkException(JS_SetProperty(engine.context_, val_, engine.lengthAtom_, number));
 }
 
+void Local<Array>::forEachImpl(ForEachCallback callback, void* data) const {
+  auto context = qjs_backend::currentContext();
+  auto length = size();
+  for (size_t i = 0; i < length; ++i) {
+    auto element = JS_GetPropertyUint32(context, val_, static_cast<uint32_t>(i));
+    qjs_backend::checkException(element);
+    // freed at the end of each iteration
+    callback(data, i, qjs_interop::makeLocal<Value>(element));
+  }
+}
+
 namespace qjs_backend {
 
 ByteBufferState::ByteBufferState(JSValue val) : val_(val) {}
@@ -481,4 +514,59 @@ std::shared_ptr<void> Local<ByteBuffer>::getRawBytesShared() const {
   return std::shared_ptr<void>(getRawBytes(), [global = Global<ByteBuffer>(*this)](void* ptr) {});
 }
 
+#ifdef QUICK_JS_HAS_SCRIPTX_PROMISE_PATCH
+
+Promise::State Local<Promise>::getState() const {
+  switch (JS_GetPromiseState(qjs_backend::currentContext(), val_)) {
+    case 1:
+      return Promise::State::kFulfilled;
+    case 2:
+      return Promise::State::kRejected;
+    default:
+      return Promise::State::kPending;
+  }
+}
+
+Local<Value> Local<Promise>::getResult() const {
+  if (getState() == Promise::State::kPending) {
+    return {};
+  }
+  return qjs_interop::makeLocal<Value>(JS_GetPromiseResult(qjs_backend::currentContext(), val_));
+}
+
+#else
+
+Promise::State Local<Promise>::getState() const {
+  throw Exception("Promise state needs the ScriptX patch of QuickJs, see backend/QuickJs/patch");
+}
+
+Local<Value> Local<Promise>::getResult() const {
+  throw Exception("Promise state needs the ScriptX patch of QuickJs, see backend/QuickJs/patch");
+}
+
+#endif
+
+Local<Promise> Local<Promise>::then(const Local<Value>& onFulfilled,
+                                    const Local<Value>& onRejected) const {
+  auto then = Local<Object>(qjs_backend::dupValue(val_)).get("then");
+  // call() schedules the job queue
+  return then.asFunction().call(*this, {onFulfilled, onRejected}).asPromise();
+}
+
+void Promise::Resolver::resolve(const Local<Value>& value) const {
+  handle_.get().asArray().get(0).asFunction().call({}, value);
+}
+
+void Promise::Resolver::reject(const Local<Value>& reason) const {
+  handle_.get().asArray().get(1).asFunction().call({}, reason);
+}
+
+size_t internal::identityHash(const Local<Value>& value) {
+  auto val = qjs_interop::peekLocal(value);
+  if (!JS_VALUE_HAS_REF_COUNT(val)) {
+    return 0;
+  }
+  return reinterpret_cast<size_t>(JS_VALUE_GET_PTR(val));
+}
+
 }  // namespace script
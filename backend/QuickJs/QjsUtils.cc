@@ -53,4 +53,33 @@ std::u8string_view StringHolder::u8stringView() const {
 const char8_t *StringHolder::c_u8str() const { return reinterpret_cast<const char8_t *>(c_str()); }
 #endif
 
+Local<Value> Json::parse(std::string_view json) {
+  auto context = qjs_backend::currentContext();
+  // JS_ParseJSON reads one byte past the end, it must be a null terminator
+  std::string source(json);
+  auto ret = JS_ParseJSON(context, source.c_str(), source.size(), "<json>");
+  qjs_backend::checkException(ret);
+  return qjs_interop::makeLocal<Value>(ret);
+}
+
+std::string Json::stringify(const Local<Value> &value) {
+  auto context = qjs_backend::currentContext();
+  auto ret =
+      JS_JSONStringify(context, qjs_interop::peekLocal(value), JS_UNDEFINED, JS_UNDEFINED);
+  qjs_backend::checkException(ret);
+  if (JS_IsUndefined(ret)) {
+    return {};
+  }
+
+  size_t length = 0;
+  auto str = JS_ToCStringLen(context, &length, ret);
+  JS_FreeValue(context, ret);
+  if (str == nullptr) {
+    throw Exception("failed to get string from JSON.stringify");
+  }
+  std::string json(str, length);
+  JS_FreeCString(context, str);
+  return json;
+}
+
 }  // namespace script
@@ -77,6 +77,16 @@ Local<String> String::newString(const std::u8string& utf8) { return newString(ut
 
 #endif
 
+Local<String> String::newExternalString(std::shared_ptr<const std::string> utf8) {
+  if (!utf8) throw Exception("null pointer");
+  // QuickJs has no external string, copy it
+  return newString(*utf8);
+}
+
+Local<String> String::newExternalStaticString(std::string_view staticUtf8) {
+  return newString(staticUtf8);
+}
+
 Local<Number> Number::newNumber(float value) { return newNumber(static_cast<double>(value)); }
 
 Local<Number> Number::newNumber(double value) {
@@ -161,6 +171,16 @@ Local<Array> Array::newArrayImpl(size_t size, const Local<Value>* args) {
   return qjs_interop::makeLocal<Array>(array);
 }
 
+Promise::Resolver Promise::newPromise() {
+  JSValue resolvingFunctions[2];
+  auto promise = JS_NewPromiseCapability(qjs_backend::currentContext(), resolvingFunctions);
+  qjs_backend::checkException(promise);
+
+  auto functions = Array::of(qjs_interop::makeLocal<Function>(resolvingFunctions[0]),
+                             qjs_interop::makeLocal<Function>(resolvingFunctions[1]));
+  return Resolver(qjs_interop::makeLocal<Promise>(promise), functions);
+}
+
 Local<ByteBuffer> ByteBuffer::newByteBuffer(size_t size) { return newByteBuffer(nullptr, size); }
 
 Local<script::ByteBuffer> ByteBuffer::newByteBuffer(void* nativeBuffer, size_t size) {
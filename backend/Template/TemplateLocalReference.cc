@@ -83,6 +83,11 @@ REF_IMPL_BASIC_NOT_VALUE(ByteBuffer)
 REF_IMPL_BASIC_EQUALS(ByteBuffer)
 REF_IMPL_TO_VALUE(ByteBuffer)
 
+REF_IMPL_BASIC_FUNC(Promise)
+REF_IMPL_BASIC_NOT_VALUE(Promise)
+REF_IMPL_BASIC_EQUALS(Promise)
+REF_IMPL_TO_VALUE(Promise)
+
 REF_IMPL_BASIC_FUNC(Unsupported)
 REF_IMPL_BASIC_NOT_VALUE(Unsupported)
 REF_IMPL_BASIC_EQUALS(Unsupported)
@@ -132,6 +137,8 @@ bool Local<Value>::isArray() const { return false; }
 
 bool Local<Value>::isByteBuffer() const { return false; }
 
+bool Local<Value>::isPromise() const { return false; }
+
 bool Local<Value>::isObject() const { return false; }
 
 bool Local<Value>::isUnsupported() const { return false; }
@@ -152,6 +159,8 @@ Local<ByteBuffer> Local<Value>::asByteBuffer() const {
   throw Exception("can't cast value as ByteBuffer");
 }
 
+Local<Promise> Local<Value>::asPromise() const { throw Exception("can't cast value as Promise"); }
+
 Local<Object> Local<Value>::asObject() const { throw Exception("can't cast value as Object"); }
 
 Local<Unsupported> Local<Value>::asUnsupported() const {
@@ -199,6 +208,8 @@ void Local<Array>::add(const script::Local<script::Value>& value) const { set(si
 
 void Local<Array>::clear() const {}
 
+void Local<Array>::forEachImpl(ForEachCallback callback, void* data) const {}
+
 ByteBuffer::Type Local<ByteBuffer>::getType() const { return ByteBuffer::Type::KFloat32; }
 
 bool Local<ByteBuffer>::isShared() const { return true; }
@@ -213,4 +224,19 @@ void* Local<ByteBuffer>::getRawBytes() const { return nullptr; }
 
 std::shared_ptr<void> Local<ByteBuffer>::getRawBytesShared() const { return {}; }
 
+Promise::State Local<Promise>::getState() const { return Promise::State::kPending; }
+
+Local<Value> Local<Promise>::getResult() const { return {}; }
+
+Local<Promise> Local<Promise>::then(const Local<Value>& onFulfilled,
+                                    const Local<Value>& onRejected) const {
+  TEMPLATE_NOT_IMPLEMENTED();
+}
+
+void Promise::Resolver::resolve(const Local<Value>& value) const { TEMPLATE_NOT_IMPLEMENTED(); }
+
+void Promise::Resolver::reject(const Local<Value>& reason) const { TEMPLATE_NOT_IMPLEMENTED(); }
+
+size_t internal::identityHash(const Local<Value>& value) { return 0; }
+
 }  // namespace script
@@ -43,4 +43,8 @@ std::u8string_view StringHolder::u8stringView() const {
 const char8_t *StringHolder::c_u8str() const { return reinterpret_cast<const char8_t *>(c_str()); }
 #endif
 
+Local<Value> Json::parse(std::string_view json) { TEMPLATE_NOT_IMPLEMENTED(); }
+
+std::string Json::stringify(const Local<Value> &value) { TEMPLATE_NOT_IMPLEMENTED(); }
+
 }  // namespace script
@@ -49,6 +49,16 @@ Local<String> String::newString(const std::u8string& utf8) { return newString(ut
 
 #endif
 
+Local<String> String::newExternalString(std::shared_ptr<const std::string> utf8) {
+  if (!utf8) throw Exception("null pointer");
+  // copy it if the engine has no external string
+  return newString(*utf8);
+}
+
+Local<String> String::newExternalStaticString(std::string_view staticUtf8) {
+  return newString(staticUtf8);
+}
+
 Local<Number> Number::newNumber(float value) { return newNumber(static_cast<double>(value)); }
 
 Local<Number> Number::newNumber(double value) { TEMPLATE_NOT_IMPLEMENTED(); }
@@ -69,6 +79,8 @@ Local<Array> Array::newArrayImpl(size_t size, const Local<Value>* args) {
   TEMPLATE_NOT_IMPLEMENTED();
 }
 
+Promise::Resolver Promise::newPromise() { TEMPLATE_NOT_IMPLEMENTED(); }
+
 Local<ByteBuffer> ByteBuffer::newByteBuffer(size_t size) { TEMPLATE_NOT_IMPLEMENTED(); }
 
 Local<script::ByteBuffer> ByteBuffer::newByteBuffer(void* nativeBuffer, size_t size) {
@@ -18,12 +18,50 @@
 #include "V8Engine.h"
 #include <cassert>
 #include <memory>
+#include <unordered_set>
 #include "V8Helper.hpp"
 #include "V8Native.hpp"
 #include "V8Reference.hpp"
 
 namespace script::v8_backend {
 
+struct V8Engine::SnapshotState {
+  // true while registering native classes, before the isolate is created
+  bool collecting = false;
+  // in registration order, point to V8Engine::nativeRegistry_
+  std::vector<NativeClassData*> nativeClasses;
+  // null terminated, must outlive the isolate
+  std::vector<intptr_t> externalReferences;
+
+  // the V8 part of snapshot, must outlive the isolate
+  std::string blob;
+  v8::StartupData startupData{nullptr, 0};
+};
+
+namespace {
+
+// index of data added by SnapshotCreator::AddData
+constexpr size_t kSnapshotDataInternalStoreSymbol = 0;
+constexpr size_t kSnapshotDataConstructorMarkSymbol = 1;
+constexpr size_t kSnapshotDataNativeClassBegin = 2;
+
+constexpr char kSnapshotMagic[] = "ScriptX V8 snapshot\n";
+
+// magic, V8 version, and the shape of native classes.
+// V8 crashes on a mismatched snapshot, so we check it first.
+std::string snapshotHeader(size_t classCount, size_t referenceCount) {
+  std::string header = kSnapshotMagic;
+  header.append(v8::V8::GetVersion());
+  header.push_back('\n');
+  header.append(std::to_string(classCount));
+  header.push_back(' ');
+  header.append(std::to_string(referenceCount));
+  header.push_back('\n');
+  return header;
+}
+
+}  // namespace
+
 // create a master engine (opposite to slave engine)
 V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq) : V8Engine(std::move(mq), nullptr) {}
 
@@ -36,8 +74,7 @@ V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq,
     isolate_ = isolateFactory();
   } else {
     v8::Isolate::CreateParams createParams;
-    allocator_.reset(v8::ArrayBuffer::Allocator::NewDefaultAllocator());
-    createParams.array_buffer_allocator = allocator_.get();
+    setArrayBufferAllocator(createParams);
     isolate_ = v8::Isolate::New(createParams);
   }
   v8Platform_->addEngineInstance(isolate_, this);
@@ -47,6 +84,29 @@ V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq,
   initContext();
 }
 
+void V8Engine::setArrayBufferAllocator(v8::Isolate::CreateParams& createParams) {
+  allocator_.reset(v8::ArrayBuffer::Allocator::NewDefaultAllocator());
+#if V8_MAJOR_VERSION >= 8
+  // each backing store holds a reference, freeing a transferred one after this engine is gone
+  // must not go through a dead allocator
+  createParams.array_buffer_allocator_shared = allocator_;
+#else
+  createParams.array_buffer_allocator = allocator_.get();
+#endif
+}
+
+V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq, const HeapLimit& heapLimit)
+    : V8Engine(std::move(mq), [this, &heapLimit]() {
+        v8::Isolate::CreateParams createParams;
+        setArrayBufferAllocator(createParams);
+        if (heapLimit.hardLimit != 0) {
+          createParams.constraints.ConfigureDefaultsFromHeapSize(0, heapLimit.hardLimit);
+        }
+        return v8::Isolate::New(createParams);
+      }) {
+  setHeapLimit(heapLimit);
+}
+
 V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue, v8::Isolate* isolate,
                    v8::Local<v8::Context> context, bool addGlobalEngineScope)
     : isOwnIsolate_(false),
@@ -66,6 +126,52 @@ V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue, v8::Isolat
   }
 }
 
+V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq,
+                   const std::vector<NativeRegister>& nativeClasses)
+    : v8Platform_(V8Platform::getPlatform()),
+      messageQueue_(mq ? std::move(mq) : std::make_shared<utils::MessageQueue>()),
+      snapshot_(std::make_unique<SnapshotState>()),
+      isolate_(nullptr) {
+  collectSnapshotClasses(nativeClasses);
+}
+
+V8Engine::V8Engine(std::shared_ptr<utils::MessageQueue> mq, std::string_view snapshot,
+                   const std::vector<NativeRegister>& nativeClasses)
+    : V8Engine(std::move(mq), nativeClasses) {
+  auto header = snapshotHeader(snapshot_->nativeClasses.size(),
+                               snapshot_->externalReferences.size());
+  if (snapshot.size() <= header.size() || snapshot.substr(0, header.size()) != header) {
+    if (snapshot.substr(0, sizeof(kSnapshotMagic) - 1) != kSnapshotMagic) {
+      throw Exception("invalid snapshot");
+    }
+    throw Exception("snapshot mismatch, it is created by another V8 version or native classes");
+  }
+  snapshot_->blob = snapshot.substr(header.size());
+  snapshot_->startupData.data = snapshot_->blob.data();
+  snapshot_->startupData.raw_size = static_cast<int>(snapshot_->blob.size());
+
+  v8::Isolate::CreateParams createParams;
+  setArrayBufferAllocator(createParams);
+  createParams.snapshot_blob = &snapshot_->startupData;
+  createParams.external_references = snapshot_->externalReferences.data();
+  isolate_ = v8::Isolate::New(createParams);
+  v8Platform_->addEngineInstance(isolate_, this);
+
+  isolate_->SetCaptureStackTraceForUncaughtExceptions(true);
+
+  // the default context, the symbols, and templates all come from the snapshot
+  initContext();
+
+  v8::Locker locker(isolate_);
+  v8::Isolate::Scope is(isolate_);
+  v8::HandleScope handle_scope(isolate_);
+  auto index = kSnapshotDataNativeClassBegin;
+  for (auto classData : snapshot_->nativeClasses) {
+    auto funcT = isolate_->GetDataFromSnapshotOnce<v8::FunctionTemplate>(index++);
+    classData->functionTemplate.Reset(isolate_, funcT.ToLocalChecked());
+  }
+}
+
 void V8Engine::initContext() {
   v8::Locker locker(isolate_);
   v8::Isolate::Scope is(isolate_);
@@ -74,6 +180,15 @@ void V8Engine::initContext() {
     auto context = v8::Context::New(isolate_);
     context_ = v8::Global<v8::Context>(isolate_, context);
   }
+  if (snapshot_ && !snapshot_->blob.empty()) {
+    internalStoreSymbol_ = v8::Global<v8::Symbol>(
+        isolate_, isolate_->GetDataFromSnapshotOnce<v8::Symbol>(kSnapshotDataInternalStoreSymbol)
+                      .ToLocalChecked());
+    constructorMarkSymbol_ = v8::Global<v8::Symbol>(
+        isolate_, isolate_->GetDataFromSnapshotOnce<v8::Symbol>(kSnapshotDataConstructorMarkSymbol)
+                      .ToLocalChecked());
+    return;
+  }
   internalStoreSymbol_ = v8::Global<v8::Symbol>(isolate_, v8::Symbol::New(isolate_));
   constructorMarkSymbol_ = v8::Global<v8::Symbol>(isolate_, v8::Symbol::New(isolate_));
 }
@@ -90,17 +205,33 @@ void V8Engine::destroy() noexcept {
     // Isolate::Dispose don't do gc.
     // (For performance reason, it just tear down the heap).
     // we must manually release native object explicitly
-    for (auto& it : managedObject_) {
+    while (managedObjects_) {
+      auto object = managedObjects_;
+      unlinkManagedObject(managedObjects_, object);
       // reset weak first
-      it.second.Reset();
+      object->weak.Reset();
       // do destruct
-      auto data = it.first;
-      data->cleanupFunc(data->data);
-      delete data;
+      object->cleanupFunc(object->data);
+      managedObjectPool_.release(object);
+    }
+    while (pendingManagedObjects_) {
+      auto object = pendingManagedObjects_;
+      unlinkManagedObject(pendingManagedObjects_, object);
+      object->cleanupFunc(object->data);
+      if (isOwnIsolate_) {
+        // no more callbacks after Isolate::Dispose
+        managedObjectPool_.release(object);
+      } else {
+        // the isolate lives on, the second pass callback is still coming and frees the record
+        object->engine = nullptr;
+      }
     }
-    managedObject_.clear();
     keptObject_.clear();
 
+    if (heapLimitCallbacksAdded_) {
+      removeHeapLimitCallbacks();
+    }
+
     nativeRegistry_.clear();
     globalWeakBookkeeping_.clear();
 
@@ -130,6 +261,169 @@ V8Engine::V8Engine(V8Engine* masterEngine)
 
 UniqueEnginePtr V8Engine::newSlaveEngine() { return UniqueEnginePtr(new V8Engine(this)); }
 
+void V8Engine::collectSnapshotClasses(const std::vector<NativeRegister>& nativeClasses) {
+  // go through the normal registerNativeClass path, so that ScriptEngine knows the classes,
+  // but only record them in performRegisterNativeClass.
+  snapshot_->collecting = true;
+  for (auto& nativeClass : nativeClasses) {
+    nativeClass.registerNativeClass(this);
+  }
+  snapshot_->collecting = false;
+
+  // every native pointer reachable from the snapshot (callbacks, and v8::External data),
+  // in a deterministic order.
+  auto& references = snapshot_->externalReferences;
+  std::unordered_set<intptr_t> added;
+  auto add = [&references, &added](auto pointer) {
+    auto address = reinterpret_cast<intptr_t>(pointer);
+    if (added.insert(address).second) {
+      references.push_back(address);
+    }
+  };
+
+  add(&nativeConstructorCallback);
+  add(&staticFunctionCallback);
+  add(&staticPropertyGetter);
+  add(&staticPropertySetter);
+  add(&readOnlyPropertySetter);
+  add(&instanceFunctionCallback);
+  add(&instancePropertyGetter);
+  add(&instancePropertySetter);
+
+  for (auto classData : snapshot_->nativeClasses) {
+    auto classDefine = classData->classDefine;
+    add(classData);
+    for (auto& prop : classDefine->staticDefine.properties) add(&prop);
+    for (auto& func : classDefine->staticDefine.functions) add(&func);
+    for (auto& prop : classDefine->instanceDefine.properties) add(&prop);
+    for (auto& func : classDefine->instanceDefine.functions) add(&func);
+  }
+  references.push_back(0);
+}
+
+std::string V8Engine::createSnapshot(const std::vector<NativeRegister>& nativeClasses,
+                                     const std::function<void(V8Engine*)>& bootstrap) {
+  auto engine = new V8Engine(nullptr, nativeClasses);
+  // the engine is deleted before the blob is created, copy what we need.
+  auto externalReferences = engine->snapshot_->externalReferences;
+  auto header = snapshotHeader(engine->snapshot_->nativeClasses.size(), externalReferences.size());
+
+  v8::SnapshotCreator creator(externalReferences.data());
+  auto isolate = creator.GetIsolate();
+  engine->isolate_ = isolate;
+  // the isolate is owned by the SnapshotCreator
+  engine->isOwnIsolate_ = false;
+  engine->v8Platform_->addEngineInstance(isolate, engine);
+
+  auto releaseEngine = [engine, isolate]() {
+    auto platform = engine->v8Platform_;
+    engine->destroy();
+    platform->removeEngineInstance(isolate);
+  };
+
+  try {
+    engine->initContext();
+    EngineScope scope(engine);
+    for (auto classData : engine->snapshot_->nativeClasses) {
+      engine->defineNativeClass(classData->classDefine, classData->instanceTypeToScriptClass);
+    }
+    if (bootstrap) {
+      bootstrap(engine);
+    }
+
+    // collect garbage native objects, the remaining ones are not serializable.
+    isolate->LowMemoryNotification();
+    if (engine->managedObjects_) {
+      throw Exception(
+          "can't create snapshot with native objects alive (native functions or instances)");
+    }
+
+    creator.SetDefaultContext(engine->context_.Get(isolate));
+    auto checkIndex = [](size_t index, size_t expected) {
+      if (index != expected) {
+        throw Exception("unexpected snapshot data index");
+      }
+    };
+    checkIndex(creator.AddData(engine->internalStoreSymbol_.Get(isolate)),
+               kSnapshotDataInternalStoreSymbol);
+    checkIndex(creator.AddData(engine->constructorMarkSymbol_.Get(isolate)),
+               kSnapshotDataConstructorMarkSymbol);
+    auto index = kSnapshotDataNativeClassBegin;
+    for (auto classData : engine->snapshot_->nativeClasses) {
+      checkIndex(creator.AddData(classData->functionTemplate.Get(isolate)), index++);
+    }
+  } catch (const Exception& e) {
+    // the exception may refer to the isolate, which is going to be disposed.
+    auto message = e.message();
+    releaseEngine();
+    throw Exception(message);
+  } catch (...) {
+    releaseEngine();
+    throw;
+  }
+
+  // SnapshotCreator requires all handles to be released.
+  releaseEngine();
+
+  v8::StartupData blob{nullptr, 0};
+  {
+    v8::Locker locker(isolate);
+    blob = creator.CreateBlob(v8::SnapshotCreator::FunctionCodeHandling::kClear);
+  }
+  std::unique_ptr<const char[]> blobData(blob.data);
+  if (blob.data == nullptr || blob.raw_size <= 0) {
+    throw Exception("failed to create snapshot");
+  }
+  header.append(blob.data, static_cast<size_t>(blob.raw_size));
+  return header;
+}
+
+void V8Engine::setCodeCache(std::shared_ptr<utils::CodeCache> codeCache) {
+  codeCache_ = std::move(codeCache);
+}
+
+std::shared_ptr<utils::CodeCache> V8Engine::getCodeCache() const { return codeCache_; }
+
+void V8Engine::scheduleMicrotaskCheckpoint() {
+  if (microtaskPolicy_.mode == MicrotaskPolicy::Mode::kExplicit) {
+    return;
+  }
+  bool expected = false;
+  if (microtaskCheckpointScheduled_.compare_exchange_strong(expected, true)) {
+    utils::Message checkpoint(
+        [](auto& msg) {
+          auto engine = static_cast<V8Engine*>(msg.ptr0);
+          engine->microtaskCheckpointScheduled_ = false;
+          engine->performMicrotaskCheckpoint();
+        },
+        nullptr);
+
+    checkpoint.name = "MicrotaskCheckpoint";
+    checkpoint.ptr0 = this;
+    checkpoint.tag = this;
+    messageQueue_->postMessage(checkpoint);
+  }
+}
+
+void V8Engine::setMicrotaskPolicy(const MicrotaskPolicy& policy) {
+  ScriptEngine::setMicrotaskPolicy(policy);
+  EngineScope engineScope(this);
+  isolate_->SetMicrotasksPolicy(policy.mode == MicrotaskPolicy::Mode::kExplicit
+                                    ? v8::MicrotasksPolicy::kExplicit
+                                    : v8::MicrotasksPolicy::kAuto);
+}
+
+bool V8Engine::performMicrotaskCheckpoint() {
+  EngineScope engineScope(this);
+  internal::ExecutionScope executionScope(this);
+  // V8 can't stop in the middle of a checkpoint, nor tell how many jobs it runs
+  return runMicrotasks([this](size_t, bool& hasMore) -> size_t {
+    isolate_->PerformMicrotaskCheckpoint();
+    hasMore = false;
+    return kUnknownJobCount;
+  });
+}
+
 std::shared_ptr<script::utils::MessageQueue> V8Engine::messageQueue() { return messageQueue_; }
 
 ScriptLanguage V8Engine::getLanguageType() { return ScriptLanguage::kJavaScript; }
@@ -151,6 +445,7 @@ void V8Engine::set(const script::Local<script::String>& key,
 
 Local<Value> V8Engine::eval(const Local<String>& script, const Local<Value>& sourceFile) {
   Tracer trace(this, "V8Engine::eval");
+  internal::ExecutionScope executionScope(this);
   v8::TryCatch tryCatch(isolate_);
   auto context = context_.Get(isolate_);
   v8::Local<v8::String> scriptString = toV8(isolate_, script);
@@ -164,6 +459,9 @@ Local<Value> V8Engine::eval(const Local<String>& script, const Local<Value>& sou
 #endif
       sourceFile.isNull() || !sourceFile.isString() ? v8::Local<v8::String>()
                                                     : toV8(isolate_, sourceFile.asString()));
+  if (codeCache_) {
+    return evalWithCodeCache(tryCatch, context, scriptString, origin);
+  }
   v8::MaybeLocal<v8::Script> maybeScript = v8::Script::Compile(context, scriptString, &origin);
   v8_backend::checkException(tryCatch);
   auto maybeResult = maybeScript.ToLocalChecked()->Run(context);
@@ -171,12 +469,110 @@ Local<Value> V8Engine::eval(const Local<String>& script, const Local<Value>& sou
   return make<Local<Value>>(maybeResult.ToLocalChecked());
 }
 
+Local<Value> V8Engine::evalWithCodeCache(v8::TryCatch& tryCatch, v8::Local<v8::Context> context,
+                                         v8::Local<v8::String> scriptString,
+                                         const v8::ScriptOrigin& origin) {
+  std::string key;
+  {
+    v8::String::Utf8Value source(isolate_, scriptString);
+    key = utils::CodeCache::hashKey(std::string_view(*source, source.length()),
+                                    v8::V8::GetVersion());
+  }
+
+  std::string cachedData;
+  bool found = codeCache_->load(key, cachedData);
+
+  // Source owns the CachedData, but not the buffer (BufferNotOwned)
+  v8::ScriptCompiler::Source source(
+      scriptString, origin,
+      found ? new v8::ScriptCompiler::CachedData(
+                  reinterpret_cast<const uint8_t*>(cachedData.data()),
+                  static_cast<int>(cachedData.size()))
+            : nullptr);
+  v8::MaybeLocal<v8::Script> maybeScript = v8::ScriptCompiler::Compile(
+      context, &source,
+      found ? v8::ScriptCompiler::kConsumeCodeCache : v8::ScriptCompiler::kNoCompileOptions);
+  v8_backend::checkException(tryCatch);
+
+  bool produceCache = true;
+  if (!found) {
+    codeCache_->recordMiss();
+  } else if (source.GetCachedData()->rejected) {
+    codeCache_->recordRejected();
+    codeCache_->remove(key);
+  } else {
+    codeCache_->recordHit();
+    produceCache = false;
+  }
+
+  auto compiledScript = maybeScript.ToLocalChecked();
+  auto maybeResult = compiledScript->Run(context);
+  v8_backend::checkException(tryCatch);
+
+  if (produceCache) {
+    // produce code cache after the script runs,
+    // so that lazy functions compiled during execution are included.
+    std::unique_ptr<v8::ScriptCompiler::CachedData> newCache(
+        v8::ScriptCompiler::CreateCodeCache(compiledScript->GetUnboundScript()));
+    if (newCache && newCache->length > 0) {
+      codeCache_->store(key, std::string_view(reinterpret_cast<const char*>(newCache->data),
+                                              static_cast<size_t>(newCache->length)));
+      codeCache_->recordProduced();
+    }
+  }
+  return make<Local<Value>>(maybeResult.ToLocalChecked());
+}
+
 Local<Value> V8Engine::eval(const Local<String>& script, const Local<String>& sourceFile) {
   return eval(script, sourceFile.asValue());
 }
 
 Local<Value> V8Engine::eval(const Local<String>& script) { return eval(script, {}); }
 
+void V8Engine::staticPropertyGetter(v8::Local<v8::String> /*property*/,
+                                    const v8::PropertyCallbackInfo<v8::Value>& info) {
+  auto ptr = static_cast<internal::StaticDefine::PropertyDefine*>(
+      info.Data().As<v8::External>()->Value());
+  Tracer trace(EngineScope::currentEngine(), ptr->traceName);
+  Local<Value> ret = ptr->getter();
+  try {
+    info.GetReturnValue().Set(toV8(info.GetIsolate(), ret));
+  } catch (const Exception& e) {
+    v8_backend::rethrowException(e);
+  }
+}
+
+void V8Engine::staticPropertySetter(v8::Local<v8::String> /*property*/,
+                                    v8::Local<v8::Value> value,
+                                    const v8::PropertyCallbackInfo<void>& info) {
+  auto ptr = static_cast<internal::StaticDefine::PropertyDefine*>(
+      info.Data().As<v8::External>()->Value());
+  Tracer trace(EngineScope::currentEngine(), ptr->traceName);
+  try {
+    ptr->setter(make<Local<Value>>(value));
+  } catch (const Exception& e) {
+    v8_backend::rethrowException(e);
+  }
+}
+
+void V8Engine::readOnlyPropertySetter(v8::Local<v8::String> /*property*/,
+                                      v8::Local<v8::Value> /*value*/,
+                                      const v8::PropertyCallbackInfo<void>& /*info*/) {}
+
+void V8Engine::staticFunctionCallback(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  auto funcDef = reinterpret_cast<internal::StaticDefine::FunctionDefine*>(
+      info.Data().As<v8::External>()->Value());
+  auto engine = v8_backend::currentEngine();
+  Tracer trace(engine, funcDef->traceName);
+
+  try {
+    auto returnVal = (funcDef->callback)(extractV8Arguments(engine, info));
+    info.GetReturnValue().Set(v8_backend::V8Engine::toV8(info.GetIsolate(), returnVal));
+  } catch (Exception& e) {
+    v8_backend::rethrowException(e);
+  }
+}
+
 void V8Engine::registerNativeClassStatic(v8::Local<v8::FunctionTemplate> funcT,
                                          const internal::StaticDefine* staticDefine) {
   for (auto& prop : staticDefine->properties) {
@@ -187,37 +583,15 @@ void V8Engine::registerNativeClassStatic(v8::Local<v8::FunctionTemplate> funcT,
     v8::AccessorSetterCallback setter = nullptr;
 
     if (prop.getter) {
-      getter = [](v8::Local<v8::String> /*property*/,
-                  const v8::PropertyCallbackInfo<v8::Value>& info) {
-        auto ptr = static_cast<internal::StaticDefine::PropertyDefine*>(
-            info.Data().As<v8::External>()->Value());
-        Tracer trace(EngineScope::currentEngine(), ptr->traceName);
-        Local<Value> ret = ptr->getter();
-        try {
-          info.GetReturnValue().Set(toV8(info.GetIsolate(), ret));
-        } catch (const Exception& e) {
-          v8_backend::rethrowException(e);
-        }
-      };
+      getter = &staticPropertyGetter;
     }
 
     if (prop.setter) {
-      setter = [](v8::Local<v8::String> /*property*/, v8::Local<v8::Value> value,
-                  const v8::PropertyCallbackInfo<void>& info) {
-        auto ptr = static_cast<internal::StaticDefine::PropertyDefine*>(
-            info.Data().As<v8::External>()->Value());
-        Tracer trace(EngineScope::currentEngine(), ptr->traceName);
-        try {
-          ptr->setter(make<Local<Value>>(value));
-        } catch (const Exception& e) {
-          v8_backend::rethrowException(e);
-        }
-      };
+      setter = &staticPropertySetter;
     } else {
       // v8 requires setter to be present, otherwise, a real js set code with create a new
       // property...
-      setter = [](v8::Local<v8::String> property, v8::Local<v8::Value> value,
-                  const v8::PropertyCallbackInfo<void>& info) {};
+      setter = &readOnlyPropertySetter;
     }
 
     funcT->SetNativeDataProperty(
@@ -231,20 +605,7 @@ void V8Engine::registerNativeClassStatic(v8::Local<v8::FunctionTemplate> funcT,
     auto name = String::newString(func.name);
 
     auto fn = v8::FunctionTemplate::New(
-        isolate_,
-        [](const v8::FunctionCallbackInfo<v8::Value>& info) {
-          auto funcDef = reinterpret_cast<internal::StaticDefine::FunctionDefine*>(
-              info.Data().As<v8::External>()->Value());
-          auto engine = v8_backend::currentEngine();
-          Tracer trace(engine, funcDef->traceName);
-
-          try {
-            auto returnVal = (funcDef->callback)(extractV8Arguments(engine, info));
-            info.GetReturnValue().Set(v8_backend::V8Engine::toV8(info.GetIsolate(), returnVal));
-          } catch (Exception& e) {
-            v8_backend::rethrowException(e);
-          }
-        },
+        isolate_, &staticFunctionCallback,
         v8::External::New(isolate_, const_cast<internal::StaticDefine::FunctionDefine*>(&func)), {},
         0, v8::ConstructorBehavior::kThrow);
     if (!fn.IsEmpty()) {
@@ -263,12 +624,114 @@ void V8Engine::gc() {
 
 size_t V8Engine::getHeapSize() {
   EngineScope engineScope(this);
+  return heapUsage();
+}
+
+size_t V8Engine::heapUsage() {
   v8::HeapStatistics heapStatistics;
   isolate_->GetHeapStatistics(&heapStatistics);
   return heapStatistics.used_heap_size() + heapStatistics.malloced_memory() +
          heapStatistics.external_memory();
 }
 
+bool V8Engine::performIdleGc(std::chrono::steady_clock::time_point deadline) {
+#if SCRIPTX_V8_VERSION_AT_MOST(11, 0)
+  if (v8Platform_) {
+    // the deadline is in the timebase of the platform
+    auto budget = std::chrono::duration<double>(deadline - std::chrono::steady_clock::now());
+    auto done = isolate_->IdleNotificationDeadline(v8Platform_->MonotonicallyIncreasingTime() +
+                                                   budget.count());
+    if (done) {
+      idleGcCycles_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return !done;
+  }
+#endif
+  // a short idle period is not worth a hint, the next one may be longer
+  if (deadline - std::chrono::steady_clock::now() < kMinIdleGcBudget) {
+    return false;
+  }
+  // only when there is enough garbage to be worth it. kModerate starts incremental marking
+  // instead of the blocking full GC of LowMemoryNotification.
+  auto usage = heapUsage();
+  if (usage > idleGcHeapUsage_ + idleGcHeapUsage_ / 10) {
+    isolate_->MemoryPressureNotification(v8::MemoryPressureLevel::kModerate);
+    idleGcHeapUsage_ = usage;
+    idleGcCycles_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return false;
+}
+
+void V8Engine::setHeapLimit(const HeapLimit& limit) {
+  ScriptEngine::setHeapLimit(limit);
+  if (!heapLimitCallbacksAdded_) {
+    EngineScope engineScope(this);
+    addHeapLimitCallbacks();
+  }
+}
+
+void V8Engine::addHeapLimitCallbacks() {
+  // the isolate's own limit belongs to its owner (not slave engines or node.js),
+  // and V8 removes a NearHeapLimitCallback by the function only.
+  if (isOwnIsolate_) {
+    isolate_->AddNearHeapLimitCallback(&V8Engine::onNearHeapLimit, this);
+    // the raised limit is restored once the heap shrinks
+    isolate_->AutomaticallyRestoreInitialHeapLimit();
+  }
+  isolate_->AddGCEpilogueCallback(&V8Engine::onGCEpilogue, this);
+  heapLimitCallbacksAdded_ = true;
+}
+
+void V8Engine::removeHeapLimitCallbacks() {
+  if (isOwnIsolate_) {
+    isolate_->RemoveNearHeapLimitCallback(&V8Engine::onNearHeapLimit, 0);
+  }
+  isolate_->RemoveGCEpilogueCallback(&V8Engine::onGCEpilogue, this);
+  heapLimitCallbacksAdded_ = false;
+}
+
+size_t V8Engine::onNearHeapLimit(void* data, size_t currentHeapLimit,
+                                 size_t /*initialHeapLimit*/) {
+  auto engine = static_cast<V8Engine*>(data);
+  engine->terminateForHeapLimit(engine->heapUsage());
+  // V8 crashes if the limit is not raised, give the termination some room to unwind
+  return currentHeapLimit + currentHeapLimit / 2;
+}
+
+void V8Engine::onGCEpilogue(v8::Isolate* isolate, v8::GCType /*type*/,
+                            v8::GCCallbackFlags /*flags*/, void* data) {
+  auto engine = static_cast<V8Engine*>(data);
+  auto usage = engine->heapUsage();
+  engine->updateHeapUsage(usage);
+
+  auto hardLimit = engine->heapLimit_.hardLimit;
+  if (hardLimit != 0 && usage > hardLimit && !engine->heapLimitTerminationPending_ &&
+      !isolate->IsExecutionTerminating()) {
+    engine->terminateForHeapLimit(usage);
+  }
+}
+
+void V8Engine::terminateForHeapLimit(size_t usage) {
+  heapLimitTerminationPending_ = true;
+  isolate_->TerminateExecution();
+  notifyHeapLimitReached(usage);
+}
+
+void V8Engine::requestInterrupt() { isolate_->TerminateExecution(); }
+
+void V8Engine::beginExecution(bool /*timeoutEnabled*/) {
+  // an interrupt coming after the previous execution returned is still pending in V8, drop it.
+  // but a GC between executions may have hit the heap limit, that one stops this execution.
+  if (!heapLimitTerminationPending_) {
+    isolate_->CancelTerminateExecution();
+  }
+}
+
+void V8Engine::endExecution() {
+  heapLimitTerminationPending_ = false;
+  isolate_->CancelTerminateExecution();
+}
+
 void V8Engine::adjustAssociatedMemory(int64_t count) {
   if (isDestroying()) return;
   EngineScope engineScope(this);
@@ -276,37 +739,65 @@ void V8Engine::adjustAssociatedMemory(int64_t count) {
 }
 
 void V8Engine::addManagedObject(void* nativeObj, v8::Local<v8::Value> obj,
-                                std::function<void(void*)>&& proc) {
-  auto data = std::make_unique<ManagedObject>();
-  data->engine = this;
-  data->data = nativeObj;
-  data->cleanupFunc = std::move(proc);
-  v8::Global<v8::Value> weak(isolate_, obj);
-
-  weak.SetWeak(
-      static_cast<void*>(data.get()),
-      [](const v8::WeakCallbackInfo<void>& info) {
-        auto param = static_cast<ManagedObject*>(info.GetParameter());
-        auto engine = param->engine;
-        {
+                                void (*cleanupFunc)(void*)) {
+  auto object = managedObjectPool_.obtain();
+  object->engine = this;
+  object->data = nativeObj;
+  object->cleanupFunc = cleanupFunc;
+  object->weak.Reset(isolate_, obj);
+
+  object->weak.SetWeak(
+      object,
+      [](const v8::WeakCallbackInfo<ManagedObject>& info) {
+        auto object = info.GetParameter();
+        auto engine = object->engine;
+        v8::Locker lk(engine->isolate_);
+        object->weak.Reset();
+        unlinkManagedObject(engine->managedObjects_, object);
+        linkManagedObject(engine->pendingManagedObjects_, object);
+
+        info.SetSecondPassCallback([](const v8::WeakCallbackInfo<ManagedObject>& data) {
+          auto object = data.GetParameter();
+          auto engine = object->engine;
+          if (engine == nullptr) {
+            // the engine is destroyed meanwhile, and has called cleanupFunc
+            delete object;
+            return;
+          }
           v8::Locker lk(engine->isolate_);
-          auto it = engine->managedObject_.find(param);
-          assert(it != engine->managedObject_.end());
-          engine->managedObject_.erase(it);
-
-          info.SetSecondPassCallback([](const v8::WeakCallbackInfo<void>& data) {
-            auto param = static_cast<ManagedObject*>(data.GetParameter());
-            auto engine = param->engine;
-            v8::Locker lk(engine->isolate_);
-
-            param->cleanupFunc(param->data);
-            delete param;
-          });
-        }
+
+          unlinkManagedObject(engine->pendingManagedObjects_, object);
+          object->cleanupFunc(object->data);
+          engine->managedObjectPool_.release(object);
+        });
       },
       v8::WeakCallbackType::kParameter);
 
-  managedObject_.emplace(data.release(), std::move(weak));
+  linkManagedObject(managedObjects_, object);
+}
+
+void V8Engine::linkManagedObject(ManagedObject*& list, ManagedObject* object) {
+  // push front
+  object->prev = nullptr;
+  object->next = list;
+  if (list) {
+    list->prev = object;
+  }
+  list = object;
+}
+
+void V8Engine::unlinkManagedObject(ManagedObject*& list, ManagedObject* object) {
+  if (object->prev) {
+    object->prev->next = object->next;
+  } else {
+    assert(list == object);
+    list = object->next;
+  }
+  if (object->next) {
+    object->next->prev = object->prev;
+  }
+  object->prev = nullptr;
+  object->next = nullptr;
 }
 
 size_t V8Engine::keepReference(const Local<Value>& ref) {
@@ -328,16 +819,33 @@ constexpr int kInstanceObjectAlignedPointer_PolymorphicPointer = 0;  // the actu
 void V8Engine::performRegisterNativeClass(
     internal::TypeIndex typeIndex, const internal::ClassDefineState* classDefine,
     script::ScriptClass* (*instanceTypeToScriptClass)(void*)) {
+  if (snapshot_ && snapshot_->collecting) {
+    // FunctionTemplates are created later, or deserialized from snapshot.
+    auto& classData = nativeRegistry_[classDefine];
+    classData.classDefine = classDefine;
+    classData.instanceTypeToScriptClass = instanceTypeToScriptClass;
+    snapshot_->nativeClasses.push_back(&classData);
+    return;
+  }
+  defineNativeClass(classDefine, instanceTypeToScriptClass);
+}
+
+void V8Engine::defineNativeClass(const internal::ClassDefineState* classDefine,
+                                 script::ScriptClass* (*instanceTypeToScriptClass)(void*)) {
   StackFrameScope stack;
   v8::TryCatch tryCatch(isolate_);
 
   Local<Object> nameSpaceObj =
       ::script::internal::getNamespaceObject(this, classDefine->nameSpace, getGlobal()).asObject();
 
+  auto& classData = nativeRegistry_[classDefine];
+  classData.classDefine = classDefine;
+  classData.instanceTypeToScriptClass = instanceTypeToScriptClass;
+
   v8::Local<v8::FunctionTemplate> funcT;
 
   if (classDefine->hasInstanceDefine()) {
-    funcT = newConstructor(classDefine, instanceTypeToScriptClass);
+    funcT = newConstructor(&classData);
   } else {
     funcT =
         v8::FunctionTemplate::New(isolate_, nullptr, {}, {}, 0, v8::ConstructorBehavior::kThrow);
@@ -353,99 +861,132 @@ void V8Engine::performRegisterNativeClass(
   auto function = funcT->GetFunction(v8_backend::currentEngineContextChecked());
   v8_backend::checkException(tryCatch);
 
-  auto global = v8::Global<v8::FunctionTemplate>(isolate_, funcT);
-  nativeRegistry_.emplace(classDefine, std::move(global));
+  classData.functionTemplate.Reset(isolate_, funcT);
 
   nameSpaceObj.set(className, make<Local<Function>>(function.ToLocalChecked()));
 }
 
-v8::Local<v8::FunctionTemplate> V8Engine::newConstructor(
-    const internal::ClassDefineState* classDefine,
-    script::ScriptClass* (*instanceTypeToScriptClass)(void*)) {
-  v8::TryCatch tryCatch(isolate_);
+void V8Engine::nativeConstructorCallback(const v8::FunctionCallbackInfo<v8::Value>& args) {
+  auto classData = static_cast<NativeClassData*>(args.Data().As<v8::External>()->Value());
+  auto classDefine = classData->classDefine;
+  auto instanceTypeToScriptClass = classData->instanceTypeToScriptClass;
+  auto& constructor = classDefine->instanceDefine.constructor;
+  // don't keep engine pointer in data, it may come from a snapshot.
+  auto engine = v8_backend::currentEngine();
 
-  v8::Local<v8::Object> data = v8::Object::New(isolate_);
-  checkException(tryCatch);
-  auto context = context_.Get(isolate_);
-  auto ret =
-      data->Set(context, 0,
-                v8::External::New(isolate_, const_cast<internal::ClassDefineState*>(classDefine)));
-  (void)ret;
-  checkException(tryCatch);
-
-  ret = data->Set(context, 1, v8::External::New(isolate_, this));
-  (void)ret;
-  checkException(tryCatch);
-
-  ret = data->Set(context, 2,
-                  v8::External::New(isolate_, reinterpret_cast<void*>(instanceTypeToScriptClass)));
-  (void)ret;
-  checkException(tryCatch);
-
-  auto funcT = v8::FunctionTemplate::New(
-      isolate_,
-      [](const v8::FunctionCallbackInfo<v8::Value>& args) {
-        auto context = args.GetIsolate()->GetCurrentContext();
-        v8::Local<v8::Object> data = args.Data().As<v8::Object>();
-        auto classDefine = reinterpret_cast<internal::ClassDefineState*>(
-            data->Get(context, 0).ToLocalChecked().As<v8::External>()->Value());
-        auto engine = reinterpret_cast<V8Engine*>(
-            data->Get(context, 1).ToLocalChecked().As<v8::External>()->Value());
-        auto instanceTypeToScriptClass = reinterpret_cast<script::ScriptClass* (*)(void*)>(
-            data->Get(context, 2).ToLocalChecked().As<v8::External>()->Value());
-        auto& constructor = classDefine->instanceDefine.constructor;
-
-        Tracer trace(engine, classDefine->className.c_str());
-        try {
-          StackFrameScope stack;
-          if (!args.IsConstructCall()) {
-            throw Exception(u8"constructor can't be called as function");
-          }
-          void* ret;
-          if (args.Length() == 2 && args[0]->IsSymbol() &&
-              args[0]->StrictEquals(engine->constructorMarkSymbol_.Get(args.GetIsolate())) &&
-              args[1]->IsExternal()) {
-            // this logic is for
-            // ScriptClass::ScriptClass(ConstructFromCpp<T>)
-            ret = args[1].As<v8::External>()->Value();
-          } else {
-            // this logic is for
-            // ScriptClass::ScriptClass(const Local<Object>& thiz)
-            ret = constructor(extractV8Arguments(engine, args));
-          }
+  Tracer trace(engine, classDefine->className.c_str());
+  try {
+    StackFrameScope stack;
+    if (!args.IsConstructCall()) {
+      throw Exception(u8"constructor can't be called as function");
+    }
+    void* ret;
+    if (args.Length() == 2 && args[0]->IsSymbol() &&
+        args[0]->StrictEquals(engine->constructorMarkSymbol_.Get(args.GetIsolate())) &&
+        args[1]->IsExternal()) {
+      // this logic is for
+      // ScriptClass::ScriptClass(ConstructFromCpp<T>)
+      ret = args[1].As<v8::External>()->Value();
+    } else {
+      // this logic is for
+      // ScriptClass::ScriptClass(const Local<Object>& thiz)
+      ret = constructor(extractV8Arguments(engine, args));
+    }
 
-          if (ret != nullptr) {
-            ScriptClass* scriptClass = instanceTypeToScriptClass(ret);
-            scriptClass->internalState_.classDefine_ = static_cast<void*>(classDefine);
-
-            args.This()->SetAlignedPointerInInternalField(kInstanceObjectAlignedPointer_ScriptClass,
-                                                          scriptClass);
-            args.This()->SetAlignedPointerInInternalField(
-                kInstanceObjectAlignedPointer_PolymorphicPointer, ret);
-            engine->adjustAssociatedMemory(
-                static_cast<int64_t>(classDefine->instanceDefine.instanceSize));
-
-            engine->addManagedObject(scriptClass, args.This(), [](void* ptr) {
-              auto scriptClass = static_cast<ScriptClass*>(ptr);
-              auto engine = scriptClass->internalState_.scriptEngine_;
-              engine->adjustAssociatedMemory(-static_cast<int64_t>(
-                  static_cast<internal::ClassDefineState*>(scriptClass->internalState_.classDefine_)
-                      ->instanceDefine.instanceSize));
-              delete scriptClass;
-            });
-
-          } else {
-            throw Exception("can't create class " + classDefine->className);
-          }
-        } catch (Exception& e) {
-          v8_backend::rethrowException(e);
-        }
-      },
-      data);
+    if (ret != nullptr) {
+      ScriptClass* scriptClass = instanceTypeToScriptClass(ret);
+      scriptClass->internalState_.classDefine_ =
+          static_cast<void*>(const_cast<internal::ClassDefineState*>(classDefine));
+
+      args.This()->SetAlignedPointerInInternalField(kInstanceObjectAlignedPointer_ScriptClass,
+                                                    scriptClass);
+      args.This()->SetAlignedPointerInInternalField(
+          kInstanceObjectAlignedPointer_PolymorphicPointer, ret);
+      engine->adjustAssociatedMemory(
+          static_cast<int64_t>(classDefine->instanceDefine.instanceSize));
+
+      engine->addManagedObject(scriptClass, args.This(), [](void* ptr) {
+        auto scriptClass = static_cast<ScriptClass*>(ptr);
+        auto engine = scriptClass->internalState_.scriptEngine_;
+        engine->adjustAssociatedMemory(-static_cast<int64_t>(
+            static_cast<internal::ClassDefineState*>(scriptClass->internalState_.classDefine_)
+                ->instanceDefine.instanceSize));
+        delete scriptClass;
+      });
+
+    } else {
+      throw Exception("can't create class " + classDefine->className);
+    }
+  } catch (Exception& e) {
+    v8_backend::rethrowException(e);
+  }
+}
+
+v8::Local<v8::FunctionTemplate> V8Engine::newConstructor(NativeClassData* classData) {
+  auto funcT = v8::FunctionTemplate::New(isolate_, &nativeConstructorCallback,
+                                         v8::External::New(isolate_, classData));
   funcT->InstanceTemplate()->SetInternalFieldCount(1);
   return funcT;
 }
 
+void V8Engine::instancePropertyGetter(v8::Local<v8::String> /*property*/,
+                                      const v8::PropertyCallbackInfo<v8::Value>& info) {
+  auto ptr = static_cast<internal::InstanceDefine::PropertyDefine*>(
+      info.Data().As<v8::External>()->Value());
+  auto thiz = static_cast<void*>(info.This()->GetAlignedPointerFromInternalField(
+      kInstanceObjectAlignedPointer_PolymorphicPointer));
+  auto scriptClass = static_cast<ScriptClass*>(
+      info.This()->GetAlignedPointerFromInternalField(kInstanceObjectAlignedPointer_ScriptClass));
+  auto& getter = ptr->getter;
+
+  Tracer trace(scriptClass->getScriptEngine(), ptr->traceName);
+
+  Local<Value> ret = (getter)(thiz);
+  try {
+    info.GetReturnValue().Set(toV8(info.GetIsolate(), ret));
+  } catch (const Exception& e) {
+    v8_backend::rethrowException(e);
+  }
+}
+
+void V8Engine::instancePropertySetter(v8::Local<v8::String> /*property*/,
+                                      v8::Local<v8::Value> value,
+                                      const v8::PropertyCallbackInfo<void>& info) {
+  auto ptr = static_cast<internal::InstanceDefine::PropertyDefine*>(
+      info.Data().As<v8::External>()->Value());
+  auto thiz = static_cast<void*>(info.This()->GetAlignedPointerFromInternalField(
+      kInstanceObjectAlignedPointer_PolymorphicPointer));
+  auto scriptClass = static_cast<ScriptClass*>(
+      info.This()->GetAlignedPointerFromInternalField(kInstanceObjectAlignedPointer_ScriptClass));
+  auto& setter = ptr->setter;
+
+  Tracer trace(scriptClass->getScriptEngine(), ptr->traceName);
+
+  try {
+    (setter)(thiz, make<Local<Value>>(value));
+  } catch (const Exception& e) {
+    v8_backend::rethrowException(e);
+  }
+}
+
+void V8Engine::instanceFunctionCallback(const v8::FunctionCallbackInfo<v8::Value>& info) {
+  auto ptr = static_cast<internal::InstanceDefine::FunctionDefine*>(
+      info.Data().As<v8::External>()->Value());
+  auto thiz = static_cast<void*>(info.This()->GetAlignedPointerFromInternalField(
+      kInstanceObjectAlignedPointer_PolymorphicPointer));
+  auto scriptClass = static_cast<ScriptClass*>(
+      info.This()->GetAlignedPointerFromInternalField(kInstanceObjectAlignedPointer_ScriptClass));
+  auto engine = scriptClass->getScriptEngineAs<V8Engine>();
+
+  Tracer trace(engine, ptr->traceName);
+  try {
+    auto returnVal = (ptr->callback)(thiz, extractV8Arguments(engine, info));
+    info.GetReturnValue().Set(v8_backend::V8Engine::toV8(info.GetIsolate(), returnVal));
+  } catch (Exception& e) {
+    v8_backend::rethrowException(e);
+  }
+}
+
 void V8Engine::registerNativeClassInstance(v8::Local<v8::FunctionTemplate> funcT,
                                            const internal::ClassDefineState* classDefine) {
   if (!classDefine->instanceDefine.constructor) return;
@@ -461,45 +1002,11 @@ void V8Engine::registerNativeClassInstance(v8::Local<v8::FunctionTemplate> funcT
     v8::AccessorSetterCallback setter = nullptr;
 
     if (prop.getter) {
-      getter = [](v8::Local<v8::String> property, const v8::PropertyCallbackInfo<v8::Value>& info) {
-        auto ptr = static_cast<decltype(&prop)>(info.Data().As<v8::External>()->Value());
-        auto thiz = static_cast<void*>(info.This()->GetAlignedPointerFromInternalField(
-            kInstanceObjectAlignedPointer_PolymorphicPointer));
-        auto scriptClass =
-            static_cast<ScriptClass*>(info.This()->GetAlignedPointerFromInternalField(
-                kInstanceObjectAlignedPointer_ScriptClass));
-        auto& getter = ptr->getter;
-
-        Tracer trace(scriptClass->getScriptEngine(), ptr->traceName);
-
-        Local<Value> ret = (getter)(thiz);
-        try {
-          info.GetReturnValue().Set(toV8(info.GetIsolate(), ret));
-        } catch (const Exception& e) {
-          v8_backend::rethrowException(e);
-        }
-      };
+      getter = &instancePropertyGetter;
     }
 
     if (prop.setter) {
-      setter = [](v8::Local<v8::String> property, v8::Local<v8::Value> value,
-                  const v8::PropertyCallbackInfo<void>& info) {
-        auto ptr = static_cast<decltype(&prop)>(info.Data().As<v8::External>()->Value());
-        auto thiz = static_cast<void*>(info.This()->GetAlignedPointerFromInternalField(
-            kInstanceObjectAlignedPointer_PolymorphicPointer));
-        auto scriptClass =
-            static_cast<ScriptClass*>(info.This()->GetAlignedPointerFromInternalField(
-                kInstanceObjectAlignedPointer_ScriptClass));
-        auto& setter = ptr->setter;
-
-        Tracer trace(scriptClass->getScriptEngine(), ptr->traceName);
-
-        try {
-          (setter)(thiz, make<Local<Value>>(value));
-        } catch (const Exception& e) {
-          v8_backend::rethrowException(e);
-        }
-      };
+      setter = &instancePropertySetter;
     }
 
     auto v8Name = toV8(isolate_, name);
@@ -520,26 +1027,9 @@ void V8Engine::registerNativeClassInstance(v8::Local<v8::FunctionTemplate> funcT
     StackFrameScope stack;
     auto name = String::newString(func.name);
     using FuncDefPtr = typename internal::InstanceDefine::FunctionDefine*;
-    auto fn = v8::FunctionTemplate::New(
-        isolate_,
-        [](const v8::FunctionCallbackInfo<v8::Value>& info) {
-          auto ptr = static_cast<FuncDefPtr>(info.Data().As<v8::External>()->Value());
-          auto thiz = static_cast<void*>(info.This()->GetAlignedPointerFromInternalField(
-              kInstanceObjectAlignedPointer_PolymorphicPointer));
-          auto scriptClass =
-              static_cast<ScriptClass*>(info.This()->GetAlignedPointerFromInternalField(
-                  kInstanceObjectAlignedPointer_ScriptClass));
-          auto engine = scriptClass->getScriptEngineAs<V8Engine>();
-
-          Tracer trace(engine, ptr->traceName);
-          try {
-            auto returnVal = (ptr->callback)(thiz, extractV8Arguments(engine, info));
-            info.GetReturnValue().Set(v8_backend::V8Engine::toV8(info.GetIsolate(), returnVal));
-          } catch (Exception& e) {
-            v8_backend::rethrowException(e);
-          }
-        },
-        v8::External::New(isolate_, const_cast<FuncDefPtr>(&func)), signature);
+    auto fn = v8::FunctionTemplate::New(isolate_, &instanceFunctionCallback,
+                                        v8::External::New(isolate_, const_cast<FuncDefPtr>(&func)),
+                                        signature);
     if (!fn.IsEmpty()) {
       funcT->PrototypeTemplate()->Set(toV8(isolate_, name), fn, v8::PropertyAttribute::DontDelete);
     } else {
@@ -552,13 +1042,13 @@ Local<Object> V8Engine::performNewNativeClass(internal::TypeIndex typeIndex,
                                               const internal::ClassDefineState* classDefine,
                                               size_t size, const Local<script::Value>* args) {
   auto it = nativeRegistry_.find(classDefine);
-  if (it == nativeRegistry_.end()) {
+  if (it == nativeRegistry_.end() || it->second.functionTemplate.IsEmpty()) {
     throw Exception("class define[" + classDefine->className + "] is not registered");
   }
 
   auto context = context_.Get(isolate_);
   v8::TryCatch tryCatch(isolate_);
-  auto funcT = it->second.Get(isolate_);
+  auto funcT = it->second.functionTemplate.Get(isolate_);
   auto function = funcT->GetFunction(context);
   v8_backend::checkException(tryCatch);
 
@@ -573,8 +1063,8 @@ Local<Object> V8Engine::performNewNativeClass(internal::TypeIndex typeIndex,
 bool V8Engine::performIsInstanceOf(const Local<script::Value>& value,
                                    const internal::ClassDefineState* classDefine) {
   auto it = nativeRegistry_.find(classDefine);
-  if (it != nativeRegistry_.end()) {
-    auto funcT = it->second.Get(isolate_);
+  if (it != nativeRegistry_.end() && !it->second.functionTemplate.IsEmpty()) {
+    auto funcT = it->second.functionTemplate.Get(isolate_);
     return funcT->HasInstance(toV8(isolate_, value));
   }
   return false;
@@ -17,13 +17,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 #include "../../src/Engine.h"
 #include "../../src/Native.h"
 #include "../../src/Reference.h"
 #include "../../src/Scope.h"
 #include "../../src/Value.h"
+#include "../../src/utils/CodeCache.h"
 #include "../../src/utils/GlobalWeakBookkeeping.hpp"
+#include "../../src/utils/MemoryPool.hpp"
 #include "V8Helper.h"
 #include "V8Platform.h"
 
@@ -32,10 +37,16 @@ namespace script::v8_backend {
 class InspectorClient;
 
 class V8Engine : public ::script::ScriptEngine {
+  // an intrusive record of native object whose lifetime is tied to a v8 object.
   struct ManagedObject {
-    V8Engine* engine;
-    void* data;
-    std::function<void(void*)> cleanupFunc;
+    V8Engine* engine = nullptr;
+    void* data = nullptr;
+    void (*cleanupFunc)(void*) = nullptr;
+    v8::Global<v8::Value> weak;
+
+    // linked in managedObjects_ or pendingManagedObjects_
+    ManagedObject* prev = nullptr;
+    ManagedObject* next = nullptr;
   };
 
   struct ThreadGlobalScope {
@@ -48,27 +59,55 @@ class V8Engine : public ::script::ScriptEngine {
   bool isOwnIsolate_ = true;
   // used only for node addon
   std::unique_ptr<ThreadGlobalScope> threadGlobalScope_ = nullptr;
-  std::unordered_map<const void*, v8::Global<v8::FunctionTemplate>> nativeRegistry_;
+  // per native class data, passed to the constructor callback as one v8::External
+  struct NativeClassData {
+    const internal::ClassDefineState* classDefine = nullptr;
+    script::ScriptClass* (*instanceTypeToScriptClass)(void*) = nullptr;
+    v8::Global<v8::FunctionTemplate> functionTemplate;
+  };
+  // key: ClassDefineState*
+  // node based map, so that the address of NativeClassData is stable.
+  std::unordered_map<const void*, NativeClassData> nativeRegistry_;
   std::shared_ptr<V8Platform> v8Platform_;
-  std::unique_ptr<v8::ArrayBuffer::Allocator> allocator_;
+  // shared with the backing stores, they may outlive the engine when transferred (see Serializer)
+  std::shared_ptr<v8::ArrayBuffer::Allocator> allocator_;
 
   std::shared_ptr<::script::utils::MessageQueue> messageQueue_;
 
   // V8 don't do gc on Isolate::Dispose,
   // so we must got a way to manage native object.
-  // key: native pointer
-  // value: v8 weak
-  std::unordered_map<ManagedObject*, v8::Global<v8::Value>> managedObject_;
+  // all ManagedObject are linked, and recycled by the pool.
+  // they are only accessed with the isolate locked, so the pool is not thread-safe.
+  ManagedObject* managedObjects_ = nullptr;
+  // collected, waiting for the second pass callback to call cleanupFunc
+  ManagedObject* pendingManagedObjects_ = nullptr;
+  utils::MemoryPool<ManagedObject, false> managedObjectPool_{1024};
 
   std::unordered_map<size_t, v8::Global<v8::Value>> keptObject_;
   size_t keptObjectId_ = 0;
   bool isDestroying_ = false;
+  std::atomic_bool microtaskCheckpointScheduled_ = false;
+  bool heapLimitCallbacksAdded_ = false;
+  // TerminateExecution by the heap limit, kept for the next execution if none is running
+  bool heapLimitTerminationPending_ = false;
+  // heap usage after the last idle GC, see performIdleGc
+  size_t idleGcHeapUsage_ = 0;
 
   internal::GlobalWeakBookkeeping globalWeakBookkeeping_;
 
+  std::shared_ptr<utils::CodeCache> codeCache_;
+
+  // see createSnapshot
+  struct SnapshotState;
+  std::unique_ptr<SnapshotState> snapshot_;
+
   // create a slave engine
   explicit V8Engine(V8Engine* masterEngine);
 
+  // create an engine without isolate, only collect the native classes for snapshot
+  V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue,
+           const std::vector<NativeRegister>& nativeClasses);
+
  protected:
   v8::Isolate* isolate_;
 
@@ -100,6 +139,44 @@ class V8Engine : public ::script::ScriptEngine {
   explicit V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue, v8::Isolate* isolate,
                     v8::Local<v8::Context> context, bool addGlobalEngineScope = true);
 
+  /**
+   * Create an engine with v8::ResourceConstraints configured for heapLimit.hardLimit,
+   * so that V8 sizes the heap for it, then setHeapLimit(heapLimit).
+   */
+  V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue, const HeapLimit& heapLimit);
+
+  /**
+   * Create an engine from a startup snapshot created by createSnapshot.
+   * The global context, native classes and everything the bootstrap did are deserialized
+   * from the snapshot instead of being built again.
+   *
+   * @param snapshot the snapshot returned by createSnapshot
+   * @param nativeClasses MUST be the same classes (in the same order) passed to createSnapshot,
+   * they are registered to this engine without creating the FunctionTemplates again.
+   * @throw Exception if the snapshot is created by another V8 version or with different classes.
+   */
+  V8Engine(std::shared_ptr<utils::MessageQueue> messageQueue, std::string_view snapshot,
+           const std::vector<NativeRegister>& nativeClasses);
+
+  /**
+   * Create a V8 startup snapshot (v8::SnapshotCreator).
+   *
+   * A temporary engine is created, nativeClasses are registered to it, and then bootstrap is
+   * called (with EngineScope entered) to eval bootstrap scripts. The resulting context is
+   * serialized to the snapshot.
+   *
+   * Limitations:
+   * 1. bootstrap can't leave native objects alive in the context, that is, functions created by
+   * Function::newFunction, and instances of native classes. (throw Exception if any)
+   * 2. Global/Weak references created in bootstrap are reset.
+   *
+   * @param nativeClasses native classes to register
+   * @param bootstrap optional, do additional initialization
+   * @return the snapshot, use it with V8Engine(messageQueue, snapshot, nativeClasses)
+   */
+  static std::string createSnapshot(const std::vector<NativeRegister>& nativeClasses,
+                                    const std::function<void(V8Engine*)>& bootstrap = {});
+
   void destroy() noexcept override;
 
   bool isDestroying() const override;
@@ -124,6 +201,45 @@ class V8Engine : public ::script::ScriptEngine {
    */
   UniqueEnginePtr newSlaveEngine();
 
+  /**
+   * Enable code cache for eval. (disabled by default)
+   *
+   * When enabled, eval looks up the cache by the hash of script source (and V8 version),
+   * and compiles with the cached data if any. Otherwise (or if V8 rejects the cached data)
+   * a fresh code cache is produced AFTER the script runs, so functions compiled lazily during
+   * the first run are included, and written back to the cache.
+   *
+   * see CodeCache::getStatistics for hit/miss/rejected counters.
+   *
+   * @param codeCache the cache to use, can be shared by multiple engines. null to disable.
+   */
+  void setCodeCache(std::shared_ptr<utils::CodeCache> codeCache);
+
+  std::shared_ptr<utils::CodeCache> getCodeCache() const;
+
+  /**
+   * run microtasks (eg: promise reactions) in a message on the messageQueue.
+   * V8 runs microtasks when the outermost script call returns, this is for the microtasks
+   * queued by native code outside of script calls, see Promise::Resolver.
+   * does nothing if the policy is kExplicit.
+   */
+  void scheduleMicrotaskCheckpoint();
+
+  /**
+   * kAuto maps to v8::MicrotasksPolicy::kAuto, kExplicit to v8::MicrotasksPolicy::kExplicit.
+   * the budget is ignored, V8 always drains all jobs in a checkpoint.
+   */
+  void setMicrotaskPolicy(const MicrotaskPolicy& policy) override;
+
+  bool performMicrotaskCheckpoint() override;
+
+  /**
+   * the hardLimit is checked after each GC. when it is exceeded, or V8 runs into its own heap
+   * limit (AddNearHeapLimitCallback), the execution is terminated, and TerminationException is
+   * thrown to the outermost native caller. the termination can't be caught by script.
+   */
+  void setHeapLimit(const HeapLimit& limit) override;
+
   std::shared_ptr<::script::utils::MessageQueue> messageQueue() override;
 
   void gc() override;
@@ -151,14 +267,57 @@ class V8Engine : public ::script::ScriptEngine {
                                       const internal::ClassDefineState* classDefine, size_t size,
                                       const Local<script::Value>* args) override;
 
+  /**
+   * TerminateExecution, thread-safe.
+   */
+  void requestInterrupt() override;
+
+  void beginExecution(bool timeoutEnabled) override;
+
+  void endExecution() override;
+
+  /**
+   * IdleNotificationDeadline with the platform of V8 up to 11.0. Otherwise (newer V8, or an
+   * isolate from outside) MemoryPressureNotification(kModerate) once the heap grew 10%, which
+   * starts incremental marking and returns; it's skipped when less than kMinIdleGcBudget is left.
+   */
+  bool performIdleGc(std::chrono::steady_clock::time_point deadline) override;
+
  private:
+  /**
+   * the shortest idle period the MemoryPressureNotification fallback of performIdleGc runs in
+   */
+  static constexpr std::chrono::milliseconds kMinIdleGcBudget{1};
+
   void initContext();
 
+  void setArrayBufferAllocator(v8::Isolate::CreateParams& createParams);
+
+  void addHeapLimitCallbacks();
+
+  void removeHeapLimitCallbacks();
+
+  static size_t onNearHeapLimit(void* data, size_t currentHeapLimit, size_t initialHeapLimit);
+
+  static void onGCEpilogue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags,
+                           void* data);
+
+  void terminateForHeapLimit(size_t usage);
+
+  size_t heapUsage();
+
   Local<Value> eval(const Local<String>& script, const Local<Value>& sourceFile);
 
-  v8::Local<v8::FunctionTemplate> newConstructor(
-      const internal::ClassDefineState* classDefine,
-      script::ScriptClass* (*instanceTypeToScriptClass)(void*));
+  Local<Value> evalWithCodeCache(v8::TryCatch& tryCatch, v8::Local<v8::Context> context,
+                                 v8::Local<v8::String> scriptString,
+                                 const v8::ScriptOrigin& origin);
+
+  void collectSnapshotClasses(const std::vector<NativeRegister>& nativeClasses);
+
+  void defineNativeClass(const internal::ClassDefineState* classDefine,
+                         script::ScriptClass* (*instanceTypeToScriptClass)(void*));
+
+  v8::Local<v8::FunctionTemplate> newConstructor(NativeClassData* classData);
 
   void registerNativeClassStatic(v8::Local<v8::FunctionTemplate> funcT,
                                  const internal::StaticDefine* staticDefine);
@@ -166,6 +325,29 @@ class V8Engine : public ::script::ScriptEngine {
   void registerNativeClassInstance(v8::Local<v8::FunctionTemplate> funcT,
                                    const internal::ClassDefineState* classDefine);
 
+  // callbacks of native classes,
+  // they are named functions to be listed in external references of snapshot.
+  static void nativeConstructorCallback(const v8::FunctionCallbackInfo<v8::Value>& info);
+
+  static void staticFunctionCallback(const v8::FunctionCallbackInfo<v8::Value>& info);
+
+  static void staticPropertyGetter(v8::Local<v8::String> property,
+                                   const v8::PropertyCallbackInfo<v8::Value>& info);
+
+  static void staticPropertySetter(v8::Local<v8::String> property, v8::Local<v8::Value> value,
+                                   const v8::PropertyCallbackInfo<void>& info);
+
+  static void readOnlyPropertySetter(v8::Local<v8::String> property, v8::Local<v8::Value> value,
+                                     const v8::PropertyCallbackInfo<void>& info);
+
+  static void instanceFunctionCallback(const v8::FunctionCallbackInfo<v8::Value>& info);
+
+  static void instancePropertyGetter(v8::Local<v8::String> property,
+                                     const v8::PropertyCallbackInfo<v8::Value>& info);
+
+  static void instancePropertySetter(v8::Local<v8::String> property, v8::Local<v8::Value> value,
+                                     const v8::PropertyCallbackInfo<void>& info);
+
   // the following function are public only for you to interact with raw v8 APIs.
   template <typename T, typename... Args>
   static T make(Args&&... args) {
@@ -192,8 +374,11 @@ class V8Engine : public ::script::ScriptEngine {
   }
 
  private:
-  void addManagedObject(void* nativeObj, v8::Local<v8::Value> obj,
-                        std::function<void(void*)>&& proc);
+  void addManagedObject(void* nativeObj, v8::Local<v8::Value> obj, void (*cleanupFunc)(void*));
+
+  static void linkManagedObject(ManagedObject*& list, ManagedObject* object);
+
+  static void unlinkManagedObject(ManagedObject*& list, ManagedObject* object);
 
   size_t keepReference(const Local<Value>& ref);
 
@@ -252,6 +437,8 @@ class V8Engine : public ::script::ScriptEngine {
 
   friend class ::script::StringHolder;
 
+  friend class ::script::Json;
+
   friend class ::script::ScriptClass;
 
   friend class ExceptionFields;
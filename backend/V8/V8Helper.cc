@@ -40,6 +40,17 @@ std::tuple<v8::Isolate*, v8::Local<v8::Context>> currentEngineIsolateAndContextC
 }
 
 void checkException(v8::TryCatch& tryCatch) {
+  if (tryCatch.HasTerminated()) {
+    // the termination exception is not a value, and can't be caught by script
+    auto& engine = currentEngineChecked();
+    // not interrupted means terminated by the heap limit
+    auto reason = engine.getInterruptReason().value_or(TerminationReason::kHeapLimit);
+    if (!engine.isolate_->IsExecutionTerminating()) {
+      // back to the outermost native caller, the engine can run script again
+      engine.isolate_->CancelTerminateExecution();
+    }
+    throw TerminationException(reason);
+  }
   if (tryCatch.HasCaught()) {
     throw Exception(v8_backend::V8Engine::make<Local<Value>>(tryCatch.Exception()));
   }
@@ -47,6 +58,10 @@ void checkException(v8::TryCatch& tryCatch) {
 
 void rethrowException(const Exception& exception) {
   auto isolate = v8_backend::currentEngineIsolateChecked();
+  if (isolate->IsExecutionTerminating()) {
+    // let the termination unwind the remaining script frames
+    return;
+  }
   isolate->ThrowException(v8_backend::V8Engine::toV8(isolate, exception.exception()));
 }
 
@@ -19,6 +19,7 @@
 #include <utility>
 #include "../../src/Native.hpp"
 #include "../../src/Reference.h"
+#include "../../src/Serializer.h"
 #include "../../src/Utils.h"
 #include "V8Engine.h"
 #include "V8Helper.h"
@@ -98,6 +99,10 @@ REF_IMPL_BASIC_FUNC(ByteBuffer)
 REF_IMPL_BASIC_NOT_VALUE(ByteBuffer)
 REF_IMPL_TO_VALUE(ByteBuffer)
 
+REF_IMPL_BASIC_FUNC(Promise)
+REF_IMPL_BASIC_NOT_VALUE(Promise)
+REF_IMPL_TO_VALUE(Promise)
+
 REF_IMPL_BASIC_FUNC(Unsupported)
 REF_IMPL_BASIC_NOT_VALUE(Unsupported)
 REF_IMPL_TO_VALUE(Unsupported)
@@ -162,6 +167,13 @@ Local<ByteBuffer> Local<Value>::asByteBuffer() const {
   throw Exception(u8"can't cast value as ByteBuffer");
 }
 
+bool Local<Value>::isPromise() const { return !isNull() && val_->IsPromise(); }
+
+Local<Promise> Local<Value>::asPromise() const {
+  if (isPromise()) return Local<Promise>(val_.As<v8::Promise>());
+  throw Exception(u8"can't cast value as Promise");
+}
+
 bool Local<Value>::isString() const { return !isNull() && val_->IsString(); }
 
 Local<String> Local<Value>::asString() const {
@@ -310,6 +322,7 @@ bool Local<Boolean>::value() const { return val_->Value(); }
 Local<Value> Local<Function>::callImpl(const script::Local<script::Value>& thiz, size_t size,
                                        const Local<Value>* args) const {
   auto [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+  internal::ExecutionScope executionScope(&v8_backend::currentEngineChecked());
   return v8_backend::toV8ValueArray<Local<Value>>(
       isolate, size, args, [this, &thiz, size, iso = isolate, &ctx = context](auto* v8Args) {
         v8::TryCatch tryCatch(iso);
@@ -355,6 +368,21 @@ void Local<Array>::clear() const {
   v8_backend::checkException(tryCatch);
 }
 
+void Local<Array>::forEachImpl(ForEachCallback callback, void* data) const {
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+
+  // v8::Array::Iterate forbids allocating and calling into V8 in the callback,
+  // which a generic callback can't promise.
+  v8::TryCatch tryCatch(isolate);
+  auto length = val_->Length();
+  for (uint32_t i = 0; i < length; ++i) {
+    v8::HandleScope handleScope(isolate);
+    auto element = val_->Get(context, i);
+    v8_backend::checkException(tryCatch);
+    callback(data, i, Local<Value>(element.ToLocalChecked()));
+  }
+}
+
 ByteBuffer::Type Local<ByteBuffer>::getType() const {
   if (val_->IsArrayBuffer()) {
     return ByteBuffer::Type::kUnspecified;
@@ -475,4 +503,87 @@ void Local<ByteBuffer>::commit() const {}
 
 void Local<ByteBuffer>::sync() const {}
 
+Promise::State Local<Promise>::getState() const {
+  switch (val_->State()) {
+    case v8::Promise::kFulfilled:
+      return Promise::State::kFulfilled;
+    case v8::Promise::kRejected:
+      return Promise::State::kRejected;
+    case v8::Promise::kPending:
+    default:
+      return Promise::State::kPending;
+  }
+}
+
+Local<Value> Local<Promise>::getResult() const {
+  if (val_->State() == v8::Promise::kPending) {
+    return {};
+  }
+  return Local<Value>(val_->Result());
+}
+
+Local<Promise> Local<Promise>::then(const Local<Value>& onFulfilled,
+                                    const Local<Value>& onRejected) const {
+  auto engine = v8_backend::currentEngine();
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+
+  v8::TryCatch tryCatch(isolate);
+  v8::MaybeLocal<v8::Promise> ret;
+  if (onFulfilled.isFunction() && onRejected.isFunction()) {
+    ret = val_->Then(context, onFulfilled.val_.As<v8::Function>(),
+                     onRejected.val_.As<v8::Function>());
+  } else if (onFulfilled.isFunction()) {
+    ret = val_->Then(context, onFulfilled.val_.As<v8::Function>());
+  } else if (onRejected.isFunction()) {
+    ret = val_->Catch(context, onRejected.val_.As<v8::Function>());
+  } else {
+    // same as promise.then(), derived promise follows this one
+    auto resolver = v8::Promise::Resolver::New(context);
+    if (!resolver.IsEmpty()) {
+      auto derived = resolver.ToLocalChecked();
+      auto success = derived->Resolve(context, val_);
+      (void)success;
+      ret = derived->GetPromise();
+    }
+  }
+  v8_backend::checkException(tryCatch);
+
+  // the reaction is queued right away if this promise is already settled
+  engine->scheduleMicrotaskCheckpoint();
+  return Local<Promise>(ret.ToLocalChecked());
+}
+
+void Promise::Resolver::resolve(const Local<Value>& value) const {
+  auto engine = v8_backend::currentEngine();
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+
+  v8::TryCatch tryCatch(isolate);
+  auto resolver = v8_interop::toV8(isolate, handle_.get()).As<v8::Promise::Resolver>();
+  auto success = resolver->Resolve(context, v8_interop::toV8(isolate, value));
+  (void)success;
+  v8_backend::checkException(tryCatch);
+  engine->scheduleMicrotaskCheckpoint();
+}
+
+void Promise::Resolver::reject(const Local<Value>& reason) const {
+  auto engine = v8_backend::currentEngine();
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+
+  v8::TryCatch tryCatch(isolate);
+  auto resolver = v8_interop::toV8(isolate, handle_.get()).As<v8::Promise::Resolver>();
+  auto success = resolver->Reject(context, v8_interop::toV8(isolate, reason));
+  (void)success;
+  v8_backend::checkException(tryCatch);
+  engine->scheduleMicrotaskCheckpoint();
+}
+
+size_t internal::identityHash(const Local<Value>& value) {
+  auto v8Value = v8_interop::toV8(v8_backend::currentEngineIsolateChecked(), value);
+  if (!v8Value->IsObject()) {
+    return 0;
+  }
+  // objects move around in the v8 heap, the identity hash is stable
+  return static_cast<size_t>(v8Value.As<v8::Object>()->GetIdentityHash());
+}
+
 }  // namespace script
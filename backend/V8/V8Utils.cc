@@ -16,22 +16,42 @@
  */
 
 #include "../../src/Utils.h"
+#include "../../src/utils/Helper.hpp"
 #include "V8Engine.h"
 #include "V8Helper.h"
 #include "V8Reference.hpp"
 
 namespace script {
 
-StringHolder::StringHolder(const script::Local<script::String>& string)
-    : internalHolder_(
-          v8_backend::currentEngineIsolateChecked(),
-          v8_backend::V8Engine::toV8(v8_backend::currentEngineIsolateChecked(), string)) {}
+StringHolder::StringHolder(const script::Local<script::String>& string) {
+  auto isolate = v8_backend::currentEngineIsolateChecked();
+  auto str = v8_backend::V8Engine::toV8(isolate, string);
+
+  if (str->IsOneByte()) {
+    // latin1 representation, ASCII strings need no transcoding
+    auto length = static_cast<size_t>(str->Length());
+    auto buffer = internalHolder_.allocate(length);
+    str->WriteOneByte(isolate, reinterpret_cast<uint8_t*>(buffer), 0, -1,
+                      v8::String::NO_NULL_TERMINATION);
+    if (internal::isAscii(buffer, length)) {
+      buffer[length] = '\0';
+      return;
+    }
+  }
+
+  // same as v8::String::Utf8Value
+  auto length = static_cast<size_t>(str->Utf8Length(isolate));
+  auto buffer = internalHolder_.allocate(length);
+  str->WriteUtf8(isolate, buffer, static_cast<int>(length), nullptr,
+                 v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8);
+  buffer[length] = '\0';
+}
 
 StringHolder::~StringHolder() = default;
 
-size_t StringHolder::length() const { return static_cast<size_t>(internalHolder_.length()); }
+size_t StringHolder::length() const { return internalHolder_.length_; }
 
-const char* StringHolder::c_str() const { return *internalHolder_; }
+const char* StringHolder::c_str() const { return internalHolder_.string_; }
 
 std::string_view StringHolder::stringView() const { return std::string_view(c_str(), length()); }
 
@@ -46,4 +66,51 @@ std::u8string_view StringHolder::u8stringView() const {
 
 const char8_t* StringHolder::c_u8str() const { return reinterpret_cast<const char8_t*>(c_str()); }
 #endif
+
+Local<Value> Json::parse(std::string_view json) {
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+  auto source = v8_backend::V8Engine::toV8(isolate, String::newString(json));
+
+  v8::TryCatch tryCatch(isolate);
+  auto ret = v8::JSON::Parse(context, source);
+  v8_backend::checkException(tryCatch);
+  return v8_backend::V8Engine::make<Local<Value>>(ret.ToLocalChecked());
+}
+
+std::string Json::stringify(const Local<Value>& value) {
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+  auto v8Value = v8_backend::V8Engine::toV8(isolate, value);
+  // JSON.stringify gives undefined for them
+  if (v8Value->IsUndefined() || v8Value->IsFunction() || v8Value->IsSymbol()) {
+    return {};
+  }
+
+  v8::TryCatch tryCatch(isolate);
+  v8::Local<v8::String> str;
+  if (!v8::JSON::Stringify(context, v8Value).ToLocal(&str)) {
+    v8_backend::checkException(tryCatch);
+    return {};
+  }
+
+  // write to the result directly, instead of copying through a StringHolder
+  std::string json;
+  if (str->IsOneByte()) {
+    json.resize(static_cast<size_t>(str->Length()));
+    str->WriteOneByte(isolate, reinterpret_cast<uint8_t*>(json.data()), 0, -1,
+                      v8::String::NO_NULL_TERMINATION);
+    // v8 converts an undefined result of toJSON to the string "undefined", the only way to
+    // tell it apart from a JSON text, which can never be a bare undefined.
+    if (json == "undefined") {
+      return {};
+    }
+    if (internal::isAscii(json)) {
+      return json;
+    }
+  }
+  json.resize(static_cast<size_t>(str->Utf8Length(isolate)));
+  str->WriteUtf8(isolate, json.data(), static_cast<int>(json.size()), nullptr,
+                 v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8);
+  return json;
+}
+
 }  // namespace script
@@ -18,6 +18,7 @@
 #include "../../src/Native.hpp"
 #include "../../src/Reference.h"
 #include "../../src/Utils.h"
+#include "../../src/utils/Helper.hpp"
 #include "V8Engine.h"
 #include "V8Helper.hpp"
 
@@ -62,8 +63,15 @@ Local<String> String::newString(const char* utf8) {
 Local<String> String::newString(std::string_view utf8) {
   auto isolate = v8_backend::currentEngineIsolateChecked();
   v8::TryCatch tryCatch(isolate);
-  auto ret = v8::String::NewFromUtf8(isolate, utf8.data(), v8::NewStringType::kNormal,
-                                     static_cast<int>(utf8.length()));
+  auto length = static_cast<int>(utf8.length());
+  v8::MaybeLocal<v8::String> ret;
+  if (internal::isAscii(utf8)) {
+    // ASCII is valid latin1, skip the utf8 decoder
+    ret = v8::String::NewFromOneByte(isolate, reinterpret_cast<const uint8_t*>(utf8.data()),
+                                     v8::NewStringType::kNormal, length);
+  } else {
+    ret = v8::String::NewFromUtf8(isolate, utf8.data(), v8::NewStringType::kNormal, length);
+  }
 
   v8_backend::checkException(tryCatch);
   return Local<String>(ret.ToLocalChecked());
@@ -81,15 +89,7 @@ Local<String> String::newString(const char8_t* utf8) {
 }
 
 Local<String> String::newString(std::u8string_view utf8) {
-  // we just cast char8_t* to char8_t for now.
-  // remove cast once V8 have an overloaded version.
-  v8::TryCatch tryCatch(v8_backend::currentEngineIsolateChecked());
-
-  auto ret = v8::String::NewFromUtf8(v8_backend::currentEngineIsolateChecked(),
-                                     reinterpret_cast<const char*>(utf8.data()),
-                                     v8::NewStringType::kNormal, utf8.length());
-  v8_backend::checkException(tryCatch);
-  return Local<String>(ret.ToLocalChecked());
+  return newString(std::string_view(reinterpret_cast<const char*>(utf8.data()), utf8.length()));
 }
 
 Local<String> String::newString(const std::u8string& utf8) {
@@ -98,6 +98,78 @@ Local<String> String::newString(const std::u8string& utf8) {
 
 #endif
 
+namespace {
+
+/**
+ * keeps the shared string alive until V8 collects the external string.
+ */
+class SharedOneByteResource : public v8::String::ExternalOneByteStringResource {
+  std::shared_ptr<const std::string> string_;
+  v8::Isolate* isolate_;
+
+ public:
+  SharedOneByteResource(std::shared_ptr<const std::string> string, v8::Isolate* isolate)
+      : string_(std::move(string)), isolate_(isolate) {}
+
+  const char* data() const override { return string_->data(); }
+
+  size_t length() const override { return string_->length(); }
+
+  void Dispose() override {
+    // the engine may have been destroyed, talk to the isolate directly.
+    isolate_->AdjustAmountOfExternalAllocatedMemory(-static_cast<int64_t>(string_->length()));
+    delete this;
+  }
+};
+
+class StaticOneByteResource : public v8::String::ExternalOneByteStringResource {
+  std::string_view string_;
+
+ public:
+  explicit StaticOneByteResource(std::string_view string) : string_(string) {}
+
+  const char* data() const override { return string_.data(); }
+
+  size_t length() const override { return string_.length(); }
+};
+
+v8::Local<v8::String> newExternalOneByte(v8::Isolate* isolate,
+                                         v8::String::ExternalOneByteStringResource* resource) {
+  v8::TryCatch tryCatch(isolate);
+  auto ret = v8::String::NewExternalOneByte(isolate, resource);
+  if (ret.IsEmpty()) {
+    // V8 doesn't take ownership on failure
+    delete resource;
+  }
+  v8_backend::checkException(tryCatch);
+  return ret.ToLocalChecked();
+}
+
+}  // namespace
+
+Local<String> String::newExternalString(std::shared_ptr<const std::string> utf8) {
+  if (!utf8) throw Exception("null pointer");
+  // V8 one-byte strings are Latin-1, only ASCII is compatible with utf8.
+  // a two-byte resource would need transcoding, which is a copy anyway.
+  if (utf8->empty() || !internal::isAscii(*utf8)) {
+    return newString(std::string_view(*utf8));
+  }
+
+  auto isolate = v8_backend::currentEngineIsolateChecked();
+  auto size = static_cast<int64_t>(utf8->length());
+  auto ret = newExternalOneByte(isolate, new SharedOneByteResource(std::move(utf8), isolate));
+  v8_backend::currentEngineChecked().adjustAssociatedMemory(size);
+  return Local<String>(ret);
+}
+
+Local<String> String::newExternalStaticString(std::string_view staticUtf8) {
+  if (staticUtf8.empty() || !internal::isAscii(staticUtf8)) {
+    return newString(staticUtf8);
+  }
+  return Local<String>(newExternalOneByte(v8_backend::currentEngineIsolateChecked(),
+                                          new StaticOneByteResource(staticUtf8)));
+}
+
 Local<Boolean> Boolean::newBoolean(bool value) {
   return Local<Boolean>(v8::Boolean::New(v8_backend::currentEngineIsolateChecked(), value));
 }
@@ -117,8 +189,11 @@ Local<Function> Function::newFunction(::script::FunctionCallback callback) {
   data->function = std::move(callback);
 
   auto param = v8::External::New(isolate, static_cast<void*>(data.get())).As<v8::Value>();
-  auto funcTemplate = v8::FunctionTemplate::New(
-      isolate,
+  // v8::Function::New don't cache the underlying FunctionTemplate (as FunctionTemplate::New does),
+  // so it is collected together with the function.
+  // All functions share the same callback, and the FunctionData is released by a weak handle.
+  auto func = v8::Function::New(
+      context,
       [](const v8::FunctionCallbackInfo<v8::Value>& info) {
         auto data = static_cast<FunctionData*>(info.Data().As<v8::External>()->Value());
         // we don't have a function name
@@ -131,10 +206,7 @@ Local<Function> Function::newFunction(::script::FunctionCallback callback) {
           v8_backend::rethrowException(e);
         }
       },
-      param);
-
-  funcTemplate->RemovePrototype();
-  auto func = funcTemplate->GetFunction(context);
+      param, 0, v8::ConstructorBehavior::kThrow);
   v8_backend::checkException(tryCatch);
 
   v8_backend::currentEngineChecked().addManagedObject(
@@ -213,4 +285,16 @@ Local<ByteBuffer> ByteBuffer::newByteBuffer(std::shared_ptr<void> buffer, size_t
 
 #endif
 
+Promise::Resolver Promise::newPromise() {
+  auto&& [isolate, context] = v8_backend::currentEngineIsolateAndContextChecked();
+
+  v8::TryCatch tryCatch(isolate);
+  auto resolver = v8::Promise::Resolver::New(context);
+  v8_backend::checkException(tryCatch);
+
+  auto v8Resolver = resolver.ToLocalChecked();
+  return Resolver(Local<Promise>(v8Resolver->GetPromise()),
+                  v8_interop::makeLocal<Value>(v8Resolver.As<v8::Value>()));
+}
+
 }  // namespace script
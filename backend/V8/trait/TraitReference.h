@@ -49,6 +49,7 @@ TypeMap(::script::Boolean, v8::Boolean);
 TypeMap(::script::Function, v8::Function);
 TypeMap(::script::Array, v8::Array);
 TypeMap(::script::ByteBuffer, v8::Value);
+TypeMap(::script::Promise, v8::Promise);
 TypeMap(::script::Unsupported, v8::Value);
 
 #undef TypeMap
@@ -16,15 +16,45 @@
  */
 
 #pragma once
+#include <cstddef>
+#include <memory>
 #include "../../../src/foundation.h"
 #include "../../../src/types.h"
 #include "../V8Helper.h"
 
 namespace script {
 
+namespace v8_backend {
+
+/**
+ * utf8 buffer of StringHolder, short strings live inline (no heap allocation).
+ */
+struct StringHolderImpl {
+  static constexpr size_t kInlineSize = 128;
+
+  char* string_ = nullptr;
+  size_t length_ = 0;
+  std::unique_ptr<char[]> heap_;
+  char inline_[kInlineSize];
+
+  /** @return buffer of length + 1 bytes (for the null-terminator) */
+  char* allocate(size_t length) {
+    if (length < kInlineSize) {
+      string_ = inline_;
+    } else {
+      heap_.reset(new char[length + 1]);
+      string_ = heap_.get();
+    }
+    length_ = length;
+    return string_;
+  }
+};
+
+}  // namespace v8_backend
+
 template <>
 struct internal::ImplType<StringHolder> {
-  using type = v8::String::Utf8Value;
+  using type = v8_backend::StringHolderImpl;
 };
 
 template <>
@@ -17,6 +17,7 @@
 
 #include "../../src/Native.hpp"
 #include "../../src/Reference.h"
+#include "../../src/Serializer.h"
 #include "WasmEngine.h"
 
 namespace script {
@@ -100,6 +101,12 @@ REF_IMPL_BASIC_FUNC(ByteBuffer)
 REF_IMPL_BASIC_DESCRIBE(ByteBuffer)
 REF_IMPL_BASIC_EQUALS(ByteBuffer)
 
+REF_IMPL_BASIC_FUNC(Promise)
+REF_IMPL_BASIC_NOT_VALUE_CTOR_DTOR(Promise)
+REF_IMPL_BASIC_DESCRIBE(Promise)
+REF_IMPL_BASIC_EQUALS(Promise)
+REF_IMPL_TO_VALUE(Promise)
+
 REF_IMPL_BASIC_FUNC(Unsupported)
 REF_IMPL_BASIC_NOT_VALUE_CTOR_DTOR(Unsupported)
 REF_IMPL_BASIC_DESCRIBE(Unsupported)
@@ -154,6 +161,11 @@ bool Local<Value>::isArray() const { return wasm_backend::Stack::isArray(val_);
 
 bool Local<Value>::isByteBuffer() const { return wasm_backend::Stack::isByteBuffer(val_); }
 
+bool Local<Value>::isPromise() const {
+  return isObject() &&
+         asObject().instanceOf(wasm_backend::currentEngine().getGlobal().get("Promise"));
+}
+
 bool Local<Value>::isObject() const { return wasm_backend::Stack::isObject(val_); }
 
 bool Local<Value>::isUnsupported() const { return wasm_backend::Stack::isUnsupported(val_); }
@@ -188,6 +200,11 @@ Local<ByteBuffer> Local<Value>::asByteBuffer() const {
   return Local<ByteBuffer>(wasm_backend::ByteBufferState(val_));
 }
 
+Local<Promise> Local<Value>::asPromise() const {
+  if (!isPromise()) throw Exception("can't cast value as Promise");
+  return Local<Promise>(val_);
+}
+
 Local<Object> Local<Value>::asObject() const {
   if (!isObject()) throw Exception("can't cast value as Object");
   return Local<Object>(val_);
@@ -266,6 +283,14 @@ void Local<Array>::add(const script::Local<script::Value>& value) const { set(si
 
 void Local<Array>::clear() const { wasm_backend::Stack::arrayClear(val_); }
 
+void Local<Array>::forEachImpl(ForEachCallback callback, void* data) const {
+  auto length = size();
+  for (size_t i = 0; i < length; ++i) {
+    StackFrameScope stack;
+    callback(data, i, get(i));
+  }
+}
+
 // ByteBuffer
 
 namespace wasm_backend {
@@ -382,4 +407,32 @@ void Local<ByteBuffer>::commit() const { wasm_backend::ByteBufferHelper::commit(
 
 void Local<ByteBuffer>::sync() const { wasm_backend::ByteBufferHelper::sync(*this); }
 
+Promise::State Local<Promise>::getState() const {
+  throw Exception("Promise state is not supported by WebAssembly");
+}
+
+Local<Value> Local<Promise>::getResult() const {
+  throw Exception("Promise state is not supported by WebAssembly");
+}
+
+Local<Promise> Local<Promise>::then(const Local<Value>& onFulfilled,
+                                    const Local<Value>& onRejected) const {
+  auto then = asValue().asObject().get("then").asFunction();
+  return then.call(*this, {onFulfilled, onRejected}).asPromise();
+}
+
+// handle is [resolve, reject], see Promise::newPromise
+void Promise::Resolver::resolve(const Local<Value>& value) const {
+  handle_.get().asArray().get(0).asFunction().call({}, value);
+}
+
+void Promise::Resolver::reject(const Local<Value>& reason) const {
+  handle_.get().asArray().get(1).asFunction().call({}, reason);
+}
+
+size_t internal::identityHash(const Local<Value>& value) {
+  // values are indexes of the js side stack, no identity on the c++ side
+  return 0;
+}
+
 }  // namespace script
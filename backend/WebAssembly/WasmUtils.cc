@@ -74,4 +74,24 @@ std::u8string_view StringHolder::u8stringView() const {
 const char8_t *StringHolder::c_u8str() const { return reinterpret_cast<const char8_t *>(c_str()); }
 #endif
 
+// call into the JSON object of the browser, there is no faster way to cross the wasm boundary
+
+Local<Value> Json::parse(std::string_view json) {
+  StackFrameScope stack;
+  auto &engine = EngineScope::currentEngineChecked();
+  auto jsonObject = engine.get(String::newString("JSON")).asObject();
+  auto ret = jsonObject.get(String::newString("parse"))
+                 .asFunction()
+                 .call(jsonObject, String::newString(json));
+  return stack.returnValue(ret);
+}
+
+std::string Json::stringify(const Local<Value> &value) {
+  StackFrameScope stack;
+  auto &engine = EngineScope::currentEngineChecked();
+  auto jsonObject = engine.get(String::newString("JSON")).asObject();
+  auto ret = jsonObject.get(String::newString("stringify")).asFunction().call(jsonObject, value);
+  return ret.isString() ? ret.asString().toString() : std::string();
+}
+
 }  // namespace script
@@ -63,6 +63,16 @@ Local<String> String::newString(const std::u8string& utf8) {
 
 #endif
 
+Local<String> String::newExternalString(std::shared_ptr<const std::string> utf8) {
+  if (!utf8) throw Exception("null pointer");
+  // strings live in the wasm heap, copy it
+  return newString(*utf8);
+}
+
+Local<String> String::newExternalStaticString(std::string_view staticUtf8) {
+  return newString(staticUtf8);
+}
+
 Local<Number> Number::newNumber(float value) {
   return Local<Number>(wasm_backend::Stack::newNumber(static_cast<double>(value)));
 }
@@ -110,6 +120,19 @@ Local<Array> Array::newArrayImpl(size_t size, const Local<Value>* args) {
   return ret;
 }
 
+Promise::Resolver Promise::newPromise() {
+  // no native api, take the resolving functions out of an executor, it's called synchronously
+  auto functions = Array::newArray(2);
+  auto executor = Function::newFunction([functions](const Arguments& args) -> Local<Value> {
+    functions.set(0, args[0]);
+    functions.set(1, args[1]);
+    return {};
+  });
+  auto promiseClass = wasm_backend::currentEngine().getGlobal().get("Promise");
+  auto promise = Object::newObject(promiseClass, {executor});
+  return Resolver(promise.asValue().asPromise(), functions);
+}
+
 Local<ByteBuffer> ByteBuffer::newByteBuffer(size_t size) {
   return Local<ByteBuffer>(wasm_backend::Stack::pushArrayBuffer(size));
 }
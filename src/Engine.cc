@@ -16,6 +16,12 @@
  */
 
 #include <ScriptX/ScriptX.h>
+#include <algorithm>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace script {
 
@@ -23,7 +29,270 @@ void ScriptEngine::setData(std::shared_ptr<void> arbitraryData) {
   userData_ = std::move(arbitraryData);
 }
 
-void ScriptEngine::destroyUserData() { userData_.reset(); }
+void ScriptEngine::destroyUserData() {
+  if (idleGcHandler_) {
+    // wait for the running one, if any
+    messageQueue()->removeIdleHandler(idleGcHandler_.get());
+    idleGcHandler_.reset();
+  }
+  userData_.reset();
+  internalState_.clear();
+}
+
+ScriptEngine::MicrotaskStatistics ScriptEngine::getMicrotaskStatistics() const {
+  MicrotaskStatistics stat;
+  stat.queued = microtasksQueued_.load(std::memory_order_relaxed);
+  stat.executed = microtasksExecuted_.load(std::memory_order_relaxed);
+  stat.drains = microtaskDrains_.load(std::memory_order_relaxed);
+  stat.deferred = microtaskDrainsDeferred_.load(std::memory_order_relaxed);
+  return stat;
+}
+
+bool ScriptEngine::runMicrotasks(
+    const std::function<size_t(size_t maxJobs, bool& hasMore)>& runJobs) {
+  // check the clock every few jobs when there is a time budget
+  constexpr size_t kJobsPerTimeCheck = 8;
+
+  auto policy = microtaskPolicy_;
+  auto maxJobs = policy.maxJobsPerDrain != 0 ? policy.maxJobsPerDrain
+                                             : std::numeric_limits<size_t>::max();
+  auto timed = policy.maxTimePerDrain.count() > 0;
+  auto deadline = std::chrono::steady_clock::now() + policy.maxTimePerDrain;
+
+  size_t executed = 0;
+  bool hasMore = true;
+  while (hasMore && executed < maxJobs) {
+    auto batch = maxJobs - executed;
+    if (timed) {
+      batch = std::min(batch, kJobsPerTimeCheck);
+    }
+    auto count = runJobs(batch, hasMore);
+    if (count == kUnknownJobCount) {
+      break;
+    }
+    executed += count;
+    if (count == 0 || (timed && std::chrono::steady_clock::now() >= deadline)) {
+      break;
+    }
+  }
+
+  microtasksExecuted_.fetch_add(executed, std::memory_order_relaxed);
+  microtaskDrains_.fetch_add(1, std::memory_order_relaxed);
+  if (hasMore) {
+    microtaskDrainsDeferred_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return hasMore;
+}
+
+void ScriptEngine::updateHeapUsage(size_t usage) {
+  auto softLimit = heapLimit_.softLimit;
+  if (softLimit == 0) {
+    return;
+  }
+  if (usage > softLimit) {
+    if (!heapAboveSoftLimit_.exchange(true, std::memory_order_relaxed)) {
+      postHeapLimitMessage(usage, false);
+    }
+  } else if (usage < softLimit - softLimit / 10) {
+    // some room, so that a heap hovering around the limit doesn't flood the queue
+    heapAboveSoftLimit_.store(false, std::memory_order_relaxed);
+  }
+}
+
+void ScriptEngine::notifyHeapLimitReached(size_t usage) {
+  // one at a time, a failed allocation is usually followed by more
+  if (!heapLimitReachedPending_.exchange(true, std::memory_order_relaxed)) {
+    postHeapLimitMessage(usage, true);
+  }
+}
+
+void ScriptEngine::postHeapLimitMessage(size_t usage, bool hardLimitReached) {
+  if (!heapLimit_.callback || isDestroying()) {
+    heapLimitReachedPending_ = false;
+    return;
+  }
+
+  utils::Message message(
+      [](auto& msg) {
+        auto engine = static_cast<ScriptEngine*>(msg.ptr0);
+        auto hardLimitReached = msg.data1 != 0;
+        if (hardLimitReached) {
+          engine->heapLimitReachedPending_ = false;
+        }
+        auto callback = engine->heapLimit_.callback;
+        if (callback) {
+          EngineScope scope(engine);
+          callback(engine, static_cast<size_t>(msg.data0), hardLimitReached);
+        }
+      },
+      nullptr);
+  message.name = "HeapLimit";
+  message.ptr0 = this;
+  message.tag = this;
+  message.data0 = static_cast<int64_t>(usage);
+  message.data1 = hardLimitReached ? 1 : 0;
+  messageQueue()->postMessage(message);
+}
+
+class ScriptEngine::IdleGcHandler : public utils::MessageQueue::IdleHandler {
+ public:
+  explicit IdleGcHandler(ScriptEngine* engine) : engine_(engine) {}
+
+ protected:
+  bool onIdle(std::chrono::nanoseconds timeLeft) override { return engine_->runIdleGc(timeLeft); }
+
+ private:
+  ScriptEngine* engine_;
+};
+
+void ScriptEngine::setIdleGcPolicy(const IdleGcPolicy& policy) {
+  auto queue = messageQueue();
+  if (idleGcHandler_) {
+    queue->removeIdleHandler(idleGcHandler_.get());
+  }
+  idleGcPolicy_ = policy;
+  if (policy.enabled) {
+    if (!idleGcHandler_) {
+      idleGcHandler_ = std::make_unique<IdleGcHandler>(this);
+    }
+    queue->addIdleHandler(idleGcHandler_.get(), policy.idleDelay);
+  }
+}
+
+ScriptEngine::IdleGcStatistics ScriptEngine::getIdleGcStatistics() const {
+  IdleGcStatistics stat;
+  stat.steps = idleGcSteps_.load(std::memory_order_relaxed);
+  stat.cycles = idleGcCycles_.load(std::memory_order_relaxed);
+  stat.time = std::chrono::nanoseconds(idleGcTime_.load(std::memory_order_relaxed));
+  return stat;
+}
+
+bool ScriptEngine::runIdleGc(std::chrono::nanoseconds timeLeft) {
+  auto budget = std::min<std::chrono::nanoseconds>(timeLeft, idleGcPolicy_.budget);
+  if (isDestroying() || budget.count() <= 0) {
+    return false;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  bool more;
+  {
+    EngineScope scope(this);
+    more = performIdleGc(start + budget);
+  }
+  auto time = std::chrono::steady_clock::now() - start;
+  idleGcSteps_.fetch_add(1, std::memory_order_relaxed);
+  idleGcTime_.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(),
+                        std::memory_order_relaxed);
+  return more;
+}
+
+namespace internal {
+
+/**
+ * one thread for all engines, interrupts executions running beyond their timeout.
+ */
+class Watchdog {
+ public:
+  static Watchdog& shared() {
+    // never destroyed, engines may still run executions during static destruction
+    static auto watchdog = new Watchdog();
+    return *watchdog;
+  }
+
+  void watch(ScriptEngine* engine, std::chrono::steady_clock::time_point deadline) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+      std::thread([this]() { run(); }).detach();
+      started_ = true;
+    }
+    deadlines_[engine] = deadline;
+    condition_.notify_one();
+  }
+
+  void unwatch(ScriptEngine* engine) {
+    // after this returns, the engine won't be touched by the watchdog thread
+    std::lock_guard<std::mutex> lock(mutex_);
+    deadlines_.erase(engine);
+  }
+
+ private:
+  Watchdog() = default;
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      if (deadlines_.empty()) {
+        condition_.wait(lock);
+        continue;
+      }
+
+      auto next = std::min_element(deadlines_.begin(), deadlines_.end(),
+                                   [](auto& a, auto& b) { return a.second < b.second; });
+      if (std::chrono::steady_clock::now() < next->second) {
+        condition_.wait_until(lock, next->second);
+        continue;
+      }
+      auto engine = next->first;
+      deadlines_.erase(next);
+      engine->interrupt(TerminationReason::kTimeout);
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::unordered_map<ScriptEngine*, std::chrono::steady_clock::time_point> deadlines_;
+  bool started_ = false;
+};
+
+ExecutionScope::ExecutionScope(ScriptEngine* engine)
+    : engine_(engine),
+      outermost_(engine->executionDepth_.fetch_add(1, std::memory_order_acq_rel) == 0) {
+  if (outermost_) {
+    auto timeout = engine_->executionTimeout_;
+    engine_->interruptReason_.store(0, std::memory_order_relaxed);
+    watched_ = timeout.count() > 0;
+    engine_->beginExecution(watched_);
+    if (watched_) {
+      Watchdog::shared().watch(engine_, std::chrono::steady_clock::now() + timeout);
+    }
+  }
+}
+
+ExecutionScope::~ExecutionScope() {
+  if (outermost_) {
+    if (watched_) {
+      Watchdog::shared().unwatch(engine_);
+    }
+    engine_->executionDepth_.store(0, std::memory_order_release);
+    engine_->interruptReason_.store(0, std::memory_order_relaxed);
+    engine_->endExecution();
+  } else {
+    engine_->executionDepth_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+}  // namespace internal
+
+void ScriptEngine::interrupt() { interrupt(TerminationReason::kInterrupt); }
+
+void ScriptEngine::interrupt(TerminationReason reason) {
+  if (executionDepth_.load(std::memory_order_acquire) == 0) {
+    return;
+  }
+  int expected = 0;
+  if (interruptReason_.compare_exchange_strong(expected, static_cast<int>(reason) + 1,
+                                               std::memory_order_relaxed)) {
+    requestInterrupt();
+  }
+}
+
+std::optional<TerminationReason> ScriptEngine::getInterruptReason() const {
+  auto reason = interruptReason_.load(std::memory_order_relaxed);
+  if (reason == 0) {
+    return {};
+  }
+  return static_cast<TerminationReason>(reason - 1);
+}
 
 void ScriptEngine::registerNativeClass(const script::NativeRegister& nativeRegister) {
   nativeRegister.registerNativeClass(this);
@@ -17,7 +17,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
 #include <unordered_set>
@@ -29,11 +35,126 @@
 
 namespace script {
 
+namespace internal {
+class ExecutionScope;
+class Watchdog;
+}  // namespace internal
+
 class ScriptEngine {
+ public:
+  /**
+   * how the engine drains microtasks (promise reactions, await continuations).
+   */
+  struct MicrotaskPolicy {
+    enum class Mode {
+      /**
+       * drain in a message posted to the MessageQueue whenever jobs are queued. (default)
+       */
+      kAuto,
+      /**
+       * never drain on its own, call performMicrotaskCheckpoint to run the jobs.
+       */
+      kExplicit,
+    };
+
+    Mode mode = Mode::kAuto;
+
+    /**
+     * max jobs to run in one drain, 0 for no limit.
+     */
+    size_t maxJobsPerDrain = 0;
+
+    /**
+     * max time to spend in one drain, 0 for no limit.
+     * a job is never interrupted, the time is checked between jobs.
+     */
+    std::chrono::microseconds maxTimePerDrain{0};
+  };
+
+  struct MicrotaskStatistics {
+    /**
+     * jobs ever queued, updated on each drain. 0 if the backend can't tell (V8).
+     */
+    uint64_t queued = 0;
+    /**
+     * jobs run. 0 if the backend can't tell (V8).
+     */
+    uint64_t executed = 0;
+    /**
+     * times the queue is drained, by message or performMicrotaskCheckpoint.
+     */
+    uint64_t drains = 0;
+    /**
+     * drains stopped by the budget with jobs left.
+     */
+    uint64_t deferred = 0;
+  };
+
+  struct HeapLimit {
+    /**
+     * heap size in bytes the engine should never go beyond, 0 for no limit.
+     * allocation beyond it fails with an out of memory exception, which can be caught by script,
+     * except on V8, which terminates the script execution.
+     */
+    size_t hardLimit = 0;
+
+    /**
+     * the callback is called once the heap grows beyond it, 0 for none.
+     * it is called again only after the heap shrinks 10% below it.
+     */
+    size_t softLimit = 0;
+
+    /**
+     * called in a message posted to the MessageQueue (with EngineScope entered),
+     * when the heap crosses the softLimit, or an allocation is refused by the hardLimit.
+     * @param usage heap size in bytes when it happened
+     * @param hardLimitReached true for hardLimit
+     */
+    std::function<void(ScriptEngine* engine, size_t usage, bool hardLimitReached)> callback;
+  };
+
+  /**
+   * GC work done while the MessageQueue is idle, instead of in the middle of messages.
+   */
+  struct IdleGcPolicy {
+    bool enabled = false;
+
+    /**
+     * how long the MessageQueue must have no due message before GC work starts.
+     */
+    std::chrono::milliseconds idleDelay{100};
+
+    /**
+     * max time of one step of GC work, it is also cut short by the next due message.
+     * steps are repeated while the queue stays idle, until the collection is done.
+     */
+    std::chrono::milliseconds budget{5};
+  };
+
+  struct IdleGcStatistics {
+    /**
+     * steps of GC work done in idle time.
+     */
+    uint64_t steps = 0;
+
+    /**
+     * times the GC work is finished in idle time (a collection, or all the work the engine had).
+     */
+    uint64_t cycles = 0;
+
+    /**
+     * time spent on idle GC work.
+     */
+    std::chrono::nanoseconds time{0};
+  };
+
  protected:
   std::unordered_map<internal::TypeIndex, const internal::ClassDefineState*> classDefineRegistry_{};
   std::unordered_set<const internal::ClassDefineState*> staticClassDefineRegistry_{};
   std::shared_ptr<void> userData_{};
+  std::unordered_map<internal::TypeIndex, std::shared_ptr<void>> internalState_{};
+  MicrotaskPolicy microtaskPolicy_{};
+  HeapLimit heapLimit_{};
 
  public:
   explicit ScriptEngine(std::shared_ptr<utils::MessageQueue> messageQueue = {}) {}
@@ -210,6 +331,100 @@ class ScriptEngine {
    */
   virtual void adjustAssociatedMemory(int64_t count) { SCRIPTX_UNUSED(count); }
 
+  /**
+   * Limit the heap of this engine, should be called on the engine thread.
+   *
+   * Backend differences:
+   * 1. V8 enforces the hardLimit after each GC, and when V8 runs into the heap limit configured
+   * for the isolate (see V8Engine(messageQueue, heapLimit)) it terminates the execution instead of
+   * crashing.
+   * 2. QuickJs with a runtime from QjsFactory only supports the hardLimit.
+   * 3. JavaScriptCore and WebAssembly are not supported.
+   */
+  virtual void setHeapLimit(const HeapLimit& limit) { heapLimit_ = limit; }
+
+  /**
+   * Set how microtasks are drained, should be called on the engine thread.
+   *
+   * In kAuto mode a drain stopped by the budget posts another message to continue,
+   * so other messages in the MessageQueue get their chance to run in between.
+   *
+   * Backend differences:
+   * 1. V8 drains all jobs in one checkpoint, it can't stop in between nor tell how many jobs ran.
+   * The budget is ignored, and MicrotaskStatistics::executed stays 0.
+   * 2. JavaScriptCore and WebAssembly run microtasks by themselves, the policy is ignored.
+   */
+  virtual void setMicrotaskPolicy(const MicrotaskPolicy& policy) { microtaskPolicy_ = policy; }
+
+  MicrotaskPolicy getMicrotaskPolicy() const { return microtaskPolicy_; }
+
+  /**
+   * Run queued microtasks now, within the budget of the policy.
+   * @return true if there are jobs left, always false on V8 (see setMicrotaskPolicy)
+   */
+  virtual bool performMicrotaskCheckpoint() { return false; }
+
+  /**
+   * can be called from any thread.
+   */
+  MicrotaskStatistics getMicrotaskStatistics() const;
+
+  /**
+   * Do GC work when the MessageQueue is idle (see MessageQueue::addIdleHandler),
+   * only in the outermost loopQueue(LoopType::kLoopAndWait).
+   * should be called on the engine thread.
+   *
+   * Backend differences:
+   * 1. V8 uses IdleNotificationDeadline. Where it is not available (newer V8, or an isolate
+   * from outside), MemoryPressureNotification(kModerate) once per idle period if the heap grew
+   * 10%. It only starts incremental marking, the rest is done alongside later executions.
+   * 2. QuickJs runs a full JS_RunGC once per idle period if the heap grew 10% since the last
+   * one, the budget can't cut it short. It's skipped in PauseGc.
+   * 3. Lua runs incremental steps (LUA_GCSTEP) until the budget runs out or a cycle finishes,
+   * a new cycle starts when the heap grew 10%.
+   * 4. JavaScriptCore and WebAssembly are not supported.
+   */
+  void setIdleGcPolicy(const IdleGcPolicy& policy);
+
+  IdleGcPolicy getIdleGcPolicy() const { return idleGcPolicy_; }
+
+  /**
+   * can be called from any thread.
+   */
+  IdleGcStatistics getIdleGcStatistics() const;
+
+  /**
+   * Limit how long one script execution can run, 0 for no limit (default).
+   * An execution is the outermost eval, Function::call from native or microtask drain,
+   * nested calls count in the outermost one.
+   *
+   * A shared watchdog thread interrupts executions running beyond the timeout,
+   * the native caller gets a TerminationException with TerminationReason::kTimeout.
+   * should be called on the engine thread.
+   */
+  void setExecutionTimeout(std::chrono::milliseconds timeout) { executionTimeout_ = timeout; }
+
+  std::chrono::milliseconds getExecutionTimeout() const { return executionTimeout_; }
+
+  /**
+   * Interrupt the script execution running now, can be called from any thread.
+   * The native caller gets a TerminationException with TerminationReason::kInterrupt.
+   * Does nothing if the engine is not running script.
+   *
+   * Backend differences:
+   * 1. QuickJs checks for interruption every few thousand bytecodes.
+   * 2. Lua checks every 1000 instructions with a count hook (lua_sethook), on the coroutines
+   * created after the hook is installed, LuaJIT doesn't call hooks from JIT-compiled code.
+   * 3. JavaScriptCore and WebAssembly are not supported.
+   */
+  void interrupt();
+
+  /**
+   * can be called from any thread.
+   * @return reason of the pending interruption, empty if the execution is not interrupted.
+   */
+  std::optional<TerminationReason> getInterruptReason() const;
+
   /**
    * @return script language the engine supported
    */
@@ -231,6 +446,13 @@ class ScriptEngine {
   template <typename T = void>
   std::shared_ptr<T> getData();
 
+  /**
+   * per engine state used by ScriptX itself (eg: interned keys of SCRIPTX_STRUCT),
+   * one instance per type T, default constructed on first call, released on engine destroy.
+   */
+  template <typename T>
+  T& getInternalState();
+
  protected:
   /**
    * should not be public, use destroy instead of dtor.
@@ -239,6 +461,92 @@ class ScriptEngine {
 
   void destroyUserData();
 
+  /**
+   * drain microtasks within the budget of the policy, and update the statistics.
+   * @param runJobs run at most maxJobs jobs, return the number of jobs run (or kUnknownJobCount),
+   * and set hasMore to whether the queue is still non-empty.
+   * @return true if there are jobs left
+   */
+  bool runMicrotasks(const std::function<size_t(size_t maxJobs, bool& hasMore)>& runJobs);
+
+  /**
+   * returned by runJobs of runMicrotasks when the backend ran jobs without knowing how many,
+   * the drain ends there and they are not counted in MicrotaskStatistics::executed.
+   */
+  static constexpr size_t kUnknownJobCount = std::numeric_limits<size_t>::max();
+
+  /**
+   * called by backend when the heap grows or shrinks, from the engine thread
+   * (eg: in the allocator, or after GC). checks the softLimit, don't call into the engine.
+   */
+  void updateHeapUsage(size_t usage);
+
+  /**
+   * called by backend when an allocation is refused by the hardLimit, don't call into the engine.
+   */
+  void notifyHeapLimitReached(size_t usage);
+
+  std::atomic<uint64_t> microtasksQueued_{0};
+  std::atomic<uint64_t> microtasksExecuted_{0};
+  std::atomic<uint64_t> microtaskDrains_{0};
+  std::atomic<uint64_t> microtaskDrainsDeferred_{0};
+
+  /**
+   * do GC work until deadline, in EngineScope. increase idleGcCycles_ when the work is finished.
+   * @return true if there is more work
+   */
+  virtual bool performIdleGc(std::chrono::steady_clock::time_point deadline) {
+    SCRIPTX_UNUSED(deadline);
+    return false;
+  }
+
+  std::atomic<uint64_t> idleGcCycles_{0};
+
+  /**
+   * called after the interruption is requested, from any thread.
+   * backend should stop the running script as soon as possible.
+   */
+  virtual void requestInterrupt() {}
+
+  /**
+   * called when the outermost execution begins, on the engine thread.
+   * backend should drop any interruption left from the previous execution.
+   * @param timeoutEnabled whether the execution is watched by the timeout
+   */
+  virtual void beginExecution(bool timeoutEnabled) { SCRIPTX_UNUSED(timeoutEnabled); }
+
+  /**
+   * called when the outermost execution ends, on the engine thread.
+   * backend should drop any interruption left.
+   */
+  virtual void endExecution() {}
+
+ private:
+  void postHeapLimitMessage(size_t usage, bool hardLimitReached);
+
+  void interrupt(TerminationReason reason);
+
+  class IdleGcHandler;
+
+  bool runIdleGc(std::chrono::nanoseconds timeLeft);
+
+  IdleGcPolicy idleGcPolicy_{};
+  std::unique_ptr<utils::MessageQueue::IdleHandler> idleGcHandler_;
+  std::atomic<uint64_t> idleGcSteps_{0};
+  std::atomic<int64_t> idleGcTime_{0};
+
+  std::chrono::milliseconds executionTimeout_{0};
+  // number of nested executions, see internal::ExecutionScope
+  std::atomic<int> executionDepth_{0};
+  // TerminationReason + 1, 0 for none
+  std::atomic<int> interruptReason_{0};
+
+  friend class internal::ExecutionScope;
+  friend class internal::Watchdog;
+
+  std::atomic_bool heapAboveSoftLimit_{false};
+  std::atomic_bool heapLimitReachedPending_{false};
+
   // non-template version of ClassDefine related api
  private:
   void registerNativeClassInternal(
@@ -269,6 +577,28 @@ class ScriptEngine {
                                          const internal::ClassDefineState* classDefine) = 0;
 };
 
+namespace internal {
+
+/**
+ * marks a script execution the timeout and interrupt apply to, used by backend.
+ * nested scopes are part of the outermost one.
+ */
+class ExecutionScope {
+ public:
+  explicit ExecutionScope(ScriptEngine* engine);
+
+  ~ExecutionScope();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(ExecutionScope);
+
+ private:
+  ScriptEngine* engine_;
+  bool outermost_;
+  bool watched_ = false;
+};
+
+}  // namespace internal
+
 /**
  * ScriptEngine don't have public destructor, use ScriptEngine::Deleter.
  */
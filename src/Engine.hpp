@@ -72,4 +72,13 @@ inline std::shared_ptr<T> ScriptEngine::getData() {
   return std::static_pointer_cast<T>(userData_);
 }
 
+template <typename T>
+inline T& ScriptEngine::getInternalState() {
+  auto& state = internalState_[internal::typeIndexOf<T>()];
+  if (!state) {
+    state = std::make_shared<T>();
+  }
+  return *static_cast<T*>(state.get());
+}
+
 }  // namespace script
\ No newline at end of file
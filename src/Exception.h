@@ -18,6 +18,7 @@
 #pragma once
 
 #include <ostream>
+#include <string>
 #include <string_view>
 #include "Reference.h"
 #include "foundation.h"
@@ -84,6 +85,53 @@ class Exception : public std::exception {
   friend typename internal::ImplType<ScriptEngine>::type;
 };
 
+/**
+ * why a script execution is terminated, see TerminationException.
+ */
+enum class TerminationReason {
+  /**
+   * by ScriptEngine::interrupt
+   */
+  kInterrupt,
+  /**
+   * the execution runs longer than the timeout, see ScriptEngine::setExecutionTimeout
+   */
+  kTimeout,
+  /**
+   * the heap grows beyond the hardLimit (V8 only, other engines fail the allocation)
+   */
+  kHeapLimit,
+};
+
+/**
+ * thrown to the native caller when the script execution is terminated,
+ * see ScriptEngine::interrupt and ScriptEngine::setExecutionTimeout.
+ * unlike other exceptions, script can't catch it.
+ */
+class TerminationException : public Exception {
+ public:
+  explicit TerminationException(TerminationReason reason)
+      : Exception(std::string("script execution terminated: ") + reasonName(reason)),
+        reason_(reason) {}
+
+  TerminationReason reason() const { return reason_; }
+
+ private:
+  static const char* reasonName(TerminationReason reason) {
+    switch (reason) {
+      case TerminationReason::kInterrupt:
+        return "interrupted";
+      case TerminationReason::kTimeout:
+        return "timeout";
+      case TerminationReason::kHeapLimit:
+        return "heap limit exceeded";
+    }
+    return "unknown";
+  }
+
+  TerminationReason reason_;
+};
+
 inline std::ostream& operator<<(std::ostream& out, const Exception& e) {
   out << e.message() << std::endl << e.stacktrace() << std::endl;
   return out;
@@ -16,6 +16,9 @@
  */
 
 #include <ScriptX/ScriptX.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
 
 namespace script {
 
@@ -131,6 +134,104 @@ void ClassDefineState::visit(script::ClassDefineVisitor& visitor) const {
 
 #endif
 
+namespace {
+
+struct AsyncCall {
+  ScriptEngine* engine;
+  std::weak_ptr<utils::MessageQueue> queue;
+  Promise::Resolver resolver;
+  std::function<AsyncCompletion()> work;
+  AsyncCompletion completion;
+};
+
+AsyncCompletion rejectWith(std::string message) {
+  return [message = std::move(message)]() -> Local<Value> { throw Exception(message); };
+}
+
+void deleteAsyncCall(utils::Message& message) { delete static_cast<AsyncCall*>(message.ptr0); }
+
+// on the engine thread
+void completeAsyncCall(utils::Message& message) {
+  std::unique_ptr<AsyncCall> call(static_cast<AsyncCall*>(message.ptr0));
+  message.ptr0 = nullptr;
+  if (call->resolver.isEmpty()) {
+    // the engine is destroyed, the queue is shared with others
+    return;
+  }
+
+  EngineScope scope(call->engine);
+  try {
+    call->resolver.resolve(call->completion());
+  } catch (const Exception& e) {
+    call->resolver.reject(e.exception());
+  }
+  call.reset();
+}
+
+// settle the promise on the engine thread
+void postCompletion(AsyncCall* call) {
+  // release the arguments here
+  call->work = nullptr;
+
+  auto queue = call->queue.lock();
+  if (!queue) {
+    // the engine is destroyed with its queue, references are already reset
+    delete call;
+    return;
+  }
+  utils::Message completion(completeAsyncCall, deleteAsyncCall);
+  completion.name = "AsyncFunctionCompletion";
+  completion.ptr0 = call;
+  completion.tag = call->engine;
+  queue->postMessage(completion);
+}
+
+// on the ThreadPool
+void runAsyncWork(utils::Message& message) {
+  auto call = static_cast<AsyncCall*>(message.ptr0);
+  message.ptr0 = nullptr;
+  try {
+    call->completion = call->work();
+  } catch (const std::exception& e) {
+    call->completion = rejectWith(e.what());
+  } catch (...) {
+    call->completion = rejectWith("unknown exception in async function");
+  }
+  postCompletion(call);
+}
+
+}  // namespace
+
+Local<Value> postAsyncWork(const std::shared_ptr<utils::ThreadPool>& pool,
+                           std::function<AsyncCompletion()> work) {
+  auto& engine = EngineScope::currentEngineChecked();
+  auto resolver = Promise::newPromise();
+  auto promise = resolver.getPromise();
+
+  auto call =
+      new AsyncCall{&engine, engine.messageQueue(), std::move(resolver), std::move(work), {}};
+  utils::Message message(runAsyncWork, [](utils::Message& msg) {
+    if (msg.ptr0) {
+      // dropped by ThreadPool::shutdownNow. the references can't be released here,
+      // reject on the engine thread instead.
+      auto call = static_cast<AsyncCall*>(msg.ptr0);
+      msg.ptr0 = nullptr;
+      call->completion = rejectWith("async function cancelled");
+      postCompletion(call);
+    }
+  });
+  message.name = "AsyncFunction";
+  message.ptr0 = call;
+  pool->postMessage(message);
+  return promise;
+}
+
+const std::shared_ptr<utils::ThreadPool>& defaultAsyncThreadPool() {
+  static auto pool = std::make_shared<utils::ThreadPool>(
+      std::max<size_t>(1, std::thread::hardware_concurrency()));
+  return pool;
+}
+
 }  // namespace internal
 
 }  // namespace script
\ No newline at end of file
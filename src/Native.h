@@ -25,6 +25,7 @@
 #include "Exception.h"
 #include "Reference.h"
 #include "Scope.h"
+#include "utils/ThreadPool.h"
 #include SCRIPTX_BACKEND(Native.h)
 #include SCRIPTX_BACKEND(Engine.h)
 #include SCRIPTX_BACKEND(Utils.h)
@@ -370,6 +371,25 @@ auto selectOverloadedFunc(std::decay_t<Signature> func) {
   return func;
 }
 
+namespace internal {
+
+// runs on the engine thread, the return value resolves the promise of an async function
+using AsyncCompletion = std::function<Local<Value>()>;
+
+/**
+ * run work on the pool, then the completion it returns on the current engine's MessageQueue.
+ * @return a Promise, rejected if work or the completion throws.
+ */
+Local<Value> postAsyncWork(const std::shared_ptr<utils::ThreadPool>& pool,
+                           std::function<AsyncCompletion()> work);
+
+/**
+ * used by asyncFunction without a ThreadPool, created on first use.
+ */
+const std::shared_ptr<utils::ThreadPool>& defaultAsyncThreadPool();
+
+}  // namespace internal
+
 // ==== ClassDefine ====
 
 namespace internal {
@@ -320,6 +320,74 @@ inline FunctionCallback bindStaticFunc(const FunctionCallback& func, bool, bool
   return func;
 }
 
+// async functions run off the engine thread, script references can't go there
+template <typename T>
+struct IsScriptReference : std::false_type {};
+
+template <typename T>
+struct IsScriptReference<Local<T>> : std::true_type {};
+
+template <typename T>
+struct IsScriptReference<Global<T>> : std::true_type {};
+
+template <typename T>
+struct IsScriptReference<Weak<T>> : std::true_type {};
+
+template <typename T, typename D = std::decay_t<T>>
+constexpr bool isAsyncSafe = std::is_void_v<D> || (!IsScriptReference<D>::value &&
+                                                   !std::is_same_v<D, Arguments> &&
+                                                   !std::is_pointer_v<D>);
+
+template <typename Tuple>
+struct AsyncArgs;
+
+template <typename... Args>
+struct AsyncArgs<std::tuple<Args...>> {
+  // owned copies of the arguments, moved to the worker thread
+  using Tuple = std::tuple<std::decay_t<Args>...>;
+  static constexpr bool kIsSafe = (isAsyncSafe<Args> && ...);
+};
+
+// bind async function, see ClassDefineBuilder::asyncFunction
+template <typename Func>
+std::enable_if_t<::script::converter::isConvertible<typename FuncTrait<Func>::ReturnType> &&
+                     isArgsConvertible<typename FuncTrait<Func>::Arguments>,
+                 FunctionCallback>
+bindAsyncFunc(std::shared_ptr<utils::ThreadPool> pool, Func&& func, bool nothrow) {
+  using Ret = typename FuncTrait<Func>::ReturnType;
+  using Args = typename FuncTrait<Func>::Arguments;
+  static_assert(isAsyncSafe<Ret> && AsyncArgs<Args>::kIsSafe,
+                "arguments and return value of async function must be plain C++ values, "
+                "no script reference or pointer, they are used on another thread.");
+
+  auto f = std::make_shared<std::decay_t<Func>>(std::forward<Func>(func));
+  return [pool = std::move(pool), f = std::move(f),
+          nothrow](const Arguments& args) -> Local<Value> {
+    // convert on the engine thread, by calling a function capturing the converted arguments
+    std::optional<typename AsyncArgs<Args>::Tuple> cppArgs;
+    auto capture = [&cppArgs](auto&&... cppArg) {
+      cppArgs.emplace(std::forward<decltype(cppArg)>(cppArg)...);
+    };
+    using Helper = ConvertingFuncCallHelper<std::pair<void, Args>>;
+    auto ret = Helper::call(capture, args, nothrow, false);
+    if (!cppArgs) {
+      // conversion failed, and nothrow
+      return ret;
+    }
+
+    return postAsyncWork(pool, [f, cppArgs = std::move(*cppArgs)]() mutable -> AsyncCompletion {
+      if constexpr (std::is_void_v<Ret>) {
+        std::apply(*f, std::move(cppArgs));
+        return []() { return Local<Value>(); };
+      } else {
+        return [ret = std::apply(*f, std::move(cppArgs))]() -> Local<Value> {
+          return TypeConverter<Ret>::toScript(ret);
+        };
+      }
+    });
+  };
+}
+
 template <typename... Func>
 FunctionCallback adaptOverLoadedFunction(Func&&... functions) {
   std::vector funcs{bindStaticFunc(std::forward<Func>(functions), false, true)...};
@@ -640,6 +708,16 @@ Local<Array>::set(size_t index, T&& value) const {
   set(index, static_cast<const Local<Value>&>(val));
 }
 
+template <typename Callback>
+inline void Local<Array>::forEach(Callback&& callback) const {
+  using CallbackType = std::remove_reference_t<Callback>;
+  forEachImpl(
+      [](void* data, size_t index, const Local<Value>& element) {
+        (*static_cast<CallbackType*>(data))(index, element);
+      },
+      const_cast<void*>(static_cast<const void*>(&callback)));
+}
+
 template <typename T>
 inline internal::type_t<void, std::void_t<decltype(&internal::TypeConverter<T>::toScript)>>
 InternalStoreHelper::set(T&& value) const {
@@ -894,6 +972,35 @@ class ClassDefineBuilder : public internal::InstanceDefineBuilder<T> {
     return *this;
   }
 
+  /**
+   * bind a function running on a ThreadPool instead of the engine thread,
+   * script gets a Promise of its return value, (Lua as well, see docs/en/Lua.md#promise).
+   *
+   * Arguments are converted on the engine thread, and the return value is converted back on the
+   * engine thread through the engine's MessageQueue, which must be looped.
+   * So they must be plain C++ values, no Local/Global, no pointer.
+   * An exception thrown by func rejects the promise with its what().
+   *
+   * \code
+   * defineClass("fs").asyncFunction("readFile", [](std::string path) { return readAll(path); })
+   * // js: fs.readFile("a.txt").then(content => {})
+   * // lua: fs.readFile("a.txt"):next(function(content) end)
+   * \endcode
+   *
+   * @param pool the ThreadPool to run func, null to use a pool shared by all engines
+   */
+  template <typename Func>
+  sfina<decltype(internal::bindAsyncFunc(nullptr, std::declval<Func>(), false))> asyncFunction(
+      std::string name, Func func, std::shared_ptr<utils::ThreadPool> pool = {},
+      bool nothrow = internal::kBindingNoThrowDefaultValue) {
+    if (!pool) {
+      pool = internal::defaultAsyncThreadPool();
+    }
+    functions_.push_back(internal::StaticDefine::FunctionDefine{
+        std::move(name), internal::bindAsyncFunc(std::move(pool), std::move(func), nothrow), {}});
+    return *this;
+  }
+
   template <typename G, typename S = SetterCallback>
   sfina<decltype(internal::bindStaticGet(std::declval<G>(), false)),
         decltype(internal::bindStaticSet(std::declval<S>(), false))>
@@ -16,8 +16,22 @@
  */
 
 #pragma once
+#include <array>
 #include <cstdint>
 #include <cstdlib>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+#include "Engine.h"
 #include "Reference.h"
 #include "Scope.h"
 #include "Utils.h"
@@ -44,6 +58,9 @@ namespace script::converter {
  *
  * 7. any pointer of subclass of ScriptClass
  *
+ * 8. containers of supported types: vector array span(to script only) as script array;
+ *    map unordered_map with std::string key as script object
+ *
  * see docs and UnitTests for more detail
  *
  */
@@ -202,6 +219,156 @@ struct Converter<T, std::enable_if_t<StringLikeConceptCondition(T)>> {
   static T toCpp(const Local<Value>& str) { return toCpp(str.asString().toStringHolder()); }
 };
 
+namespace detail {
+
+template <typename T, typename Container>
+Local<Value> sequenceToScript(const Container& container) {
+  // create the array in one go, instead of set element one by one
+  std::vector<Local<Value>> elements;
+  elements.reserve(std::size(container));
+  for (auto&& element : container) {
+    elements.push_back(Converter<T>::toScript(element));
+  }
+  return Array::newArray(elements);
+}
+
+template <typename Map>
+Local<Value> mapToScript(const Map& map) {
+  auto object = Object::newObject();
+  for (auto&& [key, value] : map) {
+    object.set(String::newString(key), Converter<typename Map::mapped_type>::toScript(value));
+  }
+  return object;
+}
+
+// whether the converted value holds Locals, which must not outlive the element
+template <typename T>
+struct HoldsLocal : std::false_type {};
+
+template <typename T>
+struct HoldsLocal<Local<T>> : std::true_type {};
+
+template <typename T, typename Alloc>
+struct HoldsLocal<std::vector<T, Alloc>> : HoldsLocal<T> {};
+
+template <typename T, size_t N>
+struct HoldsLocal<std::array<T, N>> : HoldsLocal<T> {};
+
+template <typename V, typename Compare, typename Alloc>
+struct HoldsLocal<std::map<std::string, V, Compare, Alloc>> : HoldsLocal<V> {};
+
+template <typename V, typename Hash, typename KeyEqual, typename Alloc>
+struct HoldsLocal<std::unordered_map<std::string, V, Hash, KeyEqual, Alloc>> : HoldsLocal<V> {};
+
+/**
+ * visit elements converted to T.
+ * Array::forEach is cheaper, but its elements die with the callback,
+ * so converted Locals are taken with get() in the caller's scope instead.
+ */
+template <typename T, typename Visitor>
+void forEachConverted(const Local<Array>& array, Visitor&& visitor) {
+  if constexpr (HoldsLocal<T>::value) {
+    auto size = array.size();
+    for (size_t i = 0; i < size; ++i) {
+      visitor(i, Converter<T>::toCpp(array.get(i)));
+    }
+  } else {
+    array.forEach([&visitor](size_t index, const Local<Value>& element) {
+      visitor(index, Converter<T>::toCpp(element));
+    });
+  }
+}
+
+template <typename Map>
+Map mapToCpp(const Local<Value>& value) {
+  auto object = value.asObject();
+  Map ret;
+  for (auto&& key : object.getKeys()) {
+    ret.emplace(key.toString(), Converter<typename Map::mapped_type>::toCpp(object.get(key)));
+  }
+  return ret;
+}
+
+}  // namespace detail
+
+/**
+ * std::vector <-> array
+ */
+template <typename T, typename Alloc>
+struct Converter<std::vector<T, Alloc>> {
+  static Local<Value> toScript(const std::vector<T, Alloc>& value) {
+    return detail::sequenceToScript<T>(value);
+  }
+
+  static std::vector<T, Alloc> toCpp(const Local<Value>& value) {
+    auto array = value.asArray();
+    std::vector<T, Alloc> ret;
+    ret.reserve(array.size());
+    detail::forEachConverted<T>(array, [&ret](size_t, auto&& element) {
+      ret.push_back(static_cast<T>(std::forward<decltype(element)>(element)));
+    });
+    return ret;
+  }
+};
+
+/**
+ * std::array <-> array, throw if the length doesn't match
+ */
+template <typename T, size_t N>
+struct Converter<std::array<T, N>> {
+  static Local<Value> toScript(const std::array<T, N>& value) {
+    return detail::sequenceToScript<T>(value);
+  }
+
+  static std::array<T, N> toCpp(const Local<Value>& value) {
+    auto array = value.asArray();
+    if (array.size() != N) {
+      throw Exception("array length mismatch");
+    }
+    std::array<T, N> ret{};
+    detail::forEachConverted<T>(array, [&ret](size_t index, auto&& element) {
+      if (index < N) ret[index] = static_cast<T>(std::forward<decltype(element)>(element));
+    });
+    return ret;
+  }
+};
+
+#ifdef __cpp_lib_span
+/**
+ * std::span -> array, a span can't own the elements, so there's no toCpp
+ */
+template <typename T, size_t Extent>
+struct Converter<std::span<T, Extent>> {
+  static Local<Value> toScript(std::span<T, Extent> value) {
+    return detail::sequenceToScript<std::remove_cv_t<T>>(value);
+  }
+};
+#endif
+
+/**
+ * std::map <-> object
+ */
+template <typename V, typename Compare, typename Alloc>
+struct Converter<std::map<std::string, V, Compare, Alloc>> {
+  using Map = std::map<std::string, V, Compare, Alloc>;
+
+  static Local<Value> toScript(const Map& value) { return detail::mapToScript(value); }
+
+  static Map toCpp(const Local<Value>& value) { return detail::mapToCpp<Map>(value); }
+};
+
+/**
+ * std::unordered_map <-> object
+ */
+template <typename V, typename Hash, typename KeyEqual, typename Alloc>
+struct Converter<std::unordered_map<std::string, V, Hash, KeyEqual, Alloc>> {
+  using Map = std::unordered_map<std::string, V, Hash, KeyEqual, Alloc>;
+
+  static Local<Value> toScript(const Map& value) { return detail::mapToScript(value); }
+
+  static Map toCpp(const Local<Value>& value) { return detail::mapToCpp<Map>(value); }
+};
+
 // ScriptX types bypass
 template <>
 struct Converter<Local<Value>> {
@@ -230,6 +397,8 @@ ConverterSubType(Array);
 
 ConverterSubType(ByteBuffer);
 
+ConverterSubType(Promise);
+
 ConverterSubType(Unsupported);
 
 #undef ConverterSubType
@@ -273,4 +442,200 @@ constexpr bool isConvertible = internal::IsConvertibleHelper<T>::value;
 
 }  // namespace converter
 
-}  // namespace script
\ No newline at end of file
+}  // namespace script
+
+namespace script::internal {
+
+template <typename T, typename M>
+struct StructField {
+  const char* name;
+  M T::*member;
+};
+
+template <typename T, typename M>
+constexpr StructField<T, M> structField(const char* name, M T::*member) {
+  return {name, member};
+}
+
+/**
+ * property keys of a SCRIPTX_STRUCT type, interned once per engine.
+ */
+template <typename T>
+struct StructKeys {
+  std::vector<Global<String>> keys;
+};
+
+/**
+ * Converter of SCRIPTX_STRUCT types, Derived::fields() returns a tuple of StructField.
+ * Fields are always set in the same order with the same key strings,
+ * so engines can reuse the object shape (V8 hidden class, QuickJs shape) across objects.
+ */
+template <typename T, typename Derived>
+struct StructConverter {
+  static Local<Value> toScript(const T& value) {
+    auto fields = Derived::fields();
+    auto& keys = internKeys(fields);
+    auto object = Object::newObject();
+    size_t index = 0;
+    std::apply(
+        [&](const auto&... field) {
+          (object.set(keys[index++].get(), toScriptField(value.*(field.member))), ...);
+        },
+        fields);
+    return object;
+  }
+
+  static T toCpp(const Local<Value>& value) {
+    auto fields = Derived::fields();
+    auto& keys = internKeys(fields);
+    auto object = value.asObject();
+    T ret{};
+    size_t index = 0;
+    std::apply(
+        [&](const auto&... field) {
+          (readField(object, keys[index++], ret.*(field.member)), ...);
+        },
+        fields);
+    return ret;
+  }
+
+ private:
+  template <typename Fields>
+  static const std::vector<Global<String>>& internKeys(const Fields& fields) {
+    auto& keys = EngineScope::currentEngineChecked().getInternalState<StructKeys<T>>().keys;
+    if (keys.empty()) {
+      std::apply(
+          [&keys](const auto&... field) {
+            (keys.emplace_back(String::newString(field.name)), ...);
+          },
+          fields);
+    }
+    return keys;
+  }
+
+  template <typename M>
+  static Local<Value> toScriptField(const M& member) {
+    return converter::Converter<M>::toScript(member);
+  }
+
+  template <typename M>
+  static void readField(const Local<Object>& object, const Global<String>& key, M& member) {
+    auto field = object.get(key.get());
+    // missing fields keep the default value
+    if (!field.isNull()) {
+      member = static_cast<M>(converter::Converter<M>::toCpp(field));
+    }
+  }
+};
+
+}  // namespace script::internal
+
+// preprocessor helpers of SCRIPTX_STRUCT, up to 32 arguments
+#define SCRIPTX_MARCO_EXPAND(x) x
+#define SCRIPTX_MARCO_ARG_COUNT(...)                                                              \
+  SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_ARG_COUNT_INNER(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, \
+                                                     24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14,  \
+                                                     13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define SCRIPTX_MARCO_ARG_COUNT_INNER(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, \
+                                      _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24,  \
+                                      _25, _26, _27, _28, _29, _30, _31, _32, N, ...)         \
+  N
+// SCRIPTX_MARCO_JOIN is undefined at the end of ScriptX.h, but these are used by user code
+#define SCRIPTX_MARCO_FOR_EACH_JOIN(x, y) SCRIPTX_MARCO_FOR_EACH_JOIN_INNER(x, y)
+#define SCRIPTX_MARCO_FOR_EACH_JOIN_INNER(x, y) x##y
+#define SCRIPTX_MARCO_FOR_EACH(m, d, ...)                                                    \
+  SCRIPTX_MARCO_EXPAND(                                                                      \
+      SCRIPTX_MARCO_FOR_EACH_JOIN(SCRIPTX_MARCO_FOR_EACH_, SCRIPTX_MARCO_ARG_COUNT(__VA_ARGS__))( \
+          m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_1(m, d, x) m(d, x)
+#define SCRIPTX_MARCO_FOR_EACH_2(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_1(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_3(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_2(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_4(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_3(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_5(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_4(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_6(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_5(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_7(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_6(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_8(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_7(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_9(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_8(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_10(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_9(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_11(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_10(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_12(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_11(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_13(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_12(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_14(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_13(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_15(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_14(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_16(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_15(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_17(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_16(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_18(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_17(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_19(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_18(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_20(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_19(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_21(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_20(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_22(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_21(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_23(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_22(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_24(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_23(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_25(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_24(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_26(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_25(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_27(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_26(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_28(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_27(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_29(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_28(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_30(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_29(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_31(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_30(m, d, __VA_ARGS__))
+#define SCRIPTX_MARCO_FOR_EACH_32(m, d, x, ...) \
+  m(d, x), SCRIPTX_MARCO_EXPAND(SCRIPTX_MARCO_FOR_EACH_31(m, d, __VA_ARGS__))
+
+#define SCRIPTX_STRUCT_FIELD(Type, field) ::script::internal::structField(#field, &Type::field)
+
+/**
+ * define Converter for a plain struct, so it can be used as function parameter or return value,
+ * and is converted to/from a script object with the listed fields.
+ * T must be default constructible, and fields must be convertible types.
+ * MUST be used in the global namespace.
+ *
+ * \code
+ * struct Point {
+ *   double x;
+ *   double y;
+ *   std::string label;
+ * };
+ *
+ * SCRIPTX_STRUCT(Point, x, y, label);
+ * \endcode
+ */
+#define SCRIPTX_STRUCT(Type, ...)                                                       \
+  namespace script::converter {                                                         \
+  template <>                                                                           \
+  struct Converter<Type> : ::script::internal::StructConverter<Type, Converter<Type>> { \
+    static auto fields() {                                                              \
+      return std::make_tuple(                                                           \
+          SCRIPTX_MARCO_FOR_EACH(SCRIPTX_STRUCT_FIELD, Type, __VA_ARGS__));             \
+    }                                                                                   \
+  };                                                                                    \
+  }
@@ -41,4 +41,14 @@ std::vector<std::string> Local<Object>::getKeyNames() const {
   return ret;
 }
 
+Promise::Resolver::Resolver(const Local<Promise>& promise, const Local<Value>& handle)
+    : promise_(promise), handle_(handle) {}
+
+Local<Promise> Promise::Resolver::getPromise() const { return promise_.get(); }
+
+void Promise::Resolver::reset() {
+  promise_.reset();
+  handle_.reset();
+}
+
 }  // namespace script
@@ -292,6 +292,11 @@ class Local<Value> {
 
   bool isByteBuffer() const;
 
+  /**
+   * note: a promise is also an object, getKind() returns ValueKind::kObject.
+   */
+  bool isPromise() const;
+
   bool isUnsupported() const;
 
   Local<Object> asObject() const;
@@ -300,6 +305,8 @@ class Local<Value> {
 
   Local<ByteBuffer> asByteBuffer() const;
 
+  Local<Promise> asPromise() const;
+
   Local<String> asString() const;
 
   Local<Number> asNumber() const;
@@ -530,7 +537,28 @@ class Local<Array> {
 
   void clear() const;
 
+  /**
+   * visit all elements in one pass, which is cheaper than calling get for each index.
+   *
+   * \code
+   * std::vector<double> vec;
+   * array.forEach([&vec](size_t index, const Local<Value>& element) {
+   *   vec.push_back(element.asNumber().toDouble());
+   * });
+   * \endcode
+   *
+   * @param callback void(size_t index, const Local<Value>& element),
+   * the element is only valid during the callback.
+   */
+  template <typename Callback>
+  void forEach(Callback&& callback) const;
+
   SPECIALIZE_NON_VALUE(Array)
+
+ private:
+  using ForEachCallback = void (*)(void* data, size_t index, const Local<Value>& element);
+
+  void forEachImpl(ForEachCallback callback, void* data) const;
 };
 
 /**
@@ -629,6 +657,31 @@ class Local<ByteBuffer> {
   SPECIALIZE_NON_VALUE(ByteBuffer);
 };
 
+template <>
+class Local<Promise> {
+  SPECIALIZE_LOCAL(Promise)
+
+ public:
+  /**
+   * note: QuickJs needs the patch in backend/QuickJs/patch, otherwise an Exception is thrown.
+   */
+  Promise::State getState() const;
+
+  /**
+   * @return the value if fulfilled, the reason if rejected, null if pending.
+   */
+  Local<Value> getResult() const;
+
+  /**
+   * same as `promise.then(onFulfilled, onRejected)` in JavaScript,
+   * non-function callbacks are ignored.
+   * @return the derived promise
+   */
+  Local<Promise> then(const Local<Value>& onFulfilled, const Local<Value>& onRejected = {}) const;
+
+  SPECIALIZE_NON_VALUE(Promise)
+};
+
 template <>
 class Local<Unsupported> {
   SPECIALIZE_LOCAL(Unsupported)
@@ -640,4 +693,54 @@ class Local<Unsupported> {
 #undef SPECIALIZE_LOCAL
 #undef SPECIALIZE_NON_VALUE
 
+/**
+ * Settles a promise created by Promise::newPromise.
+ * It holds global references, so it can be kept until the native work completes.
+ * All methods must be called with EngineScope of the engine that created it,
+ * and it should be destroyed or reset before the engine.
+ *
+ * Only the first resolve or reject takes effect, like the resolving functions in JavaScript.
+ */
+class Promise::Resolver {
+ public:
+  Resolver(const Resolver& copy) = default;
+
+  Resolver(Resolver&& move) noexcept = default;
+
+  Resolver& operator=(const Resolver& assign) = default;
+
+  Resolver& operator=(Resolver&& move) noexcept = default;
+
+  ~Resolver() = default;
+
+  Local<Promise> getPromise() const;
+
+  /**
+   * resolve with a value, or another promise to follow.
+   */
+  void resolve(const Local<Value>& value) const;
+
+  void reject(const Local<Value>& reason) const;
+
+  /**
+   * release the references, the promise is kept alive by the script (if any).
+   */
+  void reset();
+
+  /**
+   * @return true after reset(), or once the engine is destroyed.
+   * doesn't need EngineScope.
+   */
+  bool isEmpty() const { return promise_.isEmpty(); }
+
+ private:
+  Resolver(const Local<Promise>& promise, const Local<Value>& handle);
+
+  Global<Promise> promise_;
+  // backend defined, eg: the resolving functions
+  Global<Value> handle_;
+
+  friend class Promise;
+};
+
 }  // namespace script
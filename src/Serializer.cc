@@ -0,0 +1,370 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Serializer.h"
+#include <ScriptX/ScriptX.h>
+#include <cmath>
+#include <cstring>
+
+namespace script {
+
+namespace {
+
+constexpr uint8_t kMagic = 0xA7;
+constexpr uint8_t kVersion = 1;
+
+// one byte tag before each value
+enum class Tag : uint8_t {
+  kNull = '0',
+  kTrue = 'T',
+  kFalse = 'F',
+  // integral numbers, zigzag varint
+  kInteger = 'I',
+  kDouble = 'D',
+  kString = 'S',
+  kArray = 'A',
+  kObject = 'O',
+  kByteBuffer = 'B',
+  kTransferredByteBuffer = 'X',
+  // an array, object or ByteBuffer written before, by id
+  kReference = 'R',
+};
+
+#if defined(SCRIPTX_BACKEND_V8) && V8_MAJOR_VERSION >= 8
+// the shared_ptr holds the v8::BackingStore, which doesn't depend on the engine
+constexpr bool kCanTransferByteBuffer = true;
+
+void detach(const Local<ByteBuffer>& buffer) {
+  auto value = v8_interop::toV8(v8_interop::currentEngineIsolateChecked(), buffer);
+  auto arrayBuffer = value->IsArrayBuffer() ? value.As<v8::ArrayBuffer>()
+                                            : value.As<v8::ArrayBufferView>()->Buffer();
+  // wasm memory for example, it stays shared
+  if (arrayBuffer->IsDetachable()) {
+    arrayBuffer->Detach();
+  }
+}
+#else
+// the shared_ptr keeps a reference inside the source engine, it must not cross engines
+constexpr bool kCanTransferByteBuffer = false;
+
+void detach(const Local<ByteBuffer>&) {}
+#endif
+
+// deeper nesting is more likely corrupted data, also guards the c++ stack
+constexpr int kMaxDepth = 1000;
+
+// 2^53, integers beyond it can't be represented exactly in JavaScript
+constexpr double kMaxSafeInteger = 9007199254740992.0;
+
+bool isPlainArray(const Local<Value>& value) {
+#ifdef SCRIPTX_LANG_LUA
+  // every lua table is an array, those with string keys are objects
+  return value.isArray() && value.asObject().getKeys().empty();
+#else
+  return value.isArray();
+#endif
+}
+
+[[noreturn]] void throwCorrupted() { throw Exception("invalid serialized data"); }
+
+}  // namespace
+
+Serializer::Serializer() { bytes_ = {static_cast<char>(kMagic), static_cast<char>(kVersion)}; }
+
+Serializer::~Serializer() = default;
+
+void Serializer::transfer(const Local<ByteBuffer>& buffer) {
+  if (kCanTransferByteBuffer) {
+    transferList_.emplace_back(buffer);
+  }
+}
+
+void Serializer::writeValue(const Local<Value>& value) {
+  if (value.isNull()) {
+    bytes_.push_back(static_cast<char>(Tag::kNull));
+  } else if (value.isBoolean()) {
+    auto tag = value.asBoolean().value() ? Tag::kTrue : Tag::kFalse;
+    bytes_.push_back(static_cast<char>(tag));
+  } else if (value.isNumber()) {
+    writeNumber(value.asNumber().toDouble());
+  } else if (value.isString()) {
+    bytes_.push_back(static_cast<char>(Tag::kString));
+    writeString(value.asString().toStringHolder().stringView());
+  } else if (value.isByteBuffer()) {
+    if (!writeReference(value)) {
+      writeByteBuffer(value.asByteBuffer());
+    }
+  } else if (value.isFunction()) {
+    throw Exception("can't serialize a function");
+  } else if (isPlainArray(value)) {
+    if (!writeReference(value)) {
+      if (++depth_ > kMaxDepth) {
+        throw Exception("can't serialize, nesting too deep");
+      }
+      auto array = value.asArray();
+      bytes_.push_back(static_cast<char>(Tag::kArray));
+      writeVarint(array.size());
+      array.forEach([this](size_t, const Local<Value>& element) { writeValue(element); });
+      --depth_;
+    }
+  } else if (value.isObject()) {
+    if (!isPlainObject(value)) {
+      throw Exception("value is not serializable");
+    }
+    if (!writeReference(value)) {
+      if (++depth_ > kMaxDepth) {
+        throw Exception("can't serialize, nesting too deep");
+      }
+      auto object = value.asObject();
+      auto keys = object.getKeys();
+      bytes_.push_back(static_cast<char>(Tag::kObject));
+      writeVarint(keys.size());
+      for (auto& key : keys) {
+        StackFrameScope stack;
+        writeString(key.toStringHolder().stringView());
+        writeValue(object.get(key));
+      }
+      --depth_;
+    }
+  } else {
+    throw Exception("can't serialize value of unsupported type");
+  }
+}
+
+SerializedData Serializer::release() {
+  // like postMessage, the senders lose their transferred buffers once the data is complete
+  for (auto& buffer : transferredBuffers_) {
+    detach(buffer.get());
+  }
+  transferredBuffers_.clear();
+
+  SerializedData data{std::move(bytes_), std::move(transferred_)};
+  bytes_ = {static_cast<char>(kMagic), static_cast<char>(kVersion)};
+  transferred_.clear();
+  transferList_.clear();
+  objects_.clear();
+  nextId_ = 0;
+  depth_ = 0;
+  // the next use may be in another engine
+  getPrototypeOf_.reset();
+  objectPrototype_.reset();
+  return data;
+}
+
+bool Serializer::writeReference(const Local<Value>& value) {
+  auto hash = internal::identityHash(value);
+  auto range = objects_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second.first.get() == value) {
+      bytes_.push_back(static_cast<char>(Tag::kReference));
+      writeVarint(it->second.second);
+      return true;
+    }
+  }
+  objects_.emplace(hash, std::make_pair(Global<Value>(value), nextId_++));
+  return false;
+}
+
+bool Serializer::isPlainObject(const Local<Value>& value) {
+  if (value.isPromise()) {
+    return false;
+  }
+#ifdef SCRIPTX_LANG_JAVASCRIPT
+  if (getPrototypeOf_.isEmpty()) {
+    auto object = EngineScope::currentEngineChecked().get("Object").asObject();
+    getPrototypeOf_ = object.get("getPrototypeOf").asFunction();
+    objectPrototype_ = object.get("prototype");
+  }
+  auto prototype = getPrototypeOf_.get().call({}, value);
+  return prototype.isNull() || prototype == objectPrototype_.get();
+#else
+  // lua has no Date/Map/Set, tables with a metatable are written by their content
+  return true;
+#endif
+}
+
+void Serializer::writeByteBuffer(const Local<ByteBuffer>& buffer) {
+  for (auto& transfer : transferList_) {
+    if (transfer.get() == buffer) {
+      bytes_.push_back(static_cast<char>(Tag::kTransferredByteBuffer));
+      writeVarint(transferred_.size());
+      transferred_.emplace_back(buffer.getRawBytesShared(), buffer.byteLength());
+      transferredBuffers_.emplace_back(buffer);
+      return;
+    }
+  }
+
+  buffer.sync();
+  auto length = buffer.byteLength();
+  bytes_.push_back(static_cast<char>(Tag::kByteBuffer));
+  writeVarint(length);
+  bytes_.append(static_cast<const char*>(buffer.getRawBytes()), length);
+}
+
+void Serializer::writeNumber(double value) {
+  if (std::trunc(value) == value && std::fabs(value) <= kMaxSafeInteger &&
+      !(value == 0 && std::signbit(value))) {
+    // most numbers are small integers, and lua can tell integers from floats
+    auto integer = static_cast<int64_t>(value);
+    bytes_.push_back(static_cast<char>(Tag::kInteger));
+    // zigzag
+    writeVarint((static_cast<uint64_t>(integer) << 1) ^ static_cast<uint64_t>(integer >> 63));
+    return;
+  }
+  bytes_.push_back(static_cast<char>(Tag::kDouble));
+  char raw[sizeof(double)];
+  std::memcpy(raw, &value, sizeof(double));
+  bytes_.append(raw, sizeof(double));
+}
+
+void Serializer::writeString(std::string_view string) {
+  writeVarint(string.size());
+  bytes_.append(string.data(), string.size());
+}
+
+void Serializer::writeVarint(uint64_t value) {
+  while (value >= 0x80) {
+    bytes_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  bytes_.push_back(static_cast<char>(value));
+}
+
+Deserializer::Deserializer(const SerializedData& data) : data_(data) {
+  if (readByte() != kMagic || readByte() != kVersion) {
+    throw Exception("invalid serialized data, version mismatch");
+  }
+}
+
+Deserializer::~Deserializer() = default;
+
+Local<Value> Deserializer::readValue() {
+  switch (static_cast<Tag>(readByte())) {
+    case Tag::kNull:
+      return {};
+    case Tag::kTrue:
+      return Boolean::newBoolean(true);
+    case Tag::kFalse:
+      return Boolean::newBoolean(false);
+    case Tag::kInteger: {
+      auto zigzag = readVarint();
+      auto integer = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+      return Number::newNumber(integer);
+    }
+    case Tag::kDouble: {
+      double value;
+      std::memcpy(&value, readBytes(sizeof(double)).data(), sizeof(double));
+      return Number::newNumber(value);
+    }
+    case Tag::kString: {
+      auto length = readVarint();
+      return String::newString(readBytes(length));
+    }
+    case Tag::kArray:
+      return readObject(readVarint(), true);
+    case Tag::kObject:
+      return readObject(readVarint(), false);
+    case Tag::kByteBuffer: {
+      auto bytes = readBytes(readVarint());
+      auto buffer = ByteBuffer::newByteBuffer(const_cast<char*>(bytes.data()), bytes.size());
+      buffer.commit();
+      objects_.emplace_back(buffer);
+      return buffer;
+    }
+    case Tag::kTransferredByteBuffer: {
+      auto index = readVarint();
+      if (index >= data_.transferred.size()) {
+        throwCorrupted();
+      }
+      auto& [store, length] = data_.transferred[index];
+      auto buffer = ByteBuffer::newByteBuffer(store, length);
+      objects_.emplace_back(buffer);
+      return buffer;
+    }
+    case Tag::kReference: {
+      auto id = readVarint();
+      if (id >= objects_.size()) {
+        throwCorrupted();
+      }
+      return objects_[id].get();
+    }
+    default:
+      throwCorrupted();
+  }
+}
+
+Local<Value> Deserializer::readObject(uint64_t count, bool isArray) {
+  // each element takes at least one byte
+  if (count > data_.bytes.size() - position_) {
+    throwCorrupted();
+  }
+  if (++depth_ > kMaxDepth) {
+    throw Exception("invalid serialized data, nesting too deep");
+  }
+
+  if (isArray) {
+    auto array = Array::newArray(static_cast<size_t>(count));
+    objects_.emplace_back(array);
+    for (size_t i = 0; i < count; ++i) {
+      StackFrameScope stack;
+      array.set(i, readValue());
+    }
+    --depth_;
+    return array;
+  }
+
+  auto object = Object::newObject();
+  objects_.emplace_back(object);
+  for (size_t i = 0; i < count; ++i) {
+    StackFrameScope stack;
+    auto length = readVarint();
+    auto key = String::newString(readBytes(length));
+    object.set(key, readValue());
+  }
+  --depth_;
+  return object;
+}
+
+uint8_t Deserializer::readByte() {
+  if (position_ >= data_.bytes.size()) {
+    throwCorrupted();
+  }
+  return static_cast<uint8_t>(data_.bytes[position_++]);
+}
+
+uint64_t Deserializer::readVarint() {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    auto byte = readByte();
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throwCorrupted();
+}
+
+std::string_view Deserializer::readBytes(size_t length) {
+  if (length > data_.bytes.size() - position_) {
+    throwCorrupted();
+  }
+  auto ret = std::string_view(data_.bytes.data() + position_, length);
+  position_ += length;
+  return ret;
+}
+
+}  // namespace script
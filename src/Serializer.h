@@ -0,0 +1,172 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Reference.h"
+#include "foundation.h"
+
+namespace script {
+
+/**
+ * The output of Serializer.
+ * It doesn't reference any engine, so it can be moved to another thread,
+ * and read back by a Deserializer in another engine of any backend.
+ */
+struct SerializedData {
+  std::string bytes;
+
+  /**
+   * backing stores of the transferred ByteBuffers, referenced by index from bytes.
+   */
+  std::vector<std::pair<std::shared_ptr<void>, size_t>> transferred;
+};
+
+/**
+ * Write a graph of values into a compact binary SerializedData, like the structured clone in
+ * JavaScript. Supported values are: null, boolean, number, string, array, object and ByteBuffer.
+ * Shared references and cycles are preserved. Functions and other values throw, so do objects
+ * which are not plain (Promise, and in JavaScript anything whose prototype isn't
+ * Object.prototype or null, like Date, Map, Set or class instances) and nesting deeper than 1000.
+ * On backends without an identity hash (WebAssembly and Template) finding them is O(n^2) in the
+ * number of objects written.
+ *
+ * Must be used inside an EngineScope, and all values written must be alive until release().
+ *
+ * \code
+ * Serializer serializer;
+ * serializer.writeValue(value);
+ * auto data = serializer.release();
+ *
+ * // in another engine
+ * auto copy = Deserializer(data).readValue();
+ * \endcode
+ */
+class Serializer {
+  std::string bytes_;
+  std::vector<std::pair<std::shared_ptr<void>, size_t>> transferred_;
+  std::vector<Global<ByteBuffer>> transferList_;
+  // written by transfer, detached on release
+  std::vector<Global<ByteBuffer>> transferredBuffers_;
+  // identity hash -> (object, id), to find objects written before
+  std::unordered_multimap<size_t, std::pair<Global<Value>, uint32_t>> objects_;
+  uint32_t nextId_ = 0;
+  int depth_ = 0;
+  // Object.getPrototypeOf and Object.prototype, looked up on the first object
+  Global<Function> getPrototypeOf_;
+  Global<Value> objectPrototype_;
+
+ public:
+  Serializer();
+
+  ~Serializer();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(Serializer);
+
+  /**
+   * Mark a ByteBuffer to be transferred rather than copied.
+   * The deserialized ByteBuffer takes over the memory, and the sender's ArrayBuffer is detached
+   * (length 0, with all views on it) by release(), like postMessage does.
+   * Buffers that can't be detached (wasm memory for example) end up shared.
+   *
+   * Only V8 (8.0 and above) can transfer, because the backing store there lives independent of
+   * the engine, it keeps the engine's ArrayBuffer::Allocator alive, so it may outlive the sender.
+   * (an engine on an embedder's isolate relies on the embedder's allocator for that)
+   * Other backends copy the content as usual.
+   */
+  void transfer(const Local<ByteBuffer>& buffer);
+
+  /**
+   * @throw Exception if the value (or anything it references) can't be serialized
+   */
+  void writeValue(const Local<Value>& value);
+
+  /**
+   * @return everything written so far, the Serializer is reset and can be used again.
+   */
+  SerializedData release();
+
+ private:
+  bool writeReference(const Local<Value>& value);
+
+  bool isPlainObject(const Local<Value>& value);
+
+  void writeByteBuffer(const Local<ByteBuffer>& buffer);
+
+  void writeNumber(double value);
+
+  void writeString(std::string_view string);
+
+  void writeVarint(uint64_t value);
+};
+
+/**
+ * Read values back from a SerializedData, see Serializer.
+ * Must be used inside an EngineScope.
+ */
+class Deserializer {
+  const SerializedData& data_;
+  size_t position_ = 0;
+  int depth_ = 0;
+  // objects created so far, for shared references and cycles
+  std::vector<Global<Value>> objects_;
+
+ public:
+  /**
+   * @param data must be alive until the Deserializer is destroyed
+   */
+  explicit Deserializer(const SerializedData& data);
+
+  ~Deserializer();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(Deserializer);
+
+  /**
+   * read the next value, in the order they are written.
+   * @throw Exception if there is no more value or the data is corrupted
+   */
+  Local<Value> readValue();
+
+ private:
+  uint8_t readByte();
+
+  uint64_t readVarint();
+
+  std::string_view readBytes(size_t length);
+
+  Local<Value> readObject(uint64_t count, bool isArray);
+};
+
+namespace internal {
+
+/**
+ * Identity hash of an object, used to find shared references and cycles.
+ * The same object always has the same hash, different objects may collide.
+ * Implemented by backends, those can't get an identity return 0 for every object,
+ * which is correct but makes every lookup a linear scan.
+ */
+size_t identityHash(const Local<Value>& value);
+
+}  // namespace internal
+
+}  // namespace script
@@ -103,6 +103,29 @@ class StringHolder {
   friend struct ::script::internal::TypeHolder;
 };
 
+/**
+ * JSON parse and stringify, without going through the script JSON object.
+ * Uses the engine's native JSON implementation where there is one (V8, QuickJs, JavaScriptCore),
+ * Lua has a built-in implementation.
+ */
+class Json {
+ public:
+  Json() = delete;
+
+  /**
+   * same as JSON.parse in JavaScript.
+   * @throw Exception if json is not valid
+   */
+  static Local<Value> parse(std::string_view json);
+
+  /**
+   * same as JSON.stringify in JavaScript, without replacer and indent.
+   * @return empty string if the value has no JSON representation, eg: a function.
+   * @throw Exception on circular structure
+   */
+  static std::string stringify(const Local<Value>& value);
+};
+
 /**
  * A trace interface, used to trace method call for performance.
  */
@@ -193,6 +193,24 @@ class String : public Value {
    */
   static Local<String> newString(const std::u8string& utf8);
 #endif
+
+  /**
+   * create string from utf8 encoding string, without copying it into the engine heap if possible.
+   * Useful for large and long-lived strings that are returned to script again and again.
+   *
+   * V8 backend references ASCII strings directly (the string is kept alive until the script
+   * string is garbage collected, and its size is reported via
+   * ScriptEngine::adjustAssociatedMemory); other strings and other backends fall back to a copy.
+   *
+   * @param utf8 must not be nullptr
+   */
+  static Local<String> newExternalString(std::shared_ptr<const std::string> utf8);
+
+  /**
+   * like newExternalString, for strings that outlive the engine, eg: string literals.
+   * Nothing is kept alive or reported.
+   */
+  static Local<String> newExternalStaticString(std::string_view staticUtf8);
 };
 
 class Number : public Value {
@@ -323,6 +341,36 @@ class ByteBuffer : public Value {
   static Local<ByteBuffer> newByteBuffer(std::shared_ptr<void> nativeBuffer, size_t size);
 };
 
+/**
+ * Promise of JavaScript. For Lua, it's emulated by a global `Promise` table, see docs.
+ * A promise is an Object, getKind() returns ValueKind::kObject.
+ *
+ * Reactions (then callbacks) run as microtasks on the engine's MessageQueue,
+ * the MessageQueue must be looped for promises to make progress.
+ */
+class Promise : public Value {
+ public:
+  enum class State { kPending, kFulfilled, kRejected };
+
+  /**
+   * settle the promise from native code, see Reference.h
+   */
+  class Resolver;
+
+  /**
+   * create a pending promise.
+   * \code
+   * auto resolver = Promise::newPromise();
+   * startIo([resolver](auto result) {
+   *   EngineScope scope(engine);
+   *   resolver.resolve(String::newString(result));
+   * });
+   * return resolver.getPromise();
+   * \endcode
+   */
+  static Resolver newPromise();
+};
+
 class Unsupported : public Value {};
 
 }  // namespace script
\ No newline at end of file
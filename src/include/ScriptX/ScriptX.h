@@ -29,6 +29,7 @@
 #include "../../Native.hpp"
 #include "../../Reference.h"
 #include "../../Scope.h"
+#include "../../Serializer.h"
 #include "../../Utils.h"
 #include "../../Value.h"
 
@@ -38,8 +39,13 @@
 #endif
 
 // utils
+#include "../../utils/Allocator.h"
+#include "../../utils/CodeCache.h"
+#include "../../utils/EngineGroup.h"
+#include "../../utils/EnginePool.h"
 #include "../../utils/MessageQueue.h"
 #include "../../utils/ThreadPool.h"
+#include "../../utils/Worker.h"
 
 namespace script {
 
@@ -66,12 +66,18 @@ class Array;
 
 class ByteBuffer;
 
+class Promise;
+
 class Unsupported;
 
 // ==== exception ====
 
 class Exception;
 
+enum class TerminationReason;
+
+class TerminationException;
+
 // ==== native ====
 class Arguments;
 
@@ -121,6 +127,8 @@ enum class ScriptLanguage;
 
 class Tracer;
 
+class Json;
+
 // ==== C++ 20 concepts for StringLike ====
 
 // StringLike is of type
@@ -0,0 +1,168 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Allocator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace script::utils {
+
+void* SystemAllocator::allocate(size_t size) {
+  // malloc(0) may give nullptr, which reads as a failure
+  return std::malloc(std::max<size_t>(size, 1));
+}
+
+void* SystemAllocator::reallocate(void* ptr, size_t /*oldSize*/, size_t newSize) {
+  return std::realloc(ptr, newSize);
+}
+
+void SystemAllocator::deallocate(void* ptr, size_t /*size*/) { std::free(ptr); }
+
+ArenaAllocator::ArenaAllocator(size_t chunkSize)
+    : chunkSize_(std::max(chunkSize, kMaxSmallSize)) {}
+
+ArenaAllocator::~ArenaAllocator() {
+  // bulk free, blocks in use are not visited one by one
+  for (auto chunk : chunks_) {
+    std::free(chunk);
+  }
+  while (largeBlocks_) {
+    auto next = largeBlocks_->next;
+    std::free(largeBlocks_);
+    largeBlocks_ = next;
+  }
+}
+
+void* ArenaAllocator::allocate(size_t size) {
+  auto ptr = size <= kMaxSmallSize ? allocateSmall(classOf(size)) : allocateLarge(size);
+  if (ptr) {
+    statistics_.allocated += size;
+    statistics_.blocks++;
+  }
+  return ptr;
+}
+
+void* ArenaAllocator::reallocate(void* ptr, size_t oldSize, size_t newSize) {
+  if (oldSize <= kMaxSmallSize && newSize <= kMaxSmallSize &&
+      classOf(oldSize) == classOf(newSize)) {
+    statistics_.allocated = statistics_.allocated - oldSize + newSize;
+    return ptr;
+  }
+
+  if (oldSize > kMaxSmallSize && newSize > kMaxSmallSize) {
+    // large to large, let realloc move it
+    auto block = reinterpret_cast<LargeBlock*>(static_cast<char*>(ptr) - kLargeHeaderSize);
+    unlink(block);
+    auto newBlock = static_cast<LargeBlock*>(std::realloc(block, kLargeHeaderSize + newSize));
+    if (!newBlock) {
+      link(block);
+      return nullptr;
+    }
+    link(newBlock);
+    statistics_.allocated = statistics_.allocated - oldSize + newSize;
+    statistics_.reserved = statistics_.reserved - oldSize + newSize;
+    return reinterpret_cast<char*>(newBlock) + kLargeHeaderSize;
+  }
+
+  auto newPtr = allocate(newSize);
+  if (!newPtr) {
+    return nullptr;
+  }
+  std::memcpy(newPtr, ptr, std::min(oldSize, newSize));
+  deallocate(ptr, oldSize);
+  return newPtr;
+}
+
+void ArenaAllocator::deallocate(void* ptr, size_t size) {
+  statistics_.allocated -= size;
+  statistics_.blocks--;
+  if (size > kMaxSmallSize) {
+    deallocateLarge(ptr, size);
+    return;
+  }
+  auto sizeClass = classOf(size);
+  auto block = static_cast<FreeBlock*>(ptr);
+  block->next = freeLists_[sizeClass];
+  freeLists_[sizeClass] = block;
+}
+
+ArenaAllocator::Statistics ArenaAllocator::getStatistics() const { return statistics_; }
+
+void* ArenaAllocator::allocateSmall(size_t sizeClass) {
+  auto& freeList = freeLists_[sizeClass];
+  if (freeList) {
+    auto block = freeList;
+    freeList = block->next;
+    return block;
+  }
+
+  auto blockSize = (sizeClass + 1) * kGranularity;
+  if (static_cast<size_t>(chunkEnd_ - cursor_) < blockSize) {
+    // the tail of the old chunk is wasted, it is smaller than kMaxSmallSize
+    auto chunk = static_cast<char*>(std::malloc(chunkSize_));
+    if (!chunk) {
+      return nullptr;
+    }
+    chunks_.push_back(chunk);
+    statistics_.reserved += chunkSize_;
+    cursor_ = chunk;
+    chunkEnd_ = chunk + chunkSize_;
+  }
+  auto block = cursor_;
+  cursor_ += blockSize;
+  return block;
+}
+
+void* ArenaAllocator::allocateLarge(size_t size) {
+  auto block = static_cast<LargeBlock*>(std::malloc(kLargeHeaderSize + size));
+  if (!block) {
+    return nullptr;
+  }
+  link(block);
+  statistics_.reserved += size;
+  return reinterpret_cast<char*>(block) + kLargeHeaderSize;
+}
+
+void ArenaAllocator::deallocateLarge(void* ptr, size_t size) {
+  auto block = reinterpret_cast<LargeBlock*>(static_cast<char*>(ptr) - kLargeHeaderSize);
+  unlink(block);
+  std::free(block);
+  statistics_.reserved -= size;
+}
+
+void ArenaAllocator::link(LargeBlock* block) {
+  block->prev = nullptr;
+  block->next = largeBlocks_;
+  if (largeBlocks_) {
+    largeBlocks_->prev = block;
+  }
+  largeBlocks_ = block;
+}
+
+void ArenaAllocator::unlink(LargeBlock* block) {
+  if (block->prev) {
+    block->prev->next = block->next;
+  } else {
+    largeBlocks_ = block->next;
+  }
+  if (block->next) {
+    block->next->prev = block->prev;
+  }
+}
+
+}  // namespace script::utils
@@ -0,0 +1,152 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "../foundation.h"
+
+namespace script::utils {
+
+/**
+ * Memory allocator of the script heap, passed to an engine on construction.
+ * (QuickJs runtime via JS_NewRuntime2, Lua state via lua_newstate)
+ *
+ * The caller always passes the size of the block back, so implementations don't need
+ * to store it. An allocator is used by one engine, on the engine thread, it needn't be
+ * thread-safe.
+ */
+class Allocator {
+ public:
+  Allocator() = default;
+
+  virtual ~Allocator() = default;
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(Allocator);
+
+  /**
+   * @param size may be 0, the result is still a distinct block to deallocate with size 0
+   * @return memory aligned for any type (std::max_align_t), nullptr on failure
+   */
+  virtual void* allocate(size_t size) = 0;
+
+  /**
+   * like realloc, the content is kept up to the smaller size.
+   * @param ptr not null
+   * @param newSize not 0
+   * @return nullptr on failure, and ptr is still valid
+   */
+  virtual void* reallocate(void* ptr, size_t oldSize, size_t newSize) = 0;
+
+  /**
+   * @param ptr not null
+   */
+  virtual void deallocate(void* ptr, size_t size) = 0;
+};
+
+/**
+ * malloc/realloc/free
+ */
+class SystemAllocator : public Allocator {
+ public:
+  void* allocate(size_t size) override;
+
+  void* reallocate(void* ptr, size_t oldSize, size_t newSize) override;
+
+  void deallocate(void* ptr, size_t size) override;
+};
+
+/**
+ * Per engine allocator, keeps engines from fragmenting the process heap together.
+ *
+ * Small blocks are carved from big chunks and recycled by size class in free lists,
+ * without going to malloc. Large blocks go to malloc, but are still tracked.
+ * Everything is released at once when the allocator is destroyed (usually with the engine),
+ * even if the engine leaks.
+ */
+class ArenaAllocator : public Allocator {
+ public:
+  struct Statistics {
+    /** bytes in use, as requested by the engine */
+    size_t allocated = 0;
+    /** bytes taken from the system, chunks and large blocks */
+    size_t reserved = 0;
+    /** blocks in use */
+    size_t blocks = 0;
+  };
+
+  /**
+   * blocks larger than this go to malloc.
+   */
+  static constexpr size_t kMaxSmallSize = 512;
+
+  /**
+   * @param chunkSize size of the chunks small blocks are carved from
+   */
+  explicit ArenaAllocator(size_t chunkSize = 64 * 1024);
+
+  ~ArenaAllocator() override;
+
+  void* allocate(size_t size) override;
+
+  void* reallocate(void* ptr, size_t oldSize, size_t newSize) override;
+
+  void deallocate(void* ptr, size_t size) override;
+
+  Statistics getStatistics() const;
+
+ private:
+  static constexpr size_t kGranularity = alignof(std::max_align_t);
+  static constexpr size_t kClassCount = kMaxSmallSize / kGranularity;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct LargeBlock {
+    LargeBlock* prev;
+    LargeBlock* next;
+  };
+
+  static constexpr size_t kLargeHeaderSize =
+      (sizeof(LargeBlock) + kGranularity - 1) / kGranularity * kGranularity;
+
+  // 0 shares the smallest class
+  static size_t classOf(size_t size) { return size == 0 ? 0 : (size - 1) / kGranularity; }
+
+  void* allocateSmall(size_t sizeClass);
+
+  void* allocateLarge(size_t size);
+
+  void deallocateLarge(void* ptr, size_t size);
+
+  void link(LargeBlock* block);
+
+  void unlink(LargeBlock* block);
+
+  size_t chunkSize_;
+  std::vector<void*> chunks_;
+  char* cursor_ = nullptr;
+  char* chunkEnd_ = nullptr;
+  std::array<FreeBlock*, kClassCount> freeLists_{};
+  LargeBlock* largeBlocks_ = nullptr;
+  Statistics statistics_{};
+};
+
+}  // namespace script::utils
@@ -0,0 +1,201 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CodeCache.h"
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace script::utils {
+
+CodeCache::Statistics CodeCache::getStatistics() const {
+  Statistics stat;
+  stat.hit = hit_.load(std::memory_order_relaxed);
+  stat.miss = miss_.load(std::memory_order_relaxed);
+  stat.rejected = rejected_.load(std::memory_order_relaxed);
+  stat.produced = produced_.load(std::memory_order_relaxed);
+  return stat;
+}
+
+void CodeCache::resetStatistics() {
+  hit_.store(0, std::memory_order_relaxed);
+  miss_.store(0, std::memory_order_relaxed);
+  rejected_.store(0, std::memory_order_relaxed);
+  produced_.store(0, std::memory_order_relaxed);
+}
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+  // splitmix64 finalizer
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+void appendHex(std::string& out, uint64_t value) {
+  constexpr char kHex[] = "0123456789abcdef";
+  for (int shift = 60; shift >= 0; shift -= 4) {
+    out.push_back(kHex[(value >> shift) & 0xF]);
+  }
+}
+
+}  // namespace
+
+std::string CodeCache::hashKey(std::string_view source, std::string_view salt) {
+  // two independent 64-bit hashes, FNV-1a and a polynomial one.
+  // not cryptographic, but good enough to tell scripts apart.
+  uint64_t fnv = 0xcbf29ce484222325ULL;
+  uint64_t poly = 0x9e3779b97f4a7c15ULL;
+  auto feed = [&](std::string_view data) {
+    for (auto c : data) {
+      auto b = static_cast<uint8_t>(c);
+      fnv = (fnv ^ b) * 0x100000001b3ULL;
+      poly = poly * 0x5bd1e9955bd1e995ULL + b + 1;
+    }
+  };
+  feed(salt);
+  // separate salt from source, so that ("ab", "c") != ("a", "bc")
+  poly = mix64(poly ^ salt.size());
+  feed(source);
+
+  std::string key;
+  key.reserve(48);
+  appendHex(key, mix64(fnv));
+  appendHex(key, mix64(poly));
+  key.push_back('-');
+  key.append(std::to_string(source.size()));
+  return key;
+}
+
+bool MemoryCodeCache::load(const std::string& key, std::string& data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = cache_.find(key);
+  if (it == cache_.end()) {
+    return false;
+  }
+  data = it->second;
+  return true;
+}
+
+void MemoryCodeCache::store(const std::string& key, std::string_view data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_[key] = std::string(data);
+}
+
+void MemoryCodeCache::remove(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_.erase(key);
+}
+
+size_t MemoryCodeCache::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cache_.size();
+}
+
+void MemoryCodeCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_.clear();
+}
+
+DirectoryCodeCache::DirectoryCodeCache(std::string directory) : directory_(std::move(directory)) {
+  if (!directory_.empty() && directory_.back() != '/' && directory_.back() != '\\') {
+    directory_.push_back('/');
+  }
+}
+
+std::string DirectoryCodeCache::pathOf(const std::string& key) const {
+  return directory_ + key + ".cache";
+}
+
+bool DirectoryCodeCache::load(const std::string& key, std::string& data) {
+  auto file = std::fopen(pathOf(key).c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  bool success = false;
+  if (std::fseek(file, 0, SEEK_END) == 0) {
+    auto size = std::ftell(file);
+    if (size >= 0 && std::fseek(file, 0, SEEK_SET) == 0) {
+      data.resize(static_cast<size_t>(size));
+      success = std::fread(data.data(), 1, data.size(), file) == data.size();
+    }
+  }
+  std::fclose(file);
+  return success;
+}
+
+void DirectoryCodeCache::store(const std::string& key, std::string_view data) {
+  static std::atomic<uint32_t> serial{0};
+
+  auto path = pathOf(key);
+  // write to an unique temp file, then rename to the final name,
+  // readers never see a partially written file.
+  auto threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+  auto tmpPath = path + "." + std::to_string(threadId) + "." +
+                 std::to_string(serial.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+
+  auto file = std::fopen(tmpPath.c_str(), "wb");
+  if (!file) {
+    return;
+  }
+  bool success = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+  success = std::fclose(file) == 0 && success;
+
+  if (success && std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    // rename can't replace an existing file on Windows
+    std::remove(path.c_str());
+    success = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+  }
+  if (!success) {
+    std::remove(tmpPath.c_str());
+  }
+}
+
+void DirectoryCodeCache::remove(const std::string& key) { std::remove(pathOf(key).c_str()); }
+
+TieredCodeCache::TieredCodeCache(std::shared_ptr<CodeCache> first,
+                                 std::shared_ptr<CodeCache> second)
+    : first_(std::move(first)), second_(std::move(second)) {}
+
+bool TieredCodeCache::load(const std::string& key, std::string& data) {
+  if (first_->load(key, data)) {
+    return true;
+  }
+  if (second_->load(key, data)) {
+    first_->store(key, data);
+    return true;
+  }
+  return false;
+}
+
+void TieredCodeCache::store(const std::string& key, std::string_view data) {
+  first_->store(key, data);
+  second_->store(key, data);
+}
+
+void TieredCodeCache::remove(const std::string& key) {
+  first_->remove(key);
+  second_->remove(key);
+}
+
+}  // namespace script::utils
@@ -0,0 +1,167 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "../foundation.h"
+
+namespace script::utils {
+
+/**
+ * A key-value store for compiled script code (V8 code cache, QuickJs bytecode, Lua binary chunk).
+ * The key is a content hash of the source, see CodeCache::hashKey.
+ *
+ * A CodeCache can be shared by many engines, even on different threads,
+ * so implementations must be thread-safe.
+ */
+class CodeCache {
+ public:
+  struct Statistics {
+    /** cached code found and accepted by the engine */
+    size_t hit = 0;
+    /** no cached code found */
+    size_t miss = 0;
+    /** cached code found, but rejected by the engine (version mismatch, corrupted data, etc.) */
+    size_t rejected = 0;
+    /** newly produced code written back to the cache */
+    size_t produced = 0;
+  };
+
+ private:
+  std::atomic<size_t> hit_{0};
+  std::atomic<size_t> miss_{0};
+  std::atomic<size_t> rejected_{0};
+  std::atomic<size_t> produced_{0};
+
+ public:
+  CodeCache() = default;
+
+  virtual ~CodeCache() = default;
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(CodeCache);
+
+  /**
+   * @param key cache key
+   * @param data [out] the cached code
+   * @return true if found
+   */
+  virtual bool load(const std::string& key, std::string& data) = 0;
+
+  virtual void store(const std::string& key, std::string_view data) = 0;
+
+  /**
+   * called when a cached code is rejected by the engine.
+   */
+  virtual void remove(const std::string& key) = 0;
+
+  Statistics getStatistics() const;
+
+  void resetStatistics();
+
+  /**
+   * compute the cache key of given source.
+   *
+   * @param source the script source (or anything the compiled code depends on)
+   * @param salt extra data mixed into the key, usually engine name & version,
+   * so that code produced by different engine version won't collide.
+   * @return a file-name-safe hex string
+   */
+  static std::string hashKey(std::string_view source, std::string_view salt = {});
+
+  // the following are used by engine implementations
+
+  void recordHit() { hit_.fetch_add(1, std::memory_order_relaxed); }
+
+  void recordMiss() { miss_.fetch_add(1, std::memory_order_relaxed); }
+
+  void recordRejected() { rejected_.fetch_add(1, std::memory_order_relaxed); }
+
+  void recordProduced() { produced_.fetch_add(1, std::memory_order_relaxed); }
+};
+
+/**
+ * An in-memory CodeCache.
+ */
+class MemoryCodeCache : public CodeCache {
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::string> cache_;
+
+ public:
+  bool load(const std::string& key, std::string& data) override;
+
+  void store(const std::string& key, std::string_view data) override;
+
+  void remove(const std::string& key) override;
+
+  size_t size();
+
+  void clear();
+};
+
+/**
+ * A CodeCache stored on disk, one file per key.
+ * Files are written to a temporary file first and then renamed,
+ * so it is safe to share one directory with multiple processes.
+ */
+class DirectoryCodeCache : public CodeCache {
+  std::string directory_;
+
+ public:
+  /**
+   * @param directory the directory to store cache files, must exist.
+   */
+  explicit DirectoryCodeCache(std::string directory);
+
+  const std::string& directory() const { return directory_; }
+
+  bool load(const std::string& key, std::string& data) override;
+
+  void store(const std::string& key, std::string_view data) override;
+
+  void remove(const std::string& key) override;
+
+ private:
+  std::string pathOf(const std::string& key) const;
+};
+
+/**
+ * A two-level CodeCache, eg: MemoryCodeCache in front of a DirectoryCodeCache.
+ * load looks up the first level then the second level, and promotes hits to the first level.
+ * store and remove apply to both levels.
+ */
+class TieredCodeCache : public CodeCache {
+  std::shared_ptr<CodeCache> first_;
+  std::shared_ptr<CodeCache> second_;
+
+ public:
+  TieredCodeCache(std::shared_ptr<CodeCache> first, std::shared_ptr<CodeCache> second);
+
+  bool load(const std::string& key, std::string& data) override;
+
+  void store(const std::string& key, std::string_view data) override;
+
+  void remove(const std::string& key) override;
+};
+
+}  // namespace script::utils
@@ -0,0 +1,198 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EngineGroup.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include "../Exception.h"
+#include "../Scope.h"
+
+namespace script::utils {
+
+EngineGroup::EngineGroup(size_t size, const EngineFactory& factory) {
+  if (size == 0) {
+    throw Exception("EngineGroup needs at least one engine");
+  }
+  shards_.reserve(size);
+  try {
+    for (size_t i = 0; i < size; ++i) {
+      auto shard = std::make_unique<Shard>();
+      shard->engine = factory();
+      shard->looper = std::make_unique<ThreadPool>(1, shard->engine->messageQueue());
+      shards_.push_back(std::move(shard));
+    }
+  } catch (...) {
+    release();
+    throw;
+  }
+}
+
+EngineGroup::~EngineGroup() { release(); }
+
+void EngineGroup::release() {
+  for (auto& shard : shards_) {
+    {
+      std::unique_lock<std::mutex> lock(shard->mutex);
+      shard->drained.wait(lock, [&shard]() { return shard->pending.load() == 0; });
+    }
+    // shutdown(true) would also wait for whatever the engine keeps posting to itself
+    shard->looper->shutdownNow(true);
+    shard->looper.reset();
+    shard->engine->destroy();
+  }
+  shards_.clear();
+}
+
+size_t EngineGroup::dispatch(Task task) {
+  // start from a rotating index, so that engines with the same depth are used in turn.
+  auto size = shards_.size();
+  auto start = nextShard_.fetch_add(1, std::memory_order_relaxed);
+  size_t best = start % size;
+  size_t bestDepth = shards_[best]->pending.load(std::memory_order_relaxed);
+  for (size_t i = 1; i < size && bestDepth > 0; ++i) {
+    auto index = (start + i) % size;
+    auto depth = shards_[index]->pending.load(std::memory_order_relaxed);
+    if (depth < bestDepth) {
+      best = index;
+      bestDepth = depth;
+    }
+  }
+  post(*shards_[best], std::move(task));
+  return best;
+}
+
+size_t EngineGroup::dispatch(size_t affinityKey, Task task) {
+  auto index = affinityKey % shards_.size();
+  post(*shards_[index], std::move(task));
+  return index;
+}
+
+void EngineGroup::dispatchTo(size_t index, Task task) { post(*shards_.at(index), std::move(task)); }
+
+void EngineGroup::post(Shard& shard, Task task) {
+  struct TaskData {
+    EngineGroup* group;
+    Shard* shard;
+    Task task;
+  };
+
+  shard.pending.fetch_add(1, std::memory_order_relaxed);
+  auto msg = shard.looper->obtainInplaceMessage([](InplaceMessage& msg) {
+    auto& data = msg.getObject<TaskData>();
+    auto engine = data.shard->engine;
+    {
+      EngineScope scope(engine);
+      try {
+        data.task(engine);
+      } catch (const Exception& e) {
+        data.group->handleError(engine, e);
+      } catch (const std::exception& e) {
+        data.group->handleError(engine, Exception(e.what()));
+      } catch (...) {
+        data.group->handleError(engine, Exception("unknown exception"));
+      }
+    }
+    data.shard->processed.fetch_add(1, std::memory_order_relaxed);
+    if (data.shard->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lock(data.shard->mutex);
+      data.shard->drained.notify_all();
+    }
+  });
+  msg->inplaceObject<TaskData>(TaskData{this, &shard, std::move(task)});
+  shard.looper->postMessage(msg);
+}
+
+void EngineGroup::broadcast(const Task& task) {
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t remaining = shards_.size();
+  bool failed = false;
+  std::string error;
+
+  for (auto& shard : shards_) {
+    post(*shard, [&](ScriptEngine* engine) {
+      bool success = false;
+      std::string message;
+      try {
+        task(engine);
+        success = true;
+      } catch (const Exception& e) {
+        // Exception may hold engine references, only pass the message across threads.
+        message = e.message();
+      } catch (const std::exception& e) {
+        message = e.what();
+      } catch (...) {
+        message = "unknown exception";
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!success && !failed) {
+        failed = true;
+        error = std::move(message);
+      }
+      if (--remaining == 0) {
+        finished.notify_all();
+      }
+    });
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [&remaining]() { return remaining == 0; });
+  if (failed) {
+    throw Exception(error);
+  }
+}
+
+void EngineGroup::setOnError(ErrorCallback callback) {
+  std::lock_guard<std::mutex> lock(errorMutex_);
+  onError_ = std::move(callback);
+}
+
+void EngineGroup::handleError(ScriptEngine* engine, const Exception& error) {
+  ErrorCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    callback = onError_;
+  }
+  if (!callback) {
+    return;
+  }
+  try {
+    callback(engine, error);
+  } catch (...) {
+    // nowhere left to report, don't throw into the engine's message loop
+  }
+}
+
+EngineGroup::EngineStatistics EngineGroup::getStatistics(size_t index) const {
+  auto& shard = *shards_.at(index);
+  EngineStatistics stat;
+  stat.queueDepth = shard.pending.load(std::memory_order_relaxed);
+  stat.processed = shard.processed.load(std::memory_order_relaxed);
+  return stat;
+}
+
+std::vector<EngineGroup::EngineStatistics> EngineGroup::getStatistics() const {
+  std::vector<EngineStatistics> stats;
+  stats.reserve(shards_.size());
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    stats.push_back(getStatistics(i));
+  }
+  return stats;
+}
+
+}  // namespace script::utils
@@ -0,0 +1,154 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../Engine.h"
+#include "../Exception.h"
+#include "ThreadPool.h"
+
+namespace script::utils {
+
+/**
+ * A group of identical ScriptEngines, each runs on its own thread.
+ *
+ * Each engine's messageQueue() is looped by a dedicated ThreadPool worker, so tasks dispatched
+ * to an engine, and messages the engine posts to itself (eg: promise jobs), run on that thread.
+ *
+ * \code
+ * EngineGroup group(std::thread::hardware_concurrency(),
+ *                   [] { return new ScriptEngineImpl(); });
+ *
+ * group.broadcast([](ScriptEngine* engine) {
+ *   engine->registerNativeClass(FooDefine);
+ *   engine->eval(bootstrap);
+ * });
+ *
+ * group.dispatch([](ScriptEngine* engine) { engine->eval(job); });            // least-loaded
+ * group.dispatch(userId, [](ScriptEngine* engine) { engine->eval(job); });    // affinity
+ * \endcode
+ *
+ * Tasks are called with EngineScope entered. Exceptions thrown by dispatched tasks go to
+ * setOnError, and are dropped if it's not set (or if the error handler throws itself).
+ */
+class EngineGroup {
+ public:
+  /**
+   * create a new engine, called on the constructing thread, without EngineScope.
+   * the engine MUST use its own messageQueue (don't share it with other engines).
+   */
+  using EngineFactory = std::function<ScriptEngine*()>;
+
+  using Task = std::function<void(ScriptEngine*)>;
+
+  /**
+   * called on the thread of the engine the task ran on, with its EngineScope entered.
+   * exceptions other than Exception are passed as an Exception with the same message.
+   */
+  using ErrorCallback = std::function<void(ScriptEngine* engine, const Exception& error)>;
+
+  struct EngineStatistics {
+    /** tasks dispatched but not finished yet */
+    size_t queueDepth = 0;
+    /** tasks finished */
+    size_t processed = 0;
+  };
+
+ private:
+  struct Shard {
+    ScriptEngine* engine = nullptr;
+    std::unique_ptr<ThreadPool> looper;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> processed{0};
+    // notified when pending drops to 0
+    std::mutex mutex;
+    std::condition_variable drained;
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> nextShard_{0};
+  std::mutex errorMutex_;
+  ErrorCallback onError_;
+
+ public:
+  /**
+   * @param size number of engines (and threads)
+   * @param factory creates the engines
+   */
+  EngineGroup(size_t size, const EngineFactory& factory);
+
+  /**
+   * wait for all dispatched tasks to finish, stop the threads, and destroy the engines.
+   * messages the engines posted to themselves (timers, promise jobs...) and not due by then are
+   * dropped, so an engine which keeps posting to itself doesn't keep its thread forever.
+   */
+  ~EngineGroup();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(EngineGroup);
+
+  size_t size() const { return shards_.size(); }
+
+  /**
+   * run the task on the engine with least queue depth.
+   * @return the index of the engine
+   */
+  size_t dispatch(Task task);
+
+  /**
+   * run the task on the engine selected by key, same key always goes to the same engine.
+   * @return the index of the engine
+   */
+  size_t dispatch(size_t affinityKey, Task task);
+
+  /**
+   * run the task on the engine at index.
+   */
+  void dispatchTo(size_t index, Task task);
+
+  /**
+   * run the task on every engine, and wait for all of them to finish.
+   * Never call it from inside a task, it deadlocks.
+   *
+   * @throw Exception if the task throws on any engine
+   */
+  void broadcast(const Task& task);
+
+  /**
+   * receive exceptions thrown by dispatched tasks, thread-safe.
+   */
+  void setOnError(ErrorCallback callback);
+
+  EngineStatistics getStatistics(size_t index) const;
+
+  std::vector<EngineStatistics> getStatistics() const;
+
+ private:
+  void post(Shard& shard, Task task);
+
+  void handleError(ScriptEngine* engine, const Exception& error);
+
+  void release();
+};
+
+}  // namespace script::utils
@@ -0,0 +1,220 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EnginePool.h"
+#include <ScriptX/ScriptX.h>
+#include <algorithm>
+#include <memory>
+
+namespace script::utils {
+
+EnginePool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), engine_(other.engine_), discard_(other.discard_) {
+  other.pool_ = nullptr;
+  other.engine_ = nullptr;
+}
+
+EnginePool::Lease& EnginePool::Lease::operator=(Lease&& other) noexcept {
+  if (this != &other) {
+    reset();
+    pool_ = other.pool_;
+    engine_ = other.engine_;
+    discard_ = other.discard_;
+    other.pool_ = nullptr;
+    other.engine_ = nullptr;
+  }
+  return *this;
+}
+
+EnginePool::Lease::~Lease() { reset(); }
+
+void EnginePool::Lease::reset() {
+  if (engine_) {
+    pool_->giveBack(engine_, discard_);
+    engine_ = nullptr;
+    pool_ = nullptr;
+    discard_ = false;
+  }
+}
+
+EnginePool::EnginePool(size_t size, EngineFactory factory, EngineReset reset)
+    : size_(size), factory_(std::move(factory)), reset_(std::move(reset)) {
+  idle_.reserve(size_);
+  try {
+    for (size_t i = 0; i < size_; ++i) {
+      idle_.push_back(factory_());
+    }
+  } catch (...) {
+    // the destructor doesn't run for a throwing constructor
+    for (auto engine : idle_) {
+      engine->destroy();
+    }
+    throw;
+  }
+}
+
+namespace {
+
+Local<Object> globalObject(ScriptEngine* engine) {
+  if (engine->getLanguageType() == ScriptLanguage::kLua) {
+    return engine->eval("return _G").asObject();
+  }
+  return engine->eval("globalThis").asObject();
+}
+
+}  // namespace
+
+EnginePool::ResettingFactory EnginePool::resetGlobals(EngineFactory factory) {
+  struct Baseline {
+    std::mutex mutex;
+    std::unordered_set<std::string> names;
+  };
+  auto baseline = std::make_shared<Baseline>();
+
+  ResettingFactory ret;
+  ret.factory = [baseline, factory = std::move(factory)]() {
+    auto engine = factory();
+    EngineScope scope(engine);
+    auto names = globalObject(engine).getKeyNames();
+
+    std::lock_guard<std::mutex> lock(baseline->mutex);
+    baseline->names.insert(names.begin(), names.end());
+    return engine;
+  };
+  ret.reset = [baseline](ScriptEngine* engine) {
+    EngineScope scope(engine);
+    auto global = globalObject(engine);
+    for (auto& key : global.getKeys()) {
+      {
+        std::lock_guard<std::mutex> lock(baseline->mutex);
+        if (baseline->names.count(key.toString()) != 0) {
+          continue;
+        }
+      }
+      global.remove(key);
+      if (global.has(key)) {
+        // not configurable, eg: declared by var
+        global.set(key, Local<Value>());
+      }
+    }
+    return true;
+  };
+  return ret;
+}
+
+EnginePool::~EnginePool() {
+  for (auto engine : idle_) {
+    engine->destroy();
+  }
+  idle_.clear();
+}
+
+EnginePool::Lease EnginePool::lease() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics_.leased++;
+    if (!idle_.empty()) {
+      statistics_.hit++;
+      auto engine = idle_.back();
+      idle_.pop_back();
+      return Lease(this, engine);
+    }
+    statistics_.miss++;
+  }
+  // create outside the lock, it can be slow
+  return Lease(this, factory_());
+}
+
+void EnginePool::giveBack(ScriptEngine* engine, bool discard) noexcept {
+  bool full;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    full = idle_.size() >= size_;
+  }
+  if (full) {
+    // no room for it, don't waste a reset or a new engine on it
+    engine->destroy();
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  bool reused = false;
+  if (!discard && reset_) {
+    try {
+      reused = reset_(engine);
+    } catch (...) {
+      reused = false;
+    }
+  }
+
+  // other leases may have filled the pool during reset
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    full = idle_.size() >= size_;
+  }
+
+  if (!reused || full) {
+    engine->destroy();
+    engine = nullptr;
+  }
+  bool recreated = false;
+  if (!reused && !full) {
+    try {
+      engine = factory_();
+      recreated = true;
+    } catch (...) {
+      // keep the pool smaller, lease() creates engines on demand.
+    }
+  }
+
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reused) statistics_.reset++;
+    if (recreated) statistics_.recreated++;
+    statistics_.totalResetTime += elapsed;
+    statistics_.maxResetTime =
+        std::max<std::chrono::nanoseconds>(statistics_.maxResetTime, elapsed);
+
+    if (engine && idle_.size() < size_) {
+      idle_.push_back(engine);
+      engine = nullptr;
+    }
+  }
+  if (engine) {
+    // the pool got full during reset
+    engine->destroy();
+  }
+}
+
+size_t EnginePool::idleCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return idle_.size();
+}
+
+EnginePool::Statistics EnginePool::getStatistics() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return statistics_;
+}
+
+void EnginePool::resetStatistics() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  statistics_ = {};
+}
+
+}  // namespace script::utils
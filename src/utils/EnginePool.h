@@ -0,0 +1,197 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "../Engine.h"
+
+namespace script::utils {
+
+/**
+ * A pool of pre-warmed ScriptEngines.
+ *
+ * Engines are created by the factory (which usually registers native classes and evaluates
+ * bootstrap scripts), leased to callers, and reset to a clean state when returned.
+ *
+ * \code
+ * EnginePool pool(4, [] {
+ *   auto engine = new ScriptEngineImpl();
+ *   EngineScope scope(engine);
+ *   engine->registerNativeClass(FooDefine);
+ *   engine->eval(bootstrap);
+ *   return engine;
+ * });
+ *
+ * {
+ *   auto lease = pool.lease();
+ *   EngineScope scope(lease.get());
+ *   lease->eval(request);
+ * } // returned to pool
+ * \endcode
+ *
+ * EnginePool is thread-safe, an engine can be leased on one thread and used on another,
+ * as long as it is used by only one thread at a time.
+ */
+class EnginePool {
+ public:
+  /**
+   * create a new engine, ready to use. called without EngineScope.
+   */
+  using EngineFactory = std::function<ScriptEngine*()>;
+
+  /**
+   * reset a returned engine to clean state, called without EngineScope.
+   * @return false if the engine can't be reset, then it is destroyed and replaced by a new one.
+   */
+  using EngineReset = std::function<bool(ScriptEngine*)>;
+
+  struct Statistics {
+    /** total leases */
+    size_t leased = 0;
+    /** leases served by an idle engine */
+    size_t hit = 0;
+    /** leases that have to create a new engine */
+    size_t miss = 0;
+    /** engines reset by EngineReset */
+    size_t reset = 0;
+    /** engines destroyed and created again, because there is no EngineReset, reset failed, or
+     * the lease is discarded */
+    size_t recreated = 0;
+    /** total and max time spent on returning engines (reset or recreate) */
+    std::chrono::nanoseconds totalResetTime{0};
+    std::chrono::nanoseconds maxResetTime{0};
+
+    double hitRate() const { return leased == 0 ? 0 : static_cast<double>(hit) / leased; }
+  };
+
+  /**
+   * A leased engine, returned to the pool on destruction. Move-only.
+   */
+  class Lease {
+    EnginePool* pool_ = nullptr;
+    ScriptEngine* engine_ = nullptr;
+    bool discard_ = false;
+
+    Lease(EnginePool* pool, ScriptEngine* engine) : pool_(pool), engine_(engine) {}
+
+    friend class EnginePool;
+
+   public:
+    Lease() = default;
+
+    Lease(Lease&& other) noexcept;
+
+    Lease& operator=(Lease&& other) noexcept;
+
+    ~Lease();
+
+    ScriptEngine* get() const { return engine_; }
+
+    template <typename T>
+    T* getAs() const {
+      return static_cast<T*>(engine_);
+    }
+
+    ScriptEngine* operator->() const { return engine_; }
+
+    explicit operator bool() const { return engine_ != nullptr; }
+
+    /**
+     * don't reuse the engine (eg: it is in a bad state), it is destroyed on return.
+     */
+    void discard() { discard_ = true; }
+
+    /**
+     * return the engine to the pool now.
+     */
+    void reset();
+  };
+
+ private:
+  const size_t size_;
+  EngineFactory factory_;
+  EngineReset reset_;
+
+  std::mutex mutex_;
+  std::vector<ScriptEngine*> idle_;
+  Statistics statistics_;
+
+ public:
+  /**
+   * @param size number of engines to keep, they are created in the constructor.
+   * @param factory creates engines
+   * @param reset resets returned engines. If not provided, every returned engine is destroyed
+   * and created again by the factory. That is the full startup cost on every return, it's only
+   * cheap with a fast factory (eg: V8Engine from a startup snapshot). On QuickJs and Lua, use
+   * resetGlobals or your own EngineReset.
+   */
+  EnginePool(size_t size, EngineFactory factory, EngineReset reset = {});
+
+  struct ResettingFactory {
+    EngineFactory factory;
+    EngineReset reset;
+  };
+
+  /**
+   * Wrap factory to record the global variables of the engines it creates, and make an
+   * EngineReset deleting the globals added after that. It's much cheaper than creating a new
+   * engine.
+   *
+   * \code
+   * auto globals = EnginePool::resetGlobals(createEngine);
+   * EnginePool pool(4, globals.factory, globals.reset);
+   * \endcode
+   *
+   * Only the names are recorded, globals created by the factory and overwritten by script are
+   * not restored. In JavaScript, top level let/const/class are not properties of the global
+   * object and can't be deleted. Use Lease::discard or a full EngineReset for such scripts.
+   */
+  static ResettingFactory resetGlobals(EngineFactory factory);
+
+  /**
+   * destroy all idle engines, all leases must be returned before.
+   */
+  ~EnginePool();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(EnginePool);
+
+  /**
+   * lease an idle engine, if there is none, create a new one.
+   * engines created for the lease is kept in pool on return only if the pool is not full.
+   */
+  Lease lease();
+
+  size_t size() const { return size_; }
+
+  size_t idleCount();
+
+  Statistics getStatistics();
+
+  void resetStatistics();
+
+ private:
+  void giveBack(ScriptEngine* engine, bool discard) noexcept;
+};
+
+}  // namespace script::utils
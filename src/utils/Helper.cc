@@ -17,8 +17,17 @@
 
 #include <ScriptX/ScriptX.h>
 
+#include <cstdint>
+#include <cstring>
 #include <utility>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCRIPTX_HAS_SSE2
+#endif
+
 namespace script::internal {
 
 Local<Value> getNamespaceObject(ScriptEngine* engine, const std::string_view& nameSpace,
@@ -56,4 +65,40 @@ Local<Value> getNamespaceObject(ScriptEngine* engine, const std::string_view& na
   return nameSpaceObj;
 }
 
-}  // namespace script::internal
\ No newline at end of file
+bool isAscii(const char* data, size_t length) {
+  size_t i = 0;
+  // short strings, not worth setting up wide loads
+  if (length < 16) {
+    for (; i < length; ++i) {
+      if (static_cast<unsigned char>(data[i]) >= 0x80) return false;
+    }
+    return true;
+  }
+
+#if defined(__AVX2__)
+  for (; i + 32 <= length; i += 32) {
+    auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    if (_mm256_movemask_epi8(chunk) != 0) return false;
+  }
+#endif
+
+#if defined(__AVX2__) || defined(SCRIPTX_HAS_SSE2)
+  for (; i + 16 <= length; i += 16) {
+    auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    if (_mm_movemask_epi8(chunk) != 0) return false;
+  }
+#endif
+
+  // scalar fallback, 8 bytes at a time
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    if (word & 0x8080808080808080ULL) return false;
+  }
+  for (; i < length; ++i) {
+    if (static_cast<unsigned char>(data[i]) >= 0x80) return false;
+  }
+  return true;
+}
+
+}  // namespace script::internal
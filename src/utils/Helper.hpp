@@ -16,6 +16,7 @@
  */
 
 #pragma once
+#include <string_view>
 #include <utility>
 #include <vector>
 #include "../Reference.h"
@@ -55,4 +56,12 @@ void withNArray(size_t N, FN&& fn) {
 
 Local<Value> getNamespaceObject(ScriptEngine* engine, const std::string_view& nameSpace,
                                 Local<Value> rootNs = {});
-}  // namespace script::internal
\ No newline at end of file
+
+/**
+ * @return true if all bytes are 7-bit ASCII, such string can be used as latin1 or utf8 as is.
+ * vectorized with SSE2/AVX2 when available at compile time.
+ */
+bool isAscii(const char* data, size_t length);
+
+inline bool isAscii(std::string_view str) { return isAscii(str.data(), str.length()); }
+}  // namespace script::internal
@@ -40,7 +40,7 @@ class LoopQueueGuard {
   SCRIPTX_DISALLOW_COPY_AND_MOVE(LoopQueueGuard);
 
   ~LoopQueueGuard() {
-    auto q = getRunningQueue();
+    auto& q = getRunningQueue();
     if (--q[queue_] == 0) {
       q.erase(queue_);
     }
@@ -53,9 +53,18 @@ class LoopQueueGuard {
    * @return if current method call is already inside a loopQueue() stack hierarchy.
    */
   static bool isCallerNestedInsideLoop(MessageQueue* queue) {
-    auto q = getRunningQueue();
+    auto& q = getRunningQueue();
     return q.find(queue) != q.end();
   }
+
+  /**
+   * @return if current method call is the outermost loopQueue() of the queue.
+   */
+  static bool isOutermostLoop(MessageQueue* queue) {
+    auto& q = getRunningQueue();
+    auto it = q.find(queue);
+    return it != q.end() && it->second == 1;
+  }
 };
 
 Message::Message() : handlerProc(nullptr), cleanupProc(nullptr) {}
@@ -137,14 +146,74 @@ void MessageQueue::setSupervisor(const std::shared_ptr<MessageQueue::Supervisor>
   supervisor_ = supervisor;
 }
 
+void MessageQueue::addIdleHandler(IdleHandler* handler, std::chrono::nanoseconds idleDelay) {
+  std::lock_guard<std::mutex> lk(queueMutex_);
+  idleHandlers_.push_back({handler, idleDelay, false});
+  // let the loop recalculate how long to wait
+  queueNotEmptyCondition_.notify_all();
+}
+
+void MessageQueue::removeIdleHandler(IdleHandler* handler) {
+  std::lock_guard<std::mutex> idleLock(idleMutex_);
+  std::lock_guard<std::mutex> lk(queueMutex_);
+  idleHandlers_.erase(std::remove_if(idleHandlers_.begin(), idleHandlers_.end(),
+                                     [handler](auto& entry) { return entry.handler == handler; }),
+                      idleHandlers_.end());
+}
+
+bool MessageQueue::runIdleHandler(std::unique_lock<std::mutex>& lk,
+                                  std::chrono::nanoseconds& waitUntil) {
+  auto now = timestamp();
+  if (!idle_) {
+    idle_ = true;
+    idleSince_ = now;
+    for (auto& entry : idleHandlers_) {
+      entry.done = false;
+    }
+  }
+
+  IdleHandler* handler = nullptr;
+  for (auto& entry : idleHandlers_) {
+    if (entry.done) {
+      continue;
+    }
+    auto start = idleSince_ + entry.idleDelay;
+    if (start <= now) {
+      handler = entry.handler;
+      break;
+    }
+    waitUntil = (std::min)(waitUntil, start);
+  }
+  // another loop thread is running one, it's not our turn
+  if (handler == nullptr || !idleMutex_.try_lock()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> idleLock(idleMutex_, std::adopt_lock);
+
+  auto timeLeft =
+      queue_.empty() ? (std::chrono::nanoseconds::max)() : queue_.front()->dueTime - now;
+  lk.unlock();
+  auto more = handler->onIdle(timeLeft);
+  lk.lock();
+
+  for (auto& entry : idleHandlers_) {
+    if (entry.handler == handler) {
+      entry.done = !more;
+    }
+  }
+  return true;
+}
+
 void MessageQueue::shutdownNow(bool awaitTermination) {
+  std::deque<Message*> dropped;
   {
     std::lock_guard<std::mutex> lk(queueMutex_);
     shutdown_ = ShutdownType::kNow;
-    for (auto r : queue_) {
-      releaseMessage(r);
-    }
-    queue_.clear();
+    dropped.swap(queue_);
+  }
+  // outside the lock, cleanups may post to other queues
+  for (auto r : dropped) {
+    releaseMessage(r);
   }
 
   // wake up postMessage
@@ -335,12 +404,18 @@ Message* MessageQueue::awaitDueMessage(MessageQueue::LoopType loopType, size_t o
         return nullptr;
       }
 
-      if (queue_.empty()) {
+      auto waitUntil = queue_.empty() ? (std::chrono::nanoseconds::max)() : queue_.front()->dueTime;
+      if (!idleHandlers_.empty() && LoopQueueGuard::isOutermostLoop(this) &&
+          runIdleHandler(lk, waitUntil)) {
+        continue;
+      }
+
+      if (waitUntil == (std::chrono::nanoseconds::max)()) {
         // await for new message
         queueNotEmptyCondition_.wait(lk);
       } else {
-        // await for next message due
-        auto timeToWait = queue_.front()->dueTime - timestamp();
+        // await for next message due, or the next idle handler
+        auto timeToWait = waitUntil - timestamp();
         if (timeToWait.count() > 0) {
           queueNotEmptyCondition_.wait_for(lk, timeToWait);
         }
@@ -358,6 +433,7 @@ Message* MessageQueue::awaitDueMessage(MessageQueue::LoopType loopType, size_t o
 
     dueMessage = queue_.front();
     queue_.pop_front();
+    idle_ = false;
     break;
   }
 
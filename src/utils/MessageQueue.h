@@ -18,6 +18,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <cstring>
@@ -213,6 +214,28 @@ class MessageQueue {
     friend MessageQueue;
   };
 
+  /**
+   * work to do when the queue is idle, see addIdleHandler.
+   */
+  class IdleHandler {
+   public:
+    virtual ~IdleHandler() = default;
+
+   protected:
+    /**
+     * called on a loop thread, with no message due.
+     * don't call addIdleHandler or removeIdleHandler in it.
+     * @param timeLeft until the next message is due, nanoseconds::max() if there is none.
+     * messages posted meanwhile are not counted, keep the work short.
+     * @return true if there is more work, it is called again in the same idle period,
+     * otherwise not until the queue is idle again.
+     */
+    virtual bool onIdle(std::chrono::nanoseconds timeLeft) = 0;
+
+   private:
+    friend MessageQueue;
+  };
+
  private:
   enum class ShutdownType { kNone, kNow, kAwaitQueue };
 
@@ -231,6 +254,19 @@ class MessageQueue {
 
   std::shared_ptr<Supervisor> supervisor_;
 
+  struct IdleHandlerEntry {
+    IdleHandler* handler;
+    std::chrono::nanoseconds idleDelay;
+    // nothing to do in this idle period
+    bool done;
+  };
+
+  std::vector<IdleHandlerEntry> idleHandlers_;
+  // held while an idle handler runs, locked before queueMutex_
+  std::mutex idleMutex_;
+  bool idle_ = false;
+  std::chrono::nanoseconds idleSince_{0};
+
   static constexpr std::size_t kDefaultPoolSize = 64;
 
   friend class Message;
@@ -258,6 +294,13 @@ class MessageQueue {
 
   void afterMessage(Message& message);
 
+  /**
+   * run an idle handler whose idleDelay has passed, lk is unlocked meanwhile.
+   * @param waitUntil set to when the next idle handler is due, if earlier
+   * @return true if one is run
+   */
+  bool runIdleHandler(std::unique_lock<std::mutex>& lk, std::chrono::nanoseconds& waitUntil);
+
   size_t dueMessageCount() const;
 
   /**
@@ -335,6 +378,18 @@ class MessageQueue {
    */
   void setSupervisor(const std::shared_ptr<Supervisor>& supervisor);
 
+  /**
+   * run handler when the queue has had no due message for idleDelay,
+   * only in the outermost loopQueue(LoopType::kLoopAndWait).
+   * the caller owns handler, and must remove it before it is deleted.
+   */
+  void addIdleHandler(IdleHandler* handler, std::chrono::nanoseconds idleDelay);
+
+  /**
+   * after this returns, handler is not running and won't be called any more.
+   */
+  void removeIdleHandler(IdleHandler* handler);
+
   /**
    * @param delay a std::chrono::duration type like milliseconds nanoseconds
    * @return messageId used to removeMessage, return 0 for failure (already shutdown)
@@ -20,6 +20,9 @@
 namespace script::utils {
 
 ThreadPool::ThreadPool(size_t workerThreads, std::unique_ptr<MessageQueue>&& queue)
+    : ThreadPool(workerThreads, std::shared_ptr<MessageQueue>(std::move(queue))) {}
+
+ThreadPool::ThreadPool(size_t workerThreads, std::shared_ptr<MessageQueue> queue)
     : queue_(std::move(queue)), workers_(workerThreads), threadMutex_() {
   std::lock_guard<std::mutex> lg(threadMutex_);
 
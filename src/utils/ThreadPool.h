@@ -26,7 +26,7 @@ namespace script::utils {
  * A fixed thread-pool based on MessageQueue.
  */
 class ThreadPool {
-  std::unique_ptr<MessageQueue> queue_;
+  std::shared_ptr<MessageQueue> queue_;
   std::vector<std::unique_ptr<std::thread>> workers_;
   std::mutex threadMutex_;
 
@@ -39,6 +39,12 @@ class ThreadPool {
    */
   explicit ThreadPool(size_t workerThreads = 1, std::unique_ptr<MessageQueue>&& queue = {});
 
+  /**
+   * run the workers on a shared queue, eg: the ScriptEngine::messageQueue(),
+   * so that all messages posted to the engine run on the workers.
+   */
+  ThreadPool(size_t workerThreads, std::shared_ptr<MessageQueue> queue);
+
   ~ThreadPool();
 
   SCRIPTX_DISALLOW_COPY_AND_MOVE(ThreadPool);
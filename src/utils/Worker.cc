@@ -0,0 +1,373 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Worker.h"
+#include <ScriptX/ScriptX.h>
+#include <mutex>
+#include <utility>
+
+namespace script::utils {
+
+struct Worker::State {
+  std::mutex mutex;
+  bool terminated = false;
+  ScriptEngine* parent = nullptr;
+  ScriptEngine* engine = nullptr;
+  std::unique_ptr<ThreadPool> looper;
+  // used once on the worker thread
+  EngineFactory factory;
+  MessageCallback onMessage;
+  ErrorCallback onError;
+  // only used on the parent thread
+  Global<Object> scriptObject;
+};
+
+namespace {
+
+/**
+ * postMessage(message[, transferList])
+ */
+SerializedData serializeMessage(const Arguments& args) {
+  Serializer serializer;
+  if (args.size() > 1 && args[1].isArray()) {
+    args[1].asArray().forEach([&serializer](size_t, const Local<Value>& element) {
+      if (element.isByteBuffer()) {
+        serializer.transfer(element.asByteBuffer());
+      }
+    });
+  }
+  serializer.writeValue(args.size() > 0 ? args[0] : Local<Value>());
+  return serializer.release();
+}
+
+}  // namespace
+
+Worker::Worker(ScriptEngine* parent, const EngineFactory& factory)
+    : state_(std::make_shared<State>()) {
+  state_->parent = parent;
+  state_->factory = factory;
+  auto queue = std::make_shared<MessageQueue>();
+  state_->looper = std::make_unique<ThreadPool>(1, queue);
+
+  // the engine lives on the worker thread, so create it there, before any other task
+  struct CreateData {
+    std::weak_ptr<State> state;
+    std::shared_ptr<MessageQueue> queue;
+  };
+  auto msg = state_->looper->obtainInplaceMessage([](InplaceMessage& msg) {
+    auto& data = msg.getObject<CreateData>();
+    auto state = data.state.lock();
+    if (!state) {
+      return;
+    }
+    auto factory = std::move(state->factory);
+    ScriptEngine* engine = nullptr;
+    try {
+      engine = factory(std::move(data.queue));
+    } catch (const std::exception& e) {
+      reportErrorToParent(state, std::string("failed to create the worker engine: ") + e.what());
+      return;
+    }
+    if (engine == nullptr) {
+      reportErrorToParent(state, "failed to create the worker engine");
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (!state->terminated) {
+        state->engine = engine;
+        return;
+      }
+    }
+    // terminated while creating
+    engine->destroy();
+  });
+  msg->inplaceObject<CreateData>(CreateData{state_, std::move(queue)});
+  state_->looper->postMessage(msg);
+
+  dispatch([weak = std::weak_ptr<State>(state_)](ScriptEngine* engine) {
+    engine->set("postMessage", Function::newFunction([weak](const Arguments& args) {
+                  auto data = serializeMessage(args);
+                  if (auto state = weak.lock()) {
+                    postToParent(state, std::move(data));
+                  }
+                  return Local<Value>();
+                }));
+  });
+}
+
+Worker::~Worker() { terminate(); }
+
+void Worker::dispatch(Task task) {
+  struct TaskData {
+    std::weak_ptr<State> state;
+    Task task;
+  };
+
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  if (state_->terminated) {
+    throw Exception("worker is terminated");
+  }
+  auto msg = state_->looper->obtainInplaceMessage([](InplaceMessage& msg) {
+    auto& data = msg.getObject<TaskData>();
+    runOnWorker(data.state, data.task);
+  });
+  msg->inplaceObject<TaskData>(TaskData{state_, std::move(task)});
+  state_->looper->postMessage(msg);
+}
+
+void Worker::postMessage(const Local<Value>& message,
+                         const std::vector<Local<ByteBuffer>>& transfer) {
+  Serializer serializer;
+  for (auto& buffer : transfer) {
+    serializer.transfer(buffer);
+  }
+  serializer.writeValue(message);
+  postToWorker(state_, serializer.release());
+}
+
+void Worker::postToWorker(const std::shared_ptr<State>& state, SerializedData data) {
+  struct MessageData {
+    std::weak_ptr<State> state;
+    // too big for the inplace storage
+    std::unique_ptr<SerializedData> data;
+  };
+
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (state->terminated) {
+    throw Exception("worker is terminated");
+  }
+  auto msg = state->looper->obtainInplaceMessage([](InplaceMessage& msg) {
+    auto& message = msg.getObject<MessageData>();
+    runOnWorker(message.state, [&message](ScriptEngine* engine) {
+      auto value = Deserializer(*message.data).readValue();
+      auto onMessage = engine->get("onmessage");
+      if (onMessage.isFunction()) {
+        onMessage.asFunction().call({}, value);
+      }
+    });
+  });
+  msg->inplaceObject<MessageData>(
+      MessageData{state, std::make_unique<SerializedData>(std::move(data))});
+  state->looper->postMessage(msg);
+}
+
+void Worker::postToParent(const std::shared_ptr<State>& state, SerializedData data) {
+  struct MessageData {
+    std::shared_ptr<State> state;
+    std::unique_ptr<SerializedData> data;
+  };
+
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (state->terminated) {
+    // nobody is listening
+    return;
+  }
+  auto queue = state->parent->messageQueue();
+  auto msg = queue->obtainInplaceMessage([](InplaceMessage& msg) {
+    auto& message = msg.getObject<MessageData>();
+    auto& state = *message.state;
+    MessageCallback callback;
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      if (state.terminated) {
+        return;
+      }
+      callback = state.onMessage;
+    }
+
+    EngineScope scope(state.parent);
+    try {
+      auto value = Deserializer(*message.data).readValue();
+      if (callback) {
+        callback(state.parent, value);
+      }
+      if (!state.scriptObject.isEmpty()) {
+        auto object = state.scriptObject.get();
+        auto onMessage = object.get("onmessage");
+        if (onMessage.isFunction()) {
+          onMessage.asFunction().call(object, value);
+        }
+      }
+    } catch (const Exception& e) {
+      handleError(state, e);
+    }
+  });
+  msg->inplaceObject<MessageData>(
+      MessageData{state, std::make_unique<SerializedData>(std::move(data))});
+  queue->postMessage(msg);
+}
+
+void Worker::runOnWorker(const std::weak_ptr<State>& weak, const Task& task) {
+  auto state = weak.lock();
+  if (!state) {
+    return;
+  }
+  ScriptEngine* engine;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    engine = state->engine;
+  }
+  if (engine == nullptr) {
+    // failed to create, already reported
+    return;
+  }
+
+  std::string error;
+  try {
+    EngineScope scope(engine);
+    task(engine);
+    return;
+  } catch (const Exception& e) {
+    // belongs to the worker engine, only the message can cross
+    error = e.message();
+  } catch (const std::exception& e) {
+    error = e.what();
+  } catch (...) {
+    error = "unknown exception";
+  }
+  reportErrorToParent(state, std::move(error));
+}
+
+void Worker::reportErrorToParent(const std::shared_ptr<State>& state, std::string message) {
+  struct ErrorData {
+    std::shared_ptr<State> state;
+    std::string message;
+  };
+
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (state->terminated) {
+    return;
+  }
+  auto queue = state->parent->messageQueue();
+  auto msg = queue->obtainInplaceMessage([](InplaceMessage& msg) {
+    auto& data = msg.getObject<ErrorData>();
+    auto& state = *data.state;
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      if (state.terminated) {
+        return;
+      }
+    }
+    EngineScope scope(state.parent);
+    handleError(state, Exception(std::move(data.message)));
+  });
+  msg->inplaceObject<ErrorData>(ErrorData{state, std::move(message)});
+  queue->postMessage(msg);
+}
+
+void Worker::handleError(State& state, const Exception& error) {
+  ErrorCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    callback = state.onError;
+  }
+
+  try {
+    if (callback) {
+      callback(state.parent, error);
+    }
+    if (!state.scriptObject.isEmpty()) {
+      auto object = state.scriptObject.get();
+      auto onError = object.get("onerror");
+      if (onError.isFunction()) {
+        onError.asFunction().call(object, error.exception());
+      }
+    }
+  } catch (const Exception&) {
+    // nowhere left to report, don't throw into the parent's message loop
+  }
+}
+
+void Worker::setOnMessage(MessageCallback callback) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->onMessage = std::move(callback);
+}
+
+void Worker::setOnError(ErrorCallback callback) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->onError = std::move(callback);
+}
+
+Local<Object> Worker::getScriptObject() {
+  if (state_->scriptObject.isEmpty()) {
+    auto object = Object::newObject();
+    // weak, the State holds the object
+    object.set("postMessage",
+               Function::newFunction([weak = std::weak_ptr<State>(state_)](const Arguments& args) {
+                 auto state = weak.lock();
+                 if (!state) {
+                   throw Exception("worker is terminated");
+                 }
+                 postToWorker(state, serializeMessage(args));
+                 return Local<Value>();
+               }));
+    state_->scriptObject = object;
+  }
+  return state_->scriptObject.get();
+}
+
+void Worker::terminate() {
+  std::unique_ptr<ThreadPool> looper;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->terminated) {
+      return;
+    }
+    state_->terminated = true;
+    state_->onMessage = nullptr;
+    state_->onError = nullptr;
+    looper = std::move(state_->looper);
+  }
+
+  // drop the queued messages, and stop the running one, it may never return by itself
+  looper->shutdownNow(false);
+  ScriptEngine* running;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    running = state_->engine;
+  }
+  if (running != nullptr) {
+    running->interrupt();
+  }
+  looper->awaitTermination();
+  looper.reset();
+
+  // read after the thread stops, it may be creating the engine just now
+  ScriptEngine* engine;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    engine = state_->engine;
+    state_->engine = nullptr;
+  }
+  if (engine != nullptr) {
+    engine->destroy();
+  }
+
+  if (!state_->scriptObject.isEmpty()) {
+    EngineScope scope(state_->parent);
+    state_->scriptObject.reset();
+  }
+}
+
+ScriptEngine* Worker::engine() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->engine;
+}
+
+}  // namespace script::utils
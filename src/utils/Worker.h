@@ -0,0 +1,152 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../Engine.h"
+#include "../Reference.h"
+#include "ThreadPool.h"
+
+namespace script {
+class Exception;
+struct SerializedData;
+}
+
+namespace script::utils {
+
+/**
+ * A worker engine running on its own thread, talking to its parent engine by messages.
+ * Messages are copied with Serializer, so they can hold anything Serializer supports,
+ * and ByteBuffers can be transferred instead of copied.
+ *
+ * In the worker engine, there is a global function `postMessage(message[, transferList])`,
+ * and messages from the parent are passed to the global function `onmessage(message)`.
+ *
+ * On the parent side, use Worker::postMessage and Worker::setOnMessage from C++,
+ * or getScriptObject() for scripts, which has the same `postMessage` and `onmessage`.
+ * Messages from the worker are posted to parent->messageQueue(), the parent must loop it.
+ *
+ * \code
+ * Worker worker(engine, [](auto queue) { return new ScriptEngineImpl(queue); });
+ * worker.dispatch([](ScriptEngine* e) { e->eval(workerScript); });
+ *
+ * EngineScope scope(engine);
+ * engine->set("worker", worker.getScriptObject());
+ * engine->eval("worker.onmessage = function(m) {...}; worker.postMessage(data);");
+ * \endcode
+ *
+ * Exceptions thrown by the engine factory, the worker's onmessage or dispatched tasks are reported
+ * to the parent as a new Exception carrying the same message, and exceptions thrown by the parent's
+ * onmessage are reported as is. They go to setOnError and the script object's `onerror(error)`,
+ * and are dropped if neither is set (or if the error handler throws itself).
+ * The Worker must be destroyed before the parent engine.
+ */
+class Worker {
+ public:
+  /**
+   * create the worker engine, called on the worker thread, without EngineScope.
+   * the engine MUST use the given queue, which the worker thread loops.
+   */
+  using EngineFactory = std::function<ScriptEngine*(std::shared_ptr<MessageQueue> queue)>;
+
+  using Task = std::function<void(ScriptEngine*)>;
+
+  /**
+   * called on the parent thread, with parent EngineScope entered.
+   */
+  using MessageCallback = std::function<void(ScriptEngine* parent, const Local<Value>& message)>;
+
+  /**
+   * called on the parent thread, with parent EngineScope entered.
+   */
+  using ErrorCallback = std::function<void(ScriptEngine* parent, const Exception& error)>;
+
+ private:
+  struct State;
+  std::shared_ptr<State> state_;
+
+ public:
+  /**
+   * @param parent the engine creating this Worker
+   * @param factory creates the worker engine, on the worker thread before any dispatched task
+   */
+  Worker(ScriptEngine* parent, const EngineFactory& factory);
+
+  /**
+   * terminate the worker.
+   */
+  ~Worker();
+
+  SCRIPTX_DISALLOW_COPY_AND_MOVE(Worker);
+
+  /**
+   * run the task on the worker thread, with worker EngineScope entered.
+   * eg: load the worker script.
+   */
+  void dispatch(Task task);
+
+  /**
+   * post a message to the worker, must be called with parent EngineScope entered.
+   * @param transfer ByteBuffers to be transferred, see Serializer::transfer
+   * @throw Exception if the worker is terminated, or the message can't be serialized
+   */
+  void postMessage(const Local<Value>& message,
+                   const std::vector<Local<ByteBuffer>>& transfer = {});
+
+  void setOnMessage(MessageCallback callback);
+
+  void setOnError(ErrorCallback callback);
+
+  /**
+   * an object for the parent scripts, with `postMessage(message[, transferList])` function,
+   * and set its `onmessage` and `onerror` properties to receive messages and errors.
+   * must be called with parent EngineScope entered.
+   */
+  Local<Object> getScriptObject();
+
+  /**
+   * stop the worker thread and destroy the worker engine, messages not handled yet are dropped.
+   * a script still running is interrupted, see ScriptEngine::interrupt.
+   * must be called on the parent thread.
+   */
+  void terminate();
+
+  /**
+   * @return the worker engine, nullptr if it's not created yet, failed to create, or terminated.
+   */
+  ScriptEngine* engine() const;
+
+ private:
+  static void postToWorker(const std::shared_ptr<State>& state, SerializedData data);
+
+  static void postToParent(const std::shared_ptr<State>& state, SerializedData data);
+
+  /**
+   * run with worker EngineScope entered, exceptions are reported to the parent.
+   */
+  static void runOnWorker(const std::weak_ptr<State>& weak, const Task& task);
+
+  static void reportErrorToParent(const std::shared_ptr<State>& state, std::string message);
+
+  static void handleError(State& state, const Exception& error);
+};
+
+}  // namespace script::utils
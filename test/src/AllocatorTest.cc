@@ -0,0 +1,123 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include "test.h"
+
+namespace script::test {
+
+TEST(Allocator, ArenaSmallBlocks) {
+  utils::ArenaAllocator arena(4096);
+  auto a = arena.allocate(24);
+  auto b = arena.allocate(100);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % alignof(std::max_align_t), 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(std::max_align_t), 0);
+
+  auto stat = arena.getStatistics();
+  EXPECT_EQ(stat.allocated, 124);
+  EXPECT_EQ(stat.blocks, 2);
+  EXPECT_EQ(stat.reserved, 4096);
+
+  // recycled by size class
+  arena.deallocate(a, 24);
+  EXPECT_EQ(arena.allocate(20), a);
+  arena.deallocate(a, 20);
+  arena.deallocate(b, 100);
+
+  stat = arena.getStatistics();
+  EXPECT_EQ(stat.allocated, 0);
+  EXPECT_EQ(stat.blocks, 0);
+
+  // zero sized blocks come from the smallest class
+  auto empty = arena.allocate(0);
+  ASSERT_NE(empty, nullptr);
+  EXPECT_NE(arena.allocate(0), empty);
+  arena.deallocate(empty, 0);
+  EXPECT_EQ(arena.allocate(1), empty);
+}
+
+TEST(Allocator, ArenaLargeBlocks) {
+  utils::ArenaAllocator arena;
+  auto size = utils::ArenaAllocator::kMaxSmallSize * 4;
+  auto a = static_cast<char*>(arena.allocate(size));
+  ASSERT_NE(a, nullptr);
+  std::memset(a, 'a', size);
+  EXPECT_EQ(arena.getStatistics().reserved, size);
+
+  a = static_cast<char*>(arena.reallocate(a, size, size * 2));
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a[size - 1], 'a');
+  EXPECT_EQ(arena.getStatistics().allocated, size * 2);
+
+  // large to small
+  a = static_cast<char*>(arena.reallocate(a, size * 2, 8));
+  ASSERT_NE(a, nullptr);
+  EXPECT_EQ(a[7], 'a');
+  EXPECT_EQ(arena.getStatistics().allocated, 8);
+
+  // leaked on purpose, released with the arena
+  arena.allocate(size);
+}
+
+TEST(Allocator, ArenaReallocate) {
+  utils::ArenaAllocator arena;
+  auto a = static_cast<char*>(arena.allocate(10));
+  std::memcpy(a, "0123456789", 10);
+
+  // same size class, kept in place
+  EXPECT_EQ(arena.reallocate(a, 10, 12), a);
+
+  auto b = static_cast<char*>(arena.reallocate(a, 12, 200));
+  ASSERT_NE(b, nullptr);
+  EXPECT_EQ(std::string(b, 10), "0123456789");
+  EXPECT_EQ(arena.getStatistics().allocated, 200);
+  EXPECT_EQ(arena.getStatistics().blocks, 1);
+  arena.deallocate(b, 200);
+}
+
+#if defined(SCRIPTX_BACKEND_QUICKJS) || defined(SCRIPTX_BACKEND_LUA)
+
+TEST(Allocator, EngineWithArena) {
+  auto arena = std::make_shared<utils::ArenaAllocator>();
+#ifdef SCRIPTX_BACKEND_QUICKJS
+  auto engine = new qjs_backend::QjsEngine(nullptr, nullptr, arena);
+  auto script = "var a = []; for (var i = 0; i < 1000; ++i) a.push({i: i}); a.length";
+#else
+  auto engine = new lua_backend::LuaEngine({}, {}, {}, arena);
+  auto script = "local a = {}; for i = 1, 1000 do a[i] = {i = i} end; return #a";
+#endif
+
+  {
+    EngineScope scope(engine);
+    auto before = arena->getStatistics().allocated;
+    EXPECT_GT(before, 0);
+    auto ret = engine->eval(script);
+    EXPECT_EQ(ret.asNumber().toInt32(), 1000);
+    EXPECT_GT(arena->getStatistics().allocated, before);
+  }
+  engine->destroy();
+
+  // everything given back by the engine
+  EXPECT_EQ(arena->getStatistics().blocks, 0);
+}
+
+#endif
+
+}  // namespace script::test
@@ -0,0 +1,153 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(AsyncFunctionTest);
+
+namespace {
+
+// results come back through the MessageQueue
+template <typename Pred>
+void loopUntil(ScriptEngine* engine, Pred&& done) {
+  for (int i = 0; i < 1000 && !done(); ++i) {
+    engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+bool isNumber(ScriptEngine* engine, const char* name) {
+  EngineScope engineScope(engine);
+  return engine->get(name).isNumber();
+}
+
+}  // namespace
+
+TEST_F(AsyncFunctionTest, Resolve) {
+  auto pool = std::make_shared<utils::ThreadPool>(1);
+  auto engineThread = std::this_thread::get_id();
+  std::thread::id workerThread;
+
+  auto define = defineClass("AsyncTest")
+                    .asyncFunction(
+                        "add",
+                        [&workerThread](int a, const std::string& b) {
+                          workerThread = std::this_thread::get_id();
+                          return a + std::stoi(b);
+                        },
+                        pool)
+                    .build();
+  {
+    EngineScope engineScope(engine);
+    engine->registerNativeClass(define);
+    auto promise = engine->eval(TS().js("AsyncTest.add(1, '2').then(v => result = v);")
+                                    .lua("return AsyncTest.add(1, '2'):next(function(v) "
+                                         "result = v end)")
+                                    .select());
+    EXPECT_TRUE(promise.isPromise());
+
+    // arguments are checked on the engine thread
+    EXPECT_THROW(engine->eval(TS().js("AsyncTest.add(1)").lua("AsyncTest.add(1)").select()),
+                 Exception);
+  }
+
+  loopUntil(engine, [this]() { return isNumber(engine, "result"); });
+  EngineScope engineScope(engine);
+  EXPECT_EQ(engine->get("result").asNumber().toInt32(), 3);
+  EXPECT_NE(workerThread, engineThread);
+}
+
+TEST_F(AsyncFunctionTest, Reject) {
+  auto define =
+      defineClass("AsyncTest")
+          .asyncFunction("fail", []() -> int { throw std::runtime_error("async failed"); })
+          .asyncFunction("nothing", []() {})
+          .build();
+  {
+    EngineScope engineScope(engine);
+    engine->registerNativeClass(define);
+    auto script = TS().js(R"(
+      AsyncTest.fail().catch(e => failure = e.message);
+      AsyncTest.nothing().then(v => done = v === undefined ? 1 : 0);
+    )")
+                      .lua(R"(
+      AsyncTest.fail():catch(function(e) failure = e end)
+      AsyncTest.nothing():next(function(v) done = v == nil and 1 or 0 end)
+    )")
+                      .select();
+    engine->eval(script);
+  }
+
+  loopUntil(engine, [this]() { return isNumber(engine, "done"); });
+  loopUntil(engine, [this]() {
+    EngineScope engineScope(engine);
+    return engine->get("failure").isString();
+  });
+  EngineScope engineScope(engine);
+  EXPECT_EQ(engine->get("done").asNumber().toInt32(), 1);
+  EXPECT_NE(engine->get("failure").asString().toString().find("async failed"), std::string::npos);
+}
+
+TEST_F(AsyncFunctionTest, Cancelled) {
+  auto pool = std::make_shared<utils::ThreadPool>(1);
+  std::promise<void> started;
+  std::promise<void> release;
+  auto define = defineClass("AsyncTest")
+                    .asyncFunction(
+                        "block",
+                        [&started, wait = release.get_future().share()]() {
+                          started.set_value();
+                          wait.wait();
+                        },
+                        pool)
+                    .asyncFunction("queued", []() {}, pool)
+                    .build();
+  {
+    EngineScope engineScope(engine);
+    engine->registerNativeClass(define);
+    engine->eval(TS().js(R"(
+      AsyncTest.block();
+      AsyncTest.queued().catch(e => failure = e.message);
+    )")
+                     .lua(R"(
+      AsyncTest.block()
+      AsyncTest.queued():catch(function(e) failure = e end)
+    )")
+                     .select());
+  }
+
+  // the pool is busy with block(), queued() is dropped
+  started.get_future().wait();
+  pool->shutdownNow();
+  release.set_value();
+  pool->awaitTermination();
+
+  loopUntil(engine, [this]() {
+    EngineScope engineScope(engine);
+    return engine->get("failure").isString();
+  });
+  EngineScope engineScope(engine);
+  EXPECT_NE(engine->get("failure").asString().toString().find("cancelled"), std::string::npos);
+}
+
+}  // namespace script::test
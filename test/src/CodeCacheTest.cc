@@ -0,0 +1,266 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filesystem>
+#include <fstream>
+#include "test.h"
+
+namespace script::test {
+
+TEST(CodeCache, HashKey) {
+  auto key = utils::CodeCache::hashKey("var a = 1;", "salt");
+  EXPECT_EQ(key, utils::CodeCache::hashKey("var a = 1;", "salt"));
+  EXPECT_NE(key, utils::CodeCache::hashKey("var a = 2;", "salt"));
+  EXPECT_NE(key, utils::CodeCache::hashKey("var a = 1;", "salt2"));
+  EXPECT_NE(utils::CodeCache::hashKey("bc", "a"), utils::CodeCache::hashKey("c", "ab"));
+
+  // file name safe
+  for (auto c : key) {
+    EXPECT_TRUE((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || c == '-') << c;
+  }
+}
+
+TEST(CodeCache, MemoryCache) {
+  utils::MemoryCodeCache cache;
+  std::string data;
+  EXPECT_FALSE(cache.load("key", data));
+
+  cache.store("key", std::string_view("\0data", 5));
+  EXPECT_TRUE(cache.load("key", data));
+  EXPECT_EQ(data, std::string("\0data", 5));
+  EXPECT_EQ(cache.size(), 1);
+
+  cache.remove("key");
+  EXPECT_FALSE(cache.load("key", data));
+}
+
+TEST(CodeCache, DirectoryCache) {
+  utils::DirectoryCodeCache cache(testing::TempDir());
+  auto key = utils::CodeCache::hashKey("DirectoryCache", "test");
+  std::string data;
+  cache.remove(key);
+  EXPECT_FALSE(cache.load(key, data));
+
+  cache.store(key, std::string_view("\0data", 5));
+  EXPECT_TRUE(cache.load(key, data));
+  EXPECT_EQ(data, std::string("\0data", 5));
+
+  // overwrite
+  cache.store(key, "new data");
+  EXPECT_TRUE(cache.load(key, data));
+  EXPECT_EQ(data, "new data");
+
+  cache.remove(key);
+  EXPECT_FALSE(cache.load(key, data));
+}
+
+TEST(CodeCache, TieredCache) {
+  auto memory = std::make_shared<utils::MemoryCodeCache>();
+  auto disk = std::make_shared<utils::MemoryCodeCache>();
+  utils::TieredCodeCache cache(memory, disk);
+
+  std::string data;
+  disk->store("key", "data");
+  EXPECT_TRUE(cache.load("key", data));
+  EXPECT_EQ(data, "data");
+  // promoted to first level
+  EXPECT_EQ(memory->size(), 1);
+
+  cache.store("key2", "data2");
+  EXPECT_EQ(memory->size(), 2);
+  EXPECT_EQ(disk->size(), 2);
+
+  cache.remove("key");
+  EXPECT_FALSE(memory->load("key", data));
+  EXPECT_FALSE(disk->load("key", data));
+}
+
+#ifdef SCRIPTX_BACKEND_V8
+
+TEST(CodeCache, V8EvalWithCodeCache) {
+  auto cache = std::make_shared<utils::MemoryCodeCache>();
+  auto script = R"(
+    function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+    fib(10);
+  )";
+
+  for (int i = 0; i < 2; ++i) {
+    auto engine = new v8_backend::V8Engine();
+    engine->setCodeCache(cache);
+    {
+      EngineScope scope(engine);
+      auto ret = engine->eval(script);
+      EXPECT_EQ(ret.asNumber().toInt32(), 55);
+    }
+    engine->destroy();
+  }
+
+  auto stat = cache->getStatistics();
+  EXPECT_EQ(stat.miss, 1);
+  EXPECT_EQ(stat.produced, 1);
+  EXPECT_EQ(stat.hit, 1);
+  EXPECT_EQ(stat.rejected, 0);
+  EXPECT_EQ(cache->size(), 1);
+}
+
+TEST(CodeCache, V8RejectedCodeCache) {
+  auto cache = std::make_shared<utils::MemoryCodeCache>();
+  auto script = "1 + 1";
+
+  auto engine = new v8_backend::V8Engine();
+  engine->setCodeCache(cache);
+  {
+    EngineScope scope(engine);
+    auto key = utils::CodeCache::hashKey(script, v8::V8::GetVersion());
+    cache->store(key, "not a valid code cache");
+
+    auto ret = engine->eval(script);
+    EXPECT_EQ(ret.asNumber().toInt32(), 2);
+  }
+  engine->destroy();
+
+  auto stat = cache->getStatistics();
+  EXPECT_EQ(stat.rejected, 1);
+  // fresh code cache written back
+  EXPECT_EQ(stat.produced, 1);
+}
+
+#endif
+
+#ifdef SCRIPTX_BACKEND_QUICKJS
+
+TEST(CodeCache, QjsBytecode) {
+  auto engine = new qjs_backend::QjsEngine();
+  {
+    EngineScope scope(engine);
+    auto bytecode = engine->compileBytecode(String::newString("var x = 40; x + 2"));
+    EXPECT_GT(bytecode.byteLength(), 0);
+    // not run yet
+    EXPECT_TRUE(engine->get(String::newString("x")).isNull());
+
+    auto ret = engine->evalBytecode(bytecode);
+    EXPECT_EQ(ret.asNumber().toInt32(), 42);
+    EXPECT_EQ(engine->get(String::newString("x")).asNumber().toInt32(), 40);
+
+    auto invalid = ByteBuffer::newByteBuffer(16);
+    EXPECT_THROW(engine->evalBytecode(invalid), Exception);
+  }
+  engine->destroy();
+}
+
+TEST(CodeCache, QjsEvalWithCodeCache) {
+  auto cache = std::make_shared<utils::MemoryCodeCache>();
+  auto script = R"(
+    function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+    fib(10);
+  )";
+
+  for (int i = 0; i < 2; ++i) {
+    auto engine = new qjs_backend::QjsEngine();
+    engine->setCodeCache(cache);
+    {
+      EngineScope scope(engine);
+      auto ret = engine->eval(script);
+      EXPECT_EQ(ret.asNumber().toInt32(), 55);
+    }
+    engine->destroy();
+  }
+
+  auto stat = cache->getStatistics();
+  EXPECT_EQ(stat.miss, 1);
+  EXPECT_EQ(stat.produced, 1);
+  EXPECT_EQ(stat.hit, 1);
+  EXPECT_EQ(stat.rejected, 0);
+}
+
+#endif
+
+#ifdef SCRIPTX_BACKEND_LUA
+
+TEST(CodeCache, LuaChunk) {
+  auto engine = new lua_backend::LuaEngine();
+  {
+    EngineScope scope(engine);
+    auto chunk = engine->compileChunk(String::newString("x = 40; return x + 2"));
+    EXPECT_GT(chunk.byteLength(), 0);
+    // not run yet
+    EXPECT_TRUE(engine->get(String::newString("x")).isNull());
+
+    auto ret = engine->evalChunk(chunk);
+    EXPECT_EQ(ret.asNumber().toInt32(), 42);
+    EXPECT_EQ(engine->get(String::newString("x")).asNumber().toInt32(), 40);
+
+    // text chunk is not accepted
+    auto text = std::string("return 1");
+    EXPECT_THROW(engine->evalChunk(ByteBuffer::newByteBuffer(text.data(), text.size())),
+                 Exception);
+  }
+  engine->destroy();
+}
+
+TEST(CodeCache, LuaEvalWithCodeCache) {
+  auto cache = std::make_shared<utils::MemoryCodeCache>();
+  auto script = R"(
+    local function fib(n) if n < 2 then return n end return fib(n - 1) + fib(n - 2) end
+    return fib(10)
+  )";
+
+  for (int i = 0; i < 2; ++i) {
+    auto engine = new lua_backend::LuaEngine();
+    engine->setCodeCache(cache);
+    {
+      EngineScope scope(engine);
+      auto ret = engine->eval(script);
+      EXPECT_EQ(ret.asNumber().toInt32(), 55);
+    }
+    engine->destroy();
+  }
+
+  auto stat = cache->getStatistics();
+  EXPECT_EQ(stat.miss, 1);
+  EXPECT_EQ(stat.produced, 1);
+  EXPECT_EQ(stat.hit, 1);
+  EXPECT_EQ(stat.rejected, 0);
+}
+
+TEST(CodeCache, LuaPrecompileDirectory) {
+  namespace fs = std::filesystem;
+  auto dir = fs::path(testing::TempDir()) / "LuaPrecompileDirectory";
+  fs::create_directories(dir / "lib");
+  std::ofstream(dir / "main.lua") << "return 1";
+  std::ofstream(dir / "lib" / "util.lua") << "return 2";
+  std::ofstream(dir / "README.md") << "not a script";
+
+  auto cache = std::make_shared<utils::MemoryCodeCache>();
+  auto engine = new lua_backend::LuaEngine();
+  {
+    EXPECT_EQ(engine->precompileDirectory(dir.string(), *cache), 2);
+    EXPECT_EQ(cache->size(), 2);
+
+    engine->setCodeCache(cache);
+    EngineScope scope(engine);
+    auto ret = engine->eval(String::newString("return 2"), String::newString("lib/util.lua"));
+    EXPECT_EQ(ret.asNumber().toInt32(), 2);
+    EXPECT_EQ(cache->getStatistics().hit, 1);
+  }
+  engine->destroy();
+  fs::remove_all(dir);
+}
+
+#endif
+
+}  // namespace script::test
@@ -0,0 +1,136 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(ContainerConverterTest);
+
+static_assert(converter::isConvertible<std::vector<double>>);
+static_assert(converter::isConvertible<std::vector<std::string>>);
+static_assert(converter::isConvertible<std::array<int, 3>>);
+static_assert(converter::isConvertible<std::map<std::string, int>>);
+static_assert(converter::isConvertible<std::unordered_map<std::string, std::vector<int>>>);
+
+TEST_F(ContainerConverterTest, Vector) {
+  EngineScope engineScope(engine);
+  std::vector<double> numbers{1.5, 2, 3};
+  auto array = converter::Converter<std::vector<double>>::toScript(numbers);
+  ASSERT_TRUE(array.isArray());
+  EXPECT_EQ(array.asArray().size(), 3);
+  EXPECT_EQ(array.asArray().get(0).asNumber().toDouble(), 1.5);
+  EXPECT_EQ(converter::Converter<std::vector<double>>::toCpp(array), numbers);
+
+  std::vector<std::string> strings{"hello", "", "world"};
+  auto back = converter::Converter<std::vector<std::string>>::toCpp(
+      converter::Converter<std::vector<std::string>>::toScript(strings));
+  EXPECT_EQ(back, strings);
+
+  EXPECT_TRUE(converter::Converter<std::vector<int>>::toCpp(Array::newArray()).empty());
+
+  // from script
+  auto sum = Function::newFunction([](const std::vector<int>& values) {
+    int ret = 0;
+    for (auto v : values) ret += v;
+    return ret;
+  });
+  auto ret = sum.call({}, Array::of(1, 2, 3));
+  EXPECT_EQ(ret.asNumber().toInt32(), 6);
+}
+
+TEST_F(ContainerConverterTest, StdArray) {
+  EngineScope engineScope(engine);
+  std::array<int, 3> values{1, 2, 3};
+  auto array = converter::Converter<std::array<int, 3>>::toScript(values);
+  EXPECT_EQ(array.asArray().size(), 3);
+  auto back = converter::Converter<std::array<int, 3>>::toCpp(array);
+  EXPECT_EQ(back, values);
+
+  EXPECT_THROW((converter::Converter<std::array<int, 2>>::toCpp(array)), Exception);
+}
+
+#ifdef __cpp_lib_span
+TEST_F(ContainerConverterTest, Span) {
+  EngineScope engineScope(engine);
+  int values[] = {1, 2, 3};
+  auto array = converter::Converter<std::span<int>>::toScript(std::span<int>(values));
+  EXPECT_EQ(converter::Converter<std::vector<int>>::toCpp(array), std::vector<int>({1, 2, 3}));
+}
+#endif
+
+TEST_F(ContainerConverterTest, Map) {
+  EngineScope engineScope(engine);
+  std::map<std::string, int> map{{"one", 1}, {"two", 2}};
+  auto object = converter::Converter<std::map<std::string, int>>::toScript(map);
+  ASSERT_TRUE(object.isObject());
+  EXPECT_EQ(object.asObject().get("two").asNumber().toInt32(), 2);
+  EXPECT_EQ((converter::Converter<std::map<std::string, int>>::toCpp(object)), map);
+
+  std::unordered_map<std::string, std::vector<int>> nested{{"a", {1, 2}}, {"b", {}}};
+  using Nested = std::unordered_map<std::string, std::vector<int>>;
+  auto back = converter::Converter<Nested>::toCpp(converter::Converter<Nested>::toScript(nested));
+  EXPECT_EQ(back, nested);
+}
+
+TEST_F(ContainerConverterTest, VectorOfLocal) {
+  EngineScope engineScope(engine);
+  std::vector<Local<Object>> objects;
+  for (int i = 0; i < 3; ++i) {
+    auto object = Object::newObject();
+    object.set("id", i);
+    objects.push_back(object);
+  }
+  auto array = converter::Converter<std::vector<Local<Object>>>::toScript(objects);
+  auto back = converter::Converter<std::vector<Local<Object>>>::toCpp(array);
+  ASSERT_EQ(back.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    // still valid, and each one is its own element
+    EXPECT_TRUE(back[i] == objects[i]);
+    EXPECT_EQ(back[i].get("id").asNumber().toInt32(), i);
+  }
+
+  using Nested = std::vector<std::vector<Local<Value>>>;
+  auto nested = converter::Converter<Nested>::toCpp(
+      Array::of(Array::of(1, "a"), Array::of(2, "b")));
+  ASSERT_EQ(nested.size(), 2);
+  EXPECT_EQ(nested[1][1].asString().toString(), "b");
+}
+
+TEST_F(ContainerConverterTest, ArrayForEach) {
+  EngineScope engineScope(engine);
+  auto array = Array::of(1, "two", 3);
+  std::vector<size_t> indexes;
+  array.forEach([&indexes](size_t index, const Local<Value>& element) {
+    indexes.push_back(index);
+    EXPECT_EQ(element.isString(), index == 1);
+  });
+  EXPECT_EQ(indexes, std::vector<size_t>({0, 1, 2}));
+
+  // exceptions propagate, and the array is still usable
+  EXPECT_THROW(array.forEach([](size_t, const Local<Value>&) { throw Exception("stop"); }),
+               Exception);
+  EXPECT_EQ(array.size(), 3);
+  EXPECT_EQ(array.get(2).asNumber().toInt32(), 3);
+}
+
+}  // namespace script::test
@@ -0,0 +1,120 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <future>
+#include <thread>
+#include "test.h"
+
+namespace script::test {
+
+TEST(EngineGroup, BroadcastAndDispatch) {
+  utils::EngineGroup group(2, [] { return new ScriptEngineImpl(); });
+  ASSERT_EQ(group.size(), 2);
+
+  std::atomic<int> bootstrapped{0};
+  group.broadcast([&bootstrapped](ScriptEngine* engine) {
+    engine->set(String::newString("shard"), Number::newNumber(bootstrapped++));
+  });
+  EXPECT_EQ(bootstrapped.load(), 2);
+
+  // affinity
+  std::promise<int> shard;
+  auto index = group.dispatch(3, [&shard](ScriptEngine* engine) {
+    shard.set_value(engine->get(String::newString("shard")).asNumber().toInt32());
+  });
+  EXPECT_EQ(index, 1);
+  EXPECT_EQ(group.dispatch(5, [](ScriptEngine*) {}), 1);
+  auto shardValue = shard.get_future().get();
+
+  std::promise<int> again;
+  group.dispatchTo(index, [&again](ScriptEngine* engine) {
+    again.set_value(engine->get(String::newString("shard")).asNumber().toInt32());
+  });
+  EXPECT_EQ(again.get_future().get(), shardValue);
+
+  // least-loaded
+  std::promise<void> block;
+  auto blocked = block.get_future().share();
+  auto busy = group.dispatch([blocked](ScriptEngine*) { blocked.wait(); });
+  EXPECT_EQ(group.getStatistics(busy).queueDepth, 1);
+  for (int i = 0; i < 3; ++i) {
+    std::promise<void> done;
+    EXPECT_NE(group.dispatch([&done](ScriptEngine*) { done.set_value(); }), busy);
+    done.get_future().wait();
+  }
+  block.set_value();
+
+  group.broadcast([](ScriptEngine*) {});
+  // counters are updated right after the task returns
+  auto stats = group.getStatistics();
+  for (int i = 0; i < 100 && stats[0].processed + stats[1].processed < 11; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    stats = group.getStatistics();
+  }
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].queueDepth + stats[1].queueDepth, 0);
+  EXPECT_EQ(stats[0].processed + stats[1].processed, 11);
+}
+
+TEST(EngineGroup, BroadcastException) {
+  utils::EngineGroup group(2, [] { return new ScriptEngineImpl(); });
+  EXPECT_THROW(group.broadcast([](ScriptEngine*) { throw Exception("bootstrap failed"); }),
+               Exception);
+}
+
+TEST(EngineGroup, OnError) {
+  utils::EngineGroup group(1, [] { return new ScriptEngineImpl(); });
+  std::promise<std::string> error;
+  group.setOnError([&error](ScriptEngine* engine, const Exception& e) {
+    EXPECT_EQ(EngineScope::currentEngine(), engine);
+    error.set_value(e.message());
+  });
+  group.dispatch([](ScriptEngine*) { throw std::runtime_error("task failed"); });
+  EXPECT_EQ(error.get_future().get(), "task failed");
+}
+
+namespace {
+
+// posts itself again forever, like a repeating timer
+void repost(utils::Message& msg) {
+  auto queue = static_cast<utils::MessageQueue*>(msg.ptr0);
+  utils::Message next(repost, nullptr);
+  next.ptr0 = queue;
+  queue->postMessage(next, std::chrono::milliseconds(1));
+}
+
+}  // namespace
+
+TEST(EngineGroup, ReleaseWhileSelfPosting) {
+  std::atomic<bool> finished{false};
+  {
+    utils::EngineGroup group(1, [] { return new ScriptEngineImpl(); });
+    group.dispatch([](ScriptEngine* engine) {
+      utils::Message msg(repost, nullptr);
+      msg.ptr0 = engine->messageQueue().get();
+      engine->messageQueue()->postMessage(msg);
+    });
+    // dispatched tasks still run before the release
+    group.dispatch([&finished](ScriptEngine*) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      finished = true;
+    });
+  }
+  EXPECT_TRUE(finished);
+}
+
+}  // namespace script::test
@@ -0,0 +1,148 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test.h"
+
+namespace script::test {
+
+namespace {
+
+ScriptEngine* newWarmEngine() {
+  auto engine = new ScriptEngineImpl();
+  EngineScope scope(engine);
+  engine->set(String::newString("warm"), Boolean::newBoolean(true));
+  return engine;
+}
+
+}  // namespace
+
+TEST(EnginePool, LeaseAndReset) {
+  utils::EnginePool pool(2, newWarmEngine, [](ScriptEngine* engine) {
+    EngineScope scope(engine);
+    engine->set(String::newString("dirty"), Local<Value>());
+    return true;
+  });
+  EXPECT_EQ(pool.idleCount(), 2);
+
+  ScriptEngine* first;
+  {
+    auto lease = pool.lease();
+    first = lease.get();
+    EXPECT_EQ(pool.idleCount(), 1);
+
+    EngineScope scope(lease.get());
+    EXPECT_TRUE(lease->get(String::newString("warm")).asBoolean().value());
+    lease->set(String::newString("dirty"), Boolean::newBoolean(true));
+  }
+  EXPECT_EQ(pool.idleCount(), 2);
+
+  {
+    auto lease = pool.lease();
+    // reused, and reset
+    EXPECT_EQ(lease.get(), first);
+    EngineScope scope(lease.get());
+    EXPECT_TRUE(lease->get(String::newString("dirty")).isNull());
+  }
+
+  auto stat = pool.getStatistics();
+  EXPECT_EQ(stat.leased, 2);
+  EXPECT_EQ(stat.hit, 2);
+  EXPECT_EQ(stat.reset, 2);
+  EXPECT_EQ(stat.recreated, 0);
+  EXPECT_DOUBLE_EQ(stat.hitRate(), 1.0);
+}
+
+TEST(EnginePool, RecreateAndOverflow) {
+  utils::EnginePool pool(1, newWarmEngine);
+  {
+    auto lease1 = pool.lease();
+    auto lease2 = pool.lease();
+    EXPECT_NE(lease1.get(), lease2.get());
+    EXPECT_EQ(pool.idleCount(), 0);
+
+    lease2.discard();
+  }
+  // no more than pool size
+  EXPECT_EQ(pool.idleCount(), 1);
+
+  auto stat = pool.getStatistics();
+  EXPECT_EQ(stat.hit, 1);
+  EXPECT_EQ(stat.miss, 1);
+  EXPECT_EQ(stat.reset, 0);
+  EXPECT_EQ(stat.recreated, 1);
+
+  auto lease = pool.lease();
+  EngineScope scope(lease.get());
+  EXPECT_TRUE(lease->get(String::newString("warm")).asBoolean().value());
+}
+
+TEST(EnginePool, FactoryThrows) {
+  auto alive = std::make_shared<int>(0);
+  int created = 0;
+  auto factory = [&]() -> ScriptEngine* {
+    if (created == 2) {
+      throw Exception("factory failed");
+    }
+    ++created;
+    auto engine = newWarmEngine();
+    engine->setData(alive);
+    return engine;
+  };
+  EXPECT_THROW(utils::EnginePool(3, factory), Exception);
+  // the engines created before are destroyed
+  EXPECT_EQ(alive.use_count(), 1);
+}
+
+TEST(EnginePool, NoResetWhenFull) {
+  int resets = 0;
+  utils::EnginePool pool(1, newWarmEngine, [&resets](ScriptEngine*) {
+    ++resets;
+    return true;
+  });
+  {
+    auto lease1 = pool.lease();
+    auto lease2 = pool.lease();
+  }
+  EXPECT_EQ(pool.idleCount(), 1);
+  // the second one returned finds the pool full and is destroyed right away
+  EXPECT_EQ(resets, 1);
+  EXPECT_EQ(pool.getStatistics().reset, 1);
+}
+
+TEST(EnginePool, ResetGlobals) {
+  auto globals = utils::EnginePool::resetGlobals(newWarmEngine);
+  utils::EnginePool pool(1, globals.factory, globals.reset);
+
+  ScriptEngine* first;
+  {
+    auto lease = pool.lease();
+    first = lease.get();
+    EngineScope scope(lease.get());
+    lease->set(String::newString("dirty"), Boolean::newBoolean(true));
+    lease->set(String::newString("warm"), Boolean::newBoolean(false));
+  }
+
+  auto lease = pool.lease();
+  EXPECT_EQ(lease.get(), first);
+  EngineScope scope(lease.get());
+  EXPECT_TRUE(lease->get(String::newString("dirty")).isNull());
+  // globals of the factory are kept, not restored
+  EXPECT_TRUE(lease->get(String::newString("warm")).isBoolean());
+  EXPECT_EQ(pool.getStatistics().reset, 1);
+}
+
+}  // namespace script::test
@@ -15,6 +15,7 @@
  * limitations under the License.
  */
 
+#include <thread>
 #include "test.h"
 
 namespace script::test {
@@ -74,6 +75,265 @@ TEST_F(EngineTest, SmartPointer) {
   sharedPtr.reset();
 }
 
+#if defined(SCRIPTX_BACKEND_QUICKJS) || defined(SCRIPTX_BACKEND_LUA)
+
+TEST_F(EngineTest, HeapLimit) {
+  bool softLimitCrossed = false;
+  size_t hardLimitUsage = 0;
+  ScriptEngine::HeapLimit limit;
+  {
+    EngineScope scope(engine);
+    auto size = engine->getHeapSize();
+    limit.softLimit = size + 1024 * 1024;
+    limit.hardLimit = size + 8 * 1024 * 1024;
+    limit.callback = [&](ScriptEngine*, size_t usage, bool hardLimitReached) {
+      if (hardLimitReached) {
+        hardLimitUsage = usage;
+      } else {
+        softLimitCrossed = true;
+      }
+    };
+    engine->setHeapLimit(limit);
+
+    // out of memory can be caught by script
+    auto ret = engine->eval(TS().js(R"(
+      var caught = false;
+      try {
+        var list = [];
+        while (true) list.push("x".repeat(1024) + list.length);
+      } catch (e) {
+        caught = true;
+      }
+      list = null;
+      caught;
+    )")
+                                .lua(R"(
+      local ok = pcall(function()
+        local list = {}
+        while true do list[#list + 1] = string.rep("x", 1024) .. #list end
+      end)
+      return not ok
+    )")
+                                .select());
+    EXPECT_TRUE(ret.asBoolean().value());
+    engine->gc();
+  }
+
+  // the callback is called in messages
+  EXPECT_FALSE(softLimitCrossed);
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  EXPECT_TRUE(softLimitCrossed);
+  EXPECT_GT(hardLimitUsage, limit.softLimit);
+}
+
+#endif
+
+#ifdef SCRIPTX_BACKEND_V8
+
+TEST_F(EngineTest, V8HeapLimit) {
+  bool hardLimitReached = false;
+  EngineScope scope(engine);
+  ScriptEngine::HeapLimit limit;
+  limit.hardLimit = engine->getHeapSize() + 16 * 1024 * 1024;
+  limit.callback = [&](ScriptEngine*, size_t, bool reached) { hardLimitReached |= reached; };
+  engine->setHeapLimit(limit);
+
+  // termination can't be caught by script
+  try {
+    engine->eval(R"(
+      (function () {
+        const list = [];
+        while (true) {
+          try {
+            list.push("x".repeat(1024) + list.length);
+          } catch (e) {
+          }
+        }
+      })();
+    )");
+    FAIL() << "should be terminated";
+  } catch (const TerminationException& e) {
+    EXPECT_EQ(e.reason(), TerminationReason::kHeapLimit);
+    EXPECT_NE(e.message().find("heap limit"), std::string::npos) << e.message();
+  }
+
+  limit.hardLimit = 0;
+  engine->setHeapLimit(limit);
+  engine->gc();
+  EXPECT_EQ(engine->eval("1 + 1").asNumber().toInt32(), 2);
+
+  {
+    ExitEngineScope exit;
+    engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  }
+  EXPECT_TRUE(hardLimitReached);
+}
+
+#endif
+
+#if defined(SCRIPTX_BACKEND_V8) || defined(SCRIPTX_BACKEND_QUICKJS) || \
+    defined(SCRIPTX_BACKEND_LUA)
+
+TEST_F(EngineTest, ExecutionTimeout) {
+  EngineScope scope(engine);
+  engine->setExecutionTimeout(std::chrono::milliseconds(100));
+
+  // termination can't be caught by script
+  auto script = TS().js(R"(
+      while (true) {
+        try {
+          while (true) {}
+        } catch (e) {
+        }
+      }
+    )")
+                    .lua(R"(
+      while true do
+        pcall(function() while true do end end)
+      end
+    )")
+                    .select();
+  try {
+    engine->eval(script);
+    FAIL() << "should be terminated";
+  } catch (const TerminationException& e) {
+    EXPECT_EQ(e.reason(), TerminationReason::kTimeout);
+  }
+  EXPECT_FALSE(engine->getInterruptReason());
+
+  // the engine can run script again
+  EXPECT_EQ(engine->eval(TS().js("1 + 1").lua("return 1 + 1").select()).asNumber().toInt32(), 2);
+
+  engine->setExecutionTimeout(std::chrono::milliseconds(0));
+}
+
+TEST_F(EngineTest, Interrupt) {
+  EngineScope scope(engine);
+  // not running script, nothing to interrupt
+  engine->interrupt();
+  EXPECT_FALSE(engine->getInterruptReason());
+
+  auto loop = engine->eval(TS().js("(function() { while (true) {} })")
+                               .lua("return function() while true do end end")
+                               .select())
+                  .asFunction();
+
+  std::atomic_bool done = false;
+  std::thread thread([this, &done]() {
+    // until the loop is running
+    while (!done) {
+      engine->interrupt();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  });
+  try {
+    loop.call();
+    FAIL() << "should be interrupted";
+  } catch (const TerminationException& e) {
+    EXPECT_EQ(e.reason(), TerminationReason::kInterrupt);
+  }
+  done = true;
+  thread.join();
+
+  EXPECT_EQ(engine->eval(TS().js("1 + 1").lua("return 1 + 1").select()).asNumber().toInt32(), 2);
+}
+
+#ifdef SCRIPTX_BACKEND_LUA
+
+TEST_F(EngineTest, InterruptCoroutine) {
+  EngineScope scope(engine);
+  // created outside of any execution, so it doesn't inherit a hook from lua_
+  engine->eval(R"(
+      spin = coroutine.create(function()
+        while true do
+          pcall(function() while true do end end)
+        end
+      end)
+      wrapped = coroutine.wrap(function() while true do end end)
+      counter = coroutine.create(function()
+        local i = 0
+        while true do
+          i = i + 1
+          coroutine.yield(i)
+        end
+      end)
+    )");
+
+  engine->setExecutionTimeout(std::chrono::milliseconds(100));
+  for (auto script : {"coroutine.resume(counter) return coroutine.resume(spin)", "wrapped()"}) {
+    try {
+      engine->eval(script);
+      FAIL() << "should be terminated: " << script;
+    } catch (const TerminationException& e) {
+      EXPECT_EQ(e.reason(), TerminationReason::kTimeout);
+    }
+  }
+  engine->setExecutionTimeout(std::chrono::milliseconds(0));
+
+  // a fresh coroutine, interrupted from another thread
+  auto loop = engine->eval(R"(
+      return function()
+        local co = coroutine.create(function() while true do end end)
+        local ok, error = coroutine.resume(co)
+        while true do end
+      end
+    )")
+                  .asFunction();
+  std::atomic_bool done = false;
+  std::thread thread([this, &done]() {
+    while (!done) {
+      engine->interrupt();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  });
+  try {
+    loop.call();
+    FAIL() << "should be interrupted";
+  } catch (const TerminationException& e) {
+    EXPECT_EQ(e.reason(), TerminationReason::kInterrupt);
+  }
+  done = true;
+  thread.join();
+
+  // the hook left on the suspended coroutine is dropped once resumed without a timeout
+  auto result = engine->eval("local ok, i = coroutine.resume(counter) return i");
+  EXPECT_EQ(result.asNumber().toInt32(), 2);
+}
+
+#endif
+
+TEST_F(EngineTest, IdleGc) {
+  ScriptEngine::IdleGcPolicy policy;
+  policy.enabled = true;
+  policy.idleDelay = std::chrono::milliseconds(10);
+  engine->setIdleGcPolicy(policy);
+  {
+    EngineScope scope(engine);
+    engine->eval(TS().js("for (let i = 0; i < 10000; i++) { ({a: [i]}); }")
+                     .lua("for i = 1, 10000 do local t = {a = {i}} end")
+                     .select());
+  }
+
+  auto queue = engine->messageQueue();
+  utils::Message stop(
+      [](utils::Message& m) { static_cast<utils::MessageQueue*>(m.ptr0)->interrupt(); }, nullptr);
+  stop.ptr0 = queue.get();
+  queue->postMessage(stop, std::chrono::milliseconds(100));
+  queue->loopQueue(utils::MessageQueue::LoopType::kLoopAndWait);
+
+  auto stat = engine->getIdleGcStatistics();
+  EXPECT_GT(stat.steps, 0);
+  EXPECT_GT(stat.time.count(), 0);
+
+  policy.enabled = false;
+  engine->setIdleGcPolicy(policy);
+  queue->postMessage(stop, std::chrono::milliseconds(50));
+  queue->loopQueue(utils::MessageQueue::LoopType::kLoopAndWait);
+  EXPECT_EQ(engine->getIdleGcStatistics().steps, stat.steps);
+}
+
+#endif
+
 #ifndef SCRIPTX_BACKEND_WEBASSEMBLY
 
 TEST(EngineMessageQueueTest, MessageTag) {
@@ -102,6 +362,45 @@ TEST(EngineMessageQueueTest, MessageTag) {
 
 #endif
 
+#if defined(SCRIPTX_BACKEND_QUICKJS) || defined(SCRIPTX_BACKEND_LUA)
+
+namespace {
+
+class AssociatedMemoryClass : public ScriptClass {
+ public:
+  static int destroyed;
+
+  using ScriptClass::ScriptClass;
+
+  ~AssociatedMemoryClass() override { destroyed++; }
+};
+
+int AssociatedMemoryClass::destroyed = 0;
+
+}  // namespace
+
+TEST_F(EngineTest, AssociatedMemoryGc) {
+  auto define = defineClass<AssociatedMemoryClass>("AssociatedMemoryClass").constructor().build();
+  constexpr int64_t kSize = 64 * 1024 * 1024;
+
+  EngineScope scope(engine);
+  engine->registerNativeClass(define);
+  engine->gc();
+  AssociatedMemoryClass::destroyed = 0;
+
+  // garbage only a GC can collect
+  engine->eval(TS().js("(function() { const a = new AssociatedMemoryClass(); a.self = a; })();")
+                   .lua("AssociatedMemoryClass()")
+                   .select());
+
+  // native memory held by script objects drives the GC
+  engine->adjustAssociatedMemory(kSize);
+  EXPECT_EQ(AssociatedMemoryClass::destroyed, 1);
+  engine->adjustAssociatedMemory(-kSize);
+}
+
+#endif
+
 #ifdef SCRIPTX_BACKEND_LUA
 
 TEST_F(EngineTest, LuaBuiltIns) {
@@ -0,0 +1,133 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(JsonTest);
+
+TEST_F(JsonTest, Parse) {
+  EngineScope engineScope(engine);
+  auto value = Json::parse(R"( {"name": "ScriptX", "version": 3.5, "tags": ["js", "lua"],
+                               "nested": {"ok": true}} )");
+  ASSERT_TRUE(value.isObject());
+  auto object = value.asObject();
+  EXPECT_EQ(object.get("name").asString().toString(), "ScriptX");
+  EXPECT_EQ(object.get("version").asNumber().toDouble(), 3.5);
+
+  auto tags = object.get("tags").asArray();
+  ASSERT_EQ(tags.size(), 2);
+  EXPECT_EQ(tags.get(1).asString().toString(), "lua");
+
+  EXPECT_TRUE(object.get("nested").asObject().get("ok").asBoolean().value());
+
+  EXPECT_EQ(Json::parse("-12").asNumber().toInt32(), -12);
+  EXPECT_EQ(Json::parse("1e3").asNumber().toInt32(), 1000);
+  EXPECT_TRUE(Json::parse(" null ").isNull());
+}
+
+TEST_F(JsonTest, ParseString) {
+  EngineScope engineScope(engine);
+  EXPECT_EQ(Json::parse(R"("a\"b\\c\/d\n")").asString().toString(), "a\"b\\c/d\n");
+  // U+4F60 and U+1F600, the later one is a surrogate pair
+  EXPECT_EQ(Json::parse(R"("\u4f60\ud83d\ude00")").asString().toString(),
+            "\xe4\xbd\xa0\xf0\x9f\x98\x80");
+  // utf8 passes through
+  EXPECT_EQ(Json::parse("\"\xe4\xbd\xa0\"").asString().toString(), "\xe4\xbd\xa0");
+}
+
+TEST_F(JsonTest, ParseInvalid) {
+  EngineScope engineScope(engine);
+  for (auto json : {"", "{", "[1,]", "{\"a\" 1}", "tru", "01", "1.", "\"abc", "[1] 2", "{a: 1}"}) {
+    EXPECT_THROW(Json::parse(json), Exception) << json;
+  }
+}
+
+TEST_F(JsonTest, Stringify) {
+  EngineScope engineScope(engine);
+  EXPECT_EQ(Json::stringify(Number::newNumber(1)), "1");
+  EXPECT_EQ(Json::stringify(Number::newNumber(-1.5)), "-1.5");
+  EXPECT_EQ(Json::stringify(Number::newNumber(0.1)), "0.1");
+  EXPECT_EQ(Json::stringify(Boolean::newBoolean(true)), "true");
+  EXPECT_EQ(Json::stringify(String::newString("a\"b\n\x01")), R"("a\"b\n\u0001")");
+  EXPECT_EQ(Json::stringify(String::newString("\xe4\xbd\xa0")), "\"\xe4\xbd\xa0\"");
+  EXPECT_EQ(Json::stringify(Array::of(1, "two", false)), R"([1,"two",false])");
+
+  auto object = Object::newObject();
+  object.set("key", "value");
+  EXPECT_EQ(Json::stringify(object), R"({"key":"value"})");
+
+  // no JSON representation
+  EXPECT_EQ(Json::stringify(Function::newFunction([]() {})), "");
+}
+
+#ifdef SCRIPTX_LANG_JAVASCRIPT
+TEST_F(JsonTest, StringifyToJsonUndefined) {
+  EngineScope engineScope(engine);
+  auto value = engine->eval("({toJSON() { return undefined; }})");
+  EXPECT_EQ(Json::stringify(value), "");
+}
+#endif
+
+TEST_F(JsonTest, ArrayWithNull) {
+  EngineScope engineScope(engine);
+  EXPECT_EQ(Json::stringify(Json::parse("[1,null,null]")), "[1,null,null]");
+  EXPECT_EQ(Json::stringify(Json::parse("[null]")), "[null]");
+  EXPECT_EQ(Json::stringify(Json::parse("[]")), "[]");
+  EXPECT_EQ(Json::stringify(Json::parse(R"({"a":[]})")), R"({"a":[]})");
+  // a plain "n" field is not an array length
+  EXPECT_EQ(Json::stringify(Json::parse(R"({"n":2})")), R"({"n":2})");
+}
+
+TEST_F(JsonTest, StringifyCircular) {
+  EngineScope engineScope(engine);
+  auto object = Object::newObject();
+  object.set("self", object);
+  EXPECT_THROW(Json::stringify(object), Exception);
+}
+
+TEST_F(JsonTest, RoundTrip) {
+  EngineScope engineScope(engine);
+  auto json = R"({"id":42,"items":[{"name":"a","price":1.25},{"name":"b","price":2}]})";
+  auto value = Json::parse(json);
+  auto again = Json::parse(Json::stringify(value)).asObject();
+
+  EXPECT_EQ(again.get("id").asNumber().toInt32(), 42);
+  auto items = again.get("items").asArray();
+  ASSERT_EQ(items.size(), 2);
+  EXPECT_EQ(items.get(0).asObject().get("price").asNumber().toDouble(), 1.25);
+  EXPECT_EQ(items.get(1).asObject().get("name").asString().toString(), "b");
+
+  for (auto text : {R"({"a":[1,null,null],"b":[],"c":{"d":[null]},"e":"n"})", "[[],[[]]]"}) {
+    EXPECT_EQ(Json::stringify(Json::parse(text)), text);
+  }
+}
+
+TEST_F(JsonTest, ParsedArrayIsPlain) {
+  EngineScope engineScope(engine);
+  // nothing but the elements, lua keeps the length of arrays with null outside of them
+  EXPECT_TRUE(Json::parse("[]").asObject().getKeys().empty());
+#ifdef SCRIPTX_LANG_LUA
+  EXPECT_EQ(Json::parse("[1,null]").asObject().getKeys().size(), 1);
+  auto getMetatable = engine->eval("return getmetatable").asFunction();
+  EXPECT_TRUE(getMetatable.call({}, Json::parse("[null]")).isNull());
+#endif
+}
+
+}  // namespace script::test
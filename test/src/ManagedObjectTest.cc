@@ -101,9 +101,69 @@ TEST_F(ManagedObjectTest, CallGcWhilGc) {
   engine->gc();
 }
 
+namespace {
+
+int countedAlive = 0;
+
+class Counted : public ScriptClass {
+ public:
+  explicit Counted(const Local<Object>& thiz) : ScriptClass(thiz) { countedAlive++; }
+
+  ~Counted() override { countedAlive--; }
+};
+
+ClassDefine<Counted> counted = defineClass<Counted>("Counted").constructor().build();
+
+}  // namespace
+
+TEST_F(ManagedObjectTest, ManyObjects) {
+  countedAlive = 0;
+  {
+    EngineScope engineScope(engine);
+    engine->registerNativeClass(counted);
+    Global<Value> kept;
+    // more than the record pool keeps, so records are both recycled and freed
+    for (int round = 0; round < 3; ++round) {
+      {
+        StackFrameScope stack;
+        for (int i = 0; i < 2000; ++i) {
+          auto local = engine->newNativeClass<Counted>();
+          if (round == 0 && i == 0) kept = Global<Value>(local);
+        }
+      }
+      engine->gc();
+    }
+    EXPECT_GE(countedAlive, 1);
+  }
+  destroyEngine();
+  EXPECT_EQ(countedAlive, 0);
+}
+
 #ifdef SCRIPTX_BACKEND_V8
 // V8Engine specific test
 
+TEST_F(ManagedObjectTest, SlaveDestroyWithCollectedObjects) {
+  countedAlive = 0;
+  {
+    auto slave = static_cast<ScriptEngineImpl*>(engine)->newSlaveEngine();
+    EngineScope engineScope(slave.get());
+    slave->registerNativeClass(counted);
+    {
+      StackFrameScope stack;
+      for (int i = 0; i < 2000; ++i) {
+        slave->newNativeClass<Counted>();
+      }
+    }
+    // some may be collected, with the second pass callback still pending
+    slave->gc();
+  }
+  EXPECT_EQ(countedAlive, 0);
+
+  // second pass callbacks of the destroyed slave run on the shared isolate
+  engine->gc();
+  EXPECT_EQ(countedAlive, 0);
+}
+
 TEST_F(ManagedObjectTest, EngineDisposeWithSlave) {
   {
     auto slave = static_cast<ScriptEngineImpl*>(engine)->newSlaveEngine();
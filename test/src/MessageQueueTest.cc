@@ -208,4 +208,58 @@ TEST(MessageQueue, FullAndPostInsideLoopQueue) {
   q.shutdown(true);
 }
 
+namespace {
+
+class CountingIdleHandler : public MessageQueue::IdleHandler {
+ public:
+  int count = 0;
+  bool more = false;
+
+ protected:
+  bool onIdle(std::chrono::nanoseconds timeLeft) override {
+    EXPECT_GT(timeLeft.count(), 0);
+    count++;
+    return more && count < 3;
+  }
+};
+
+}  // namespace
+
+TEST(MessageQueue, IdleHandler) {
+  using std::chrono::milliseconds;
+  MessageQueue queue;
+  CountingIdleHandler handler;
+  queue.addIdleHandler(&handler, milliseconds(10));
+
+  Message nop(nullptr, nullptr);
+  Message stop([](Message& m) { static_cast<MessageQueue*>(m.ptr0)->interrupt(); }, nullptr);
+  stop.ptr0 = &queue;
+
+  // not in loopQueue(kLoopOnce)
+  queue.postMessage(nop);
+  queue.loopQueue(MessageQueue::LoopType::kLoopOnce);
+  EXPECT_EQ(handler.count, 0);
+
+  // once per idle period, two idle periods separated by nop
+  queue.postMessage(nop, milliseconds(100));
+  queue.postMessage(stop, milliseconds(200));
+  queue.loopQueue(MessageQueue::LoopType::kLoopAndWait);
+  EXPECT_EQ(handler.count, 2);
+
+  // more work, called again in the same idle period
+  handler.count = 0;
+  handler.more = true;
+  queue.postMessage(stop, milliseconds(100));
+  queue.loopQueue(MessageQueue::LoopType::kLoopAndWait);
+  EXPECT_EQ(handler.count, 3);
+
+  handler.count = 0;
+  queue.removeIdleHandler(&handler);
+  queue.postMessage(stop, milliseconds(50));
+  queue.loopQueue(MessageQueue::LoopType::kLoopAndWait);
+  EXPECT_EQ(handler.count, 0);
+
+  queue.shutdown(true);
+}
+
 }  // namespace script::utils
@@ -15,6 +15,11 @@
  * limitations under the License.
  */
 
+#include <array>
+#include <chrono>
+#include <map>
+#include <unordered_map>
+#include <vector>
 #include "test.h"
 
 namespace script::test {
@@ -190,5 +195,274 @@ TEST_F(PressureTest, All) {
   EXPECT_EQ(0, testClassInstanceCount);
 }
 
+TEST_F(PressureTest, ConstructBenchmark) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  using std::chrono::steady_clock;
+
+  constexpr auto kEnable = false;
+  constexpr auto kCount = 1000000;
+
+  // simple benchmark
+  if (!kEnable) return;
+
+  EngineScope scope(engine);
+  engine->registerNativeClass(TestClassDefAll);
+  auto construct = engine
+                       ->eval(TS().js(R"(
+                          (function(count) {
+                            for (var i = 0; i < count; ++i) new script.engine.test.TestClass();
+                          }))")
+                                  .lua(R"(
+                          return function(count)
+                            for i = 1, count do script.engine.test.TestClass() end
+                          end)")
+                                  .select())
+                       .asFunction();
+
+  auto start = steady_clock::now();
+  construct.call({}, Number::newNumber(kCount));
+  auto micros = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+  // in the test report (--gtest_output), instead of the console
+  RecordProperty("micros", static_cast<int>(micros));
+}
+
+TEST_F(PressureTest, NewFunctionBenchmark) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  using std::chrono::steady_clock;
+
+  constexpr auto kEnable = false;
+  constexpr auto kCount = 1000000;
+  constexpr auto kBatch = 1000;
+
+  // simple benchmark
+  if (!kEnable) return;
+
+  EngineScope scope(engine);
+  engine->gc();
+  auto heapBefore = engine->getHeapSize();
+
+  auto start = steady_clock::now();
+  for (int i = 0; i < kCount / kBatch; ++i) {
+    StackFrameScope stack;
+    for (int j = 0; j < kBatch; ++j) {
+      // a closure per call
+      Function::newFunction([i, j](const Arguments&) -> Local<Value> {
+        return Number::newNumber(i + j);
+      });
+    }
+    engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  }
+  auto micros = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+  engine->gc();
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  auto heapAfter = engine->getHeapSize();
+
+  auto heapGrowth = static_cast<int64_t>(heapAfter) - static_cast<int64_t>(heapBefore);
+  RecordProperty("micros", static_cast<int>(micros));
+  RecordProperty("heapGrowthKB", static_cast<int>(heapGrowth / 1024));
+}
+
+TEST_F(PressureTest, NewStringBenchmark) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  using std::chrono::steady_clock;
+
+  constexpr auto kEnable = false;
+  constexpr auto kCount = 1000000;
+  constexpr auto kBatch = 1000;
+
+  // simple benchmark
+  if (!kEnable) return;
+
+  auto repeat = [](std::string_view unit, size_t size) {
+    std::string ret;
+    while (ret.size() < size) ret.append(unit);
+    return ret;
+  };
+
+  // utf8 payloads
+  std::pair<const char*, std::string> payloads[] = {
+      {"ascii 8B", "hello!!!"},
+      {"ascii 1KB", repeat("hello world ", 1024)},
+      {"latin1 1KB", repeat("caf\xc3\xa9 cr\xc3\xa8me ", 1024)},
+      {"cjk 1KB", repeat("\xe4\xbd\xa0\xe5\xa5\xbd\xe4\xb8\x96\xe7\x95\x8c", 1024)},
+  };
+
+  EngineScope scope(engine);
+  std::string results;
+  for (auto& [name, payload] : payloads) {
+    auto start = steady_clock::now();
+    for (int i = 0; i < kCount / kBatch; ++i) {
+      StackFrameScope stack;
+      for (int j = 0; j < kBatch; ++j) {
+        String::newString(payload);
+      }
+    }
+    auto micros = duration_cast<microseconds>(steady_clock::now() - start).count();
+    engine->gc();
+
+    results += std::string(name) + ": " + std::to_string(micros) + "us; ";
+  }
+  RecordProperty("results", results);
+}
+
+TEST_F(PressureTest, ContainerConverterBenchmark) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  using std::chrono::steady_clock;
+
+  constexpr auto kEnable = false;
+  constexpr auto kSize = 1000;
+  constexpr auto kRound = 1000;
+
+  // simple benchmark
+  if (!kEnable) return;
+
+  std::string results;
+  auto measure = [&results](const char* name, auto&& fn) {
+    auto start = steady_clock::now();
+    for (int i = 0; i < kRound; ++i) {
+      StackFrameScope stack;
+      fn();
+    }
+    auto micros = duration_cast<microseconds>(steady_clock::now() - start).count();
+    results += std::string(name) + ": " + std::to_string(micros) + "us; ";
+  };
+
+  std::vector<double> numbers(kSize, 3.14);
+  std::vector<std::string> strings(kSize, "hello world");
+  std::array<double, kSize> fixed{};
+  std::map<std::string, double> map;
+  std::unordered_map<std::string, double> unorderedMap;
+  for (int i = 0; i < kSize; ++i) {
+    map.emplace(std::to_string(i), i);
+    unorderedMap.emplace(std::to_string(i), i);
+  }
+
+  EngineScope scope(engine);
+  using converter::Converter;
+
+  // to script
+  measure("vector<double> set loop", [&] {
+    auto array = Array::newArray();
+    for (size_t i = 0; i < numbers.size(); ++i) array.set(i, numbers[i]);
+  });
+  measure("vector<double> converter", [&] { Converter<std::vector<double>>::toScript(numbers); });
+  measure("vector<string> set loop", [&] {
+    auto array = Array::newArray();
+    for (size_t i = 0; i < strings.size(); ++i) array.set(i, strings[i]);
+  });
+  measure("vector<string> converter",
+          [&] { Converter<std::vector<std::string>>::toScript(strings); });
+  measure("array<double> converter",
+          [&] { Converter<std::array<double, kSize>>::toScript(fixed); });
+#ifdef __cpp_lib_span
+  measure("span<double> converter", [&] {
+    Converter<std::span<const double>>::toScript(std::span<const double>(numbers));
+  });
+#endif
+  measure("map set loop", [&] {
+    auto object = Object::newObject();
+    for (auto& [key, value] : map) object.set(key, value);
+  });
+  measure("map converter", [&] { Converter<std::map<std::string, double>>::toScript(map); });
+  measure("unordered_map converter",
+          [&] { Converter<std::unordered_map<std::string, double>>::toScript(unorderedMap); });
+
+  // to cpp
+  auto numberArray = Converter<std::vector<double>>::toScript(numbers).asArray();
+  measure("vector<double> get loop", [&] {
+    std::vector<double> ret;
+    for (size_t i = 0, size = numberArray.size(); i < size; ++i) {
+      ret.push_back(numberArray.get(i).asNumber().toDouble());
+    }
+  });
+  measure("vector<double> converter toCpp",
+          [&] { Converter<std::vector<double>>::toCpp(numberArray); });
+  auto stringArray = Converter<std::vector<std::string>>::toScript(strings).asArray();
+  measure("vector<string> get loop", [&] {
+    std::vector<std::string> ret;
+    for (size_t i = 0, size = stringArray.size(); i < size; ++i) {
+      ret.push_back(stringArray.get(i).asString().toString());
+    }
+  });
+  measure("vector<string> converter toCpp",
+          [&] { Converter<std::vector<std::string>>::toCpp(stringArray); });
+  auto object = Converter<std::map<std::string, double>>::toScript(map);
+  measure("map converter toCpp", [&] { Converter<std::map<std::string, double>>::toCpp(object); });
+  RecordProperty("results", results);
+}
+
+
+TEST_F(PressureTest, JsonBenchmark) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  using std::chrono::steady_clock;
+
+  constexpr auto kEnable = false;
+  constexpr auto kRound = 1000;
+
+  // simple benchmark
+  if (!kEnable) return;
+
+  std::string results;
+  auto measure = [&results](const std::string& name, auto&& fn) {
+    auto start = steady_clock::now();
+    for (int i = 0; i < kRound; ++i) {
+      StackFrameScope stack;
+      fn();
+    }
+    auto micros = duration_cast<microseconds>(steady_clock::now() - start).count();
+    results += name + ": " + std::to_string(micros) + "us; ";
+  };
+
+  // representative payloads: a small config, a list of records, a number matrix, long texts
+  std::vector<std::pair<std::string, std::string>> payloads;
+  payloads.emplace_back("config",
+                        R"({"name":"ScriptX","version":"3.5.0","debug":false,"threads":4,)"
+                        R"("paths":["/usr/lib","/usr/local/lib"],)"
+                        R"("limits":{"heap":268435456,"stack":1024}})");
+  std::string records = "[";
+  for (int i = 0; i < 100; ++i) {
+    if (i) records += ",";
+    records += R"({"id":)" + std::to_string(i) + R"(,"name":"user)" + std::to_string(i) +
+               R"(","score":)" + std::to_string(i * 1.5) + R"(,"active":true,"tags":["a","b"]})";
+  }
+  payloads.emplace_back("records", records + "]");
+  std::string matrix = "[";
+  for (int i = 0; i < 1000; ++i) {
+    matrix += (i ? "," : "") + std::to_string(i * 0.25);
+  }
+  payloads.emplace_back("numbers", matrix + "]");
+  std::string texts = "[";
+  for (int i = 0; i < 20; ++i) {
+    texts += std::string(i ? "," : "") + "\"" + std::string(500, 'x') + "\\n\\\"quoted\\\"\"";
+  }
+  payloads.emplace_back("texts", texts + "]");
+
+  EngineScope scope(engine);
+  for (auto& [name, json] : payloads) {
+    auto value = Global<Value>(Json::parse(json));
+    measure(name + " (" + std::to_string(json.size()) + "B) Json::parse",
+            [&] { Json::parse(json); });
+    measure(name + " Json::stringify", [&] { Json::stringify(value.get()); });
+
+#ifdef SCRIPTX_LANG_JAVASCRIPT
+    // what we did before, through the JSON object of the script
+    auto jsonObject = engine->get("JSON").asObject();
+    auto parse = Global<Function>(jsonObject.get("parse").asFunction());
+    auto stringify = Global<Function>(jsonObject.get("stringify").asFunction());
+    measure(name + " JSON.parse call", [&] { parse.get().call({}, json); });
+    measure(name + " JSON.stringify call",
+            [&] { stringify.get().call({}, value.get()).asString().toString(); });
+#endif
+  }
+  RecordProperty("results", results);
+}
+
 }  // namespace
 }  // namespace script::test
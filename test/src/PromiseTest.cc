@@ -0,0 +1,226 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <optional>
+#include <string>
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(PromiseTest);
+
+namespace {
+
+// JavaScriptCore and WebAssembly have no api for it, QuickJs needs the ScriptX patch
+#if defined(SCRIPTX_BACKEND_JAVASCRIPTCORE) || defined(SCRIPTX_BACKEND_WEBASSEMBLY) || \
+    (defined(SCRIPTX_BACKEND_QUICKJS) && !defined(QUICK_JS_HAS_SCRIPTX_PROMISE_PATCH))
+constexpr bool kHasPromiseState = false;
+#else
+constexpr bool kHasPromiseState = true;
+#endif
+
+// JavaScriptCore and WebAssembly run microtasks by themselves, V8 ignores the budget
+#if defined(SCRIPTX_BACKEND_V8) || defined(SCRIPTX_BACKEND_QUICKJS) || \
+    defined(SCRIPTX_BACKEND_LUA)
+constexpr bool kHasMicrotaskPolicy = true;
+#else
+constexpr bool kHasMicrotaskPolicy = false;
+#endif
+
+#if defined(SCRIPTX_BACKEND_QUICKJS) || defined(SCRIPTX_BACKEND_LUA)
+constexpr bool kHasMicrotaskBudget = true;
+#else
+constexpr bool kHasMicrotaskBudget = false;
+#endif
+
+void addCounterReactions(int count, int& counter) {
+  for (int i = 0; i < count; ++i) {
+    auto resolver = Promise::newPromise();
+    resolver.getPromise().then(Function::newFunction([&counter](const Arguments&) -> Local<Value> {
+      counter++;
+      return {};
+    }));
+    resolver.resolve(Number::newNumber(i));
+  }
+}
+
+}  // namespace
+
+TEST_F(PromiseTest, Resolve) {
+  int fulfilled = 0;
+  {
+    EngineScope engineScope(engine);
+    auto resolver = Promise::newPromise();
+    auto promise = resolver.getPromise();
+    EXPECT_TRUE(promise.asValue().isPromise());
+    EXPECT_EQ(promise.asValue().getKind(), ValueKind::kObject);
+    if (kHasPromiseState) {
+      EXPECT_EQ(promise.getState(), Promise::State::kPending);
+      EXPECT_TRUE(promise.getResult().isNull());
+    }
+
+    promise.then(Function::newFunction([&fulfilled](const Arguments& args) -> Local<Value> {
+      fulfilled = args[0].asNumber().toInt32();
+      return {};
+    }));
+    resolver.resolve(Number::newNumber(42));
+    if (kHasPromiseState) {
+      EXPECT_EQ(promise.getState(), Promise::State::kFulfilled);
+      EXPECT_EQ(promise.getResult().asNumber().toInt32(), 42);
+    }
+  }
+
+  // reactions run on the MessageQueue
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  EXPECT_EQ(fulfilled, 42);
+}
+
+TEST_F(PromiseTest, Reject) {
+  std::string reason;
+  {
+    EngineScope engineScope(engine);
+    auto resolver = Promise::newPromise();
+    resolver.getPromise().then(
+        {}, Function::newFunction([&reason](const Arguments& args) -> Local<Value> {
+          reason = args[0].asString().toString();
+          return {};
+        }));
+    resolver.reject(String::newString("failed"));
+    // already settled
+    resolver.resolve(Number::newNumber(1));
+    if (kHasPromiseState) {
+      EXPECT_EQ(resolver.getPromise().getState(), Promise::State::kRejected);
+    }
+  }
+
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  EXPECT_EQ(reason, "failed");
+}
+
+TEST_F(PromiseTest, ScriptPromise) {
+  {
+    EngineScope engineScope(engine);
+    auto promise = engine->eval(TS().js("Promise.resolve(1).then(v => v + 1)")
+                                    .lua("return Promise.resolve(1):next(function(v) "
+                                         "return v + 1 end)")
+                                    .select());
+    ASSERT_TRUE(promise.isPromise());
+    engine->set("promise", promise);
+
+    auto thenable = engine->eval(TS().js("({then() {}})").lua("return {next = 1}").select());
+    EXPECT_FALSE(thenable.isPromise());
+    EXPECT_THROW(thenable.asPromise(), Exception);
+  }
+
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  if (kHasPromiseState) {
+    EngineScope engineScope(engine);
+    auto promise = engine->get("promise").asPromise();
+    EXPECT_EQ(promise.getState(), Promise::State::kFulfilled);
+    EXPECT_EQ(promise.getResult().asNumber().toInt32(), 2);
+  }
+}
+
+TEST_F(PromiseTest, AsyncAwait) {
+  std::optional<Promise::Resolver> resolver;
+  {
+    EngineScope engineScope(engine);
+    engine->set("fetch", Function::newFunction([&resolver](const Arguments&) -> Local<Value> {
+                  resolver.emplace(Promise::newPromise());
+                  return resolver->getPromise();
+                }));
+    auto script = TS().js(R"(
+      var result = 0;
+      (async function() {
+        result = await fetch() + 1;
+      })();
+    )")
+                      .lua(R"(
+      result = 0
+      Promise.async(function()
+        result = Promise.await(fetch()) + 1
+      end)
+    )")
+                      .select();
+    engine->eval(script);
+    ASSERT_TRUE(resolver.has_value());
+    resolver->resolve(Number::newNumber(41));
+  }
+
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  EngineScope engineScope(engine);
+  EXPECT_EQ(engine->get("result").asNumber().toInt32(), 42);
+  resolver.reset();
+}
+
+TEST_F(PromiseTest, ExplicitMicrotaskPolicy) {
+  if (!kHasMicrotaskPolicy) return;
+
+  int counter = 0;
+  ScriptEngine::MicrotaskPolicy policy;
+  policy.mode = ScriptEngine::MicrotaskPolicy::Mode::kExplicit;
+  {
+    EngineScope engineScope(engine);
+    engine->setMicrotaskPolicy(policy);
+    addCounterReactions(3, counter);
+  }
+
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  EXPECT_EQ(counter, 0);
+
+  EXPECT_FALSE(engine->performMicrotaskCheckpoint());
+  EXPECT_EQ(counter, 3);
+  EXPECT_GE(engine->getMicrotaskStatistics().drains, 1);
+}
+
+TEST_F(PromiseTest, MicrotaskBudget) {
+  if (!kHasMicrotaskBudget) return;
+
+  int counter = 0;
+  ScriptEngine::MicrotaskPolicy policy;
+  policy.mode = ScriptEngine::MicrotaskPolicy::Mode::kExplicit;
+  policy.maxJobsPerDrain = 2;
+  {
+    EngineScope engineScope(engine);
+    engine->setMicrotaskPolicy(policy);
+    addCounterReactions(5, counter);
+  }
+
+  EXPECT_TRUE(engine->performMicrotaskCheckpoint());
+  EXPECT_EQ(counter, 2);
+
+  // auto mode continues in messages, 2 jobs each
+  {
+    EngineScope engineScope(engine);
+    policy.mode = ScriptEngine::MicrotaskPolicy::Mode::kAuto;
+    engine->setMicrotaskPolicy(policy);
+  }
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  EXPECT_EQ(counter, 4);
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopOnce);
+  EXPECT_EQ(counter, 5);
+
+  auto stat = engine->getMicrotaskStatistics();
+  EXPECT_EQ(stat.executed, 5);
+  EXPECT_EQ(stat.drains, 3);
+  EXPECT_EQ(stat.deferred, 2);
+#if defined(SCRIPTX_BACKEND_LUA) || defined(QUICK_JS_HAS_SCRIPTX_JOB_COUNT_PATCH)
+  EXPECT_EQ(stat.queued, 5);
+#endif
+}
+
+}  // namespace script::test
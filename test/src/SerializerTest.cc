@@ -0,0 +1,203 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <thread>
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(SerializerTest);
+
+namespace {
+
+SerializedData serialize(const Local<Value>& value) {
+  Serializer serializer;
+  serializer.writeValue(value);
+  return serializer.release();
+}
+
+}  // namespace
+
+TEST_F(SerializerTest, Primitives) {
+  EngineScope engineScope(engine);
+  for (auto value : {Local<Value>(Number::newNumber(42)), Local<Value>(Number::newNumber(-7)),
+                     Local<Value>(Number::newNumber(1.5)), Local<Value>(Number::newNumber(1e300)),
+                     Local<Value>(Boolean::newBoolean(true)),
+                     Local<Value>(String::newString("hello \xe4\xbd\xa0\xe5\xa5\xbd")),
+                     Local<Value>(String::newString(""))}) {
+    auto data = serialize(value);
+    auto copy = Deserializer(data).readValue();
+    EXPECT_EQ(copy.describeUtf8(), value.describeUtf8());
+  }
+
+  EXPECT_TRUE(Deserializer(serialize({})).readValue().isNull());
+}
+
+TEST_F(SerializerTest, ObjectGraph) {
+  EngineScope engineScope(engine);
+  auto shared = Object::newObject();
+  shared.set("name", "shared");
+  auto root = Object::newObject();
+  root.set("list", Array::of(1, "two", shared));
+  root.set("shared", shared);
+  root.set("self", root);
+
+  auto copy = Deserializer(serialize(root)).readValue().asObject();
+  EXPECT_FALSE(copy == root);
+  auto list = copy.get("list").asArray();
+  ASSERT_EQ(list.size(), 3);
+  EXPECT_EQ(list.get(0).asNumber().toInt32(), 1);
+  EXPECT_EQ(list.get(1).asString().toString(), "two");
+  EXPECT_EQ(copy.get("shared").asObject().get("name").asString().toString(), "shared");
+
+  // shared references and cycles are kept
+  EXPECT_TRUE(list.get(2) == copy.get("shared"));
+  EXPECT_TRUE(copy.get("self") == copy);
+}
+
+TEST_F(SerializerTest, MultipleValues) {
+  EngineScope engineScope(engine);
+  Serializer serializer;
+  serializer.writeValue(String::newString("first"));
+  serializer.writeValue(Number::newNumber(2));
+  auto data = serializer.release();
+
+  Deserializer deserializer(data);
+  EXPECT_EQ(deserializer.readValue().asString().toString(), "first");
+  EXPECT_EQ(deserializer.readValue().asNumber().toInt32(), 2);
+  EXPECT_THROW(deserializer.readValue(), Exception);
+}
+
+TEST_F(SerializerTest, ByteBuffer) {
+  EngineScope engineScope(engine);
+  auto buffer = ByteBuffer::newByteBuffer(4);
+  std::memcpy(buffer.getRawBytes(), "data", 4);
+  buffer.commit();
+
+  auto copy = Deserializer(serialize(buffer)).readValue().asByteBuffer();
+  copy.sync();
+  ASSERT_EQ(copy.byteLength(), 4);
+  EXPECT_EQ(std::memcmp(copy.getRawBytes(), "data", 4), 0);
+  EXPECT_NE(copy.getRawBytes(), buffer.getRawBytes());
+
+  auto bytes = buffer.getRawBytes();
+  Serializer serializer;
+  serializer.transfer(buffer);
+  serializer.writeValue(Array::of(buffer, buffer));
+  auto data = serializer.release();
+  auto array = Deserializer(data).readValue().asArray();
+  auto transferred = array.get(0).asByteBuffer();
+  transferred.sync();
+  EXPECT_EQ(std::memcmp(transferred.getRawBytes(), "data", 4), 0);
+  EXPECT_TRUE(array.get(1) == transferred);
+#if defined(SCRIPTX_BACKEND_V8)
+  // moved without copy, the sender is detached
+  EXPECT_EQ(data.transferred.size(), 1);
+  EXPECT_EQ(transferred.getRawBytes(), bytes);
+  EXPECT_EQ(buffer.byteLength(), 0);
+#else
+  (void)bytes;
+#endif
+}
+
+TEST_F(SerializerTest, TransferFromDestroyedEngine) {
+  SerializedData data;
+  auto sender = new ScriptEngineImpl();
+  {
+    EngineScope engineScope(sender);
+    auto buffer = ByteBuffer::newByteBuffer(4);
+    std::memcpy(buffer.getRawBytes(), "data", 4);
+    buffer.commit();
+    Serializer serializer;
+    serializer.transfer(buffer);
+    serializer.writeValue(buffer);
+    data = serializer.release();
+  }
+  sender->destroy();
+
+  {
+    EngineScope engineScope(engine);
+    auto buffer = Deserializer(data).readValue().asByteBuffer();
+    buffer.sync();
+    ASSERT_EQ(buffer.byteLength(), 4);
+    EXPECT_EQ(std::memcmp(buffer.getRawBytes(), "data", 4), 0);
+  }
+  // the last references to the memory go away in the receiver
+  data = {};
+  EngineScope engineScope(engine);
+  engine->gc();
+}
+
+TEST_F(SerializerTest, Unsupported) {
+  EngineScope engineScope(engine);
+  EXPECT_THROW(serialize(Function::newFunction([]() {})), Exception);
+  EXPECT_THROW(serialize(Promise::newPromise().getPromise()), Exception);
+#ifdef SCRIPTX_LANG_JAVASCRIPT
+  for (auto script : {"new Date()", "new Map()", "new Set()", "new (class A {})()"}) {
+    EXPECT_THROW(serialize(engine->eval(script)), Exception) << script;
+  }
+  // no prototype is still plain
+  EXPECT_NO_THROW(serialize(engine->eval("Object.create(null)")));
+#endif
+
+  auto deep = Array::newArray();
+  for (int i = 0; i < 2000; ++i) {
+    auto outer = Array::newArray();
+    outer.add(deep);
+    deep = outer;
+  }
+  EXPECT_THROW(serialize(deep), Exception);
+
+  SerializedData corrupted;
+  EXPECT_THROW(Deserializer{corrupted}, Exception);
+  auto data = serialize(String::newString("truncated"));
+  data.bytes.resize(data.bytes.size() - 1);
+  EXPECT_THROW(Deserializer(data).readValue(), Exception);
+
+  // nested arrays of one element, deep enough to overflow the stack without a limit
+  auto nested = serialize(Array::newArray());
+  nested.bytes.resize(2);
+  for (int i = 0; i < 100000; ++i) {
+    nested.bytes.append("A\x01");
+  }
+  nested.bytes.push_back('0');
+  EXPECT_THROW(Deserializer(nested).readValue(), Exception);
+}
+
+TEST_F(SerializerTest, CrossEngine) {
+  SerializedData data;
+  {
+    EngineScope engineScope(engine);
+    auto object = Object::newObject();
+    object.set("answer", 42);
+    data = serialize(object);
+  }
+
+  // read in another engine on another thread
+  std::thread([&data]() {
+    auto other = new ScriptEngineImpl();
+    {
+      EngineScope engineScope(other);
+      auto copy = Deserializer(data).readValue().asObject();
+      EXPECT_EQ(copy.get("answer").asNumber().toInt32(), 42);
+    }
+    other->destroy();
+  }).join();
+}
+
+}  // namespace script::test
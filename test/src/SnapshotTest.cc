@@ -0,0 +1,105 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test.h"
+
+namespace script::test {
+
+#ifdef SCRIPTX_BACKEND_V8
+
+namespace {
+
+class Counter : public ScriptClass {
+ public:
+  int count = 0;
+
+  using ScriptClass::ScriptClass;
+
+  int increase(int step) { return count += step; }
+
+  static int base;
+};
+
+int Counter::base = 0;
+
+const ClassDefine<Counter> CounterDefine =
+    defineClass<Counter>("Counter")
+        .nameSpace("snapshot")
+        .constructor()
+        .property("base", &Counter::base)
+        .function("twice", [](int x) { return x * 2; })
+        .instanceFunction("increase", &Counter::increase)
+        .instanceProperty("count", &Counter::count)
+        .build();
+
+const std::vector<NativeRegister>& snapshotClasses() {
+  static std::vector<NativeRegister> classes{CounterDefine.getNativeRegister()};
+  return classes;
+}
+
+}  // namespace
+
+TEST(Snapshot, V8CreateAndRestore) {
+  auto snapshot = v8_backend::V8Engine::createSnapshot(snapshotClasses(), [](auto* engine) {
+    engine->eval(R"(
+      var bootstrapped = snapshot.Counter.twice(21);
+      function makeCounter(base) {
+        var counter = new snapshot.Counter();
+        counter.increase(base);
+        return counter;
+      }
+    )");
+  });
+  ASSERT_FALSE(snapshot.empty());
+
+  for (int i = 0; i < 2; ++i) {
+    auto engine = new v8_backend::V8Engine({}, snapshot, snapshotClasses());
+    {
+      EngineScope scope(engine);
+      EXPECT_EQ(engine->get(String::newString("bootstrapped")).asNumber().toInt32(), 42);
+
+      auto ret = engine->eval("var c = makeCounter(3); c.increase(2); c.count");
+      EXPECT_EQ(ret.asNumber().toInt32(), 5);
+
+      Counter::base = 7;
+      EXPECT_EQ(engine->eval("snapshot.Counter.base").asNumber().toInt32(), 7);
+
+      // native classes are known to the engine
+      auto counter = engine->newNativeClass<Counter>();
+      EXPECT_TRUE(engine->isInstanceOf<Counter>(counter));
+      EXPECT_EQ(engine->getNativeInstance<Counter>(counter)->count, 0);
+    }
+    engine->destroy();
+  }
+}
+
+TEST(Snapshot, V8NativeObjectNotAllowed) {
+  EXPECT_THROW(v8_backend::V8Engine::createSnapshot(
+                   snapshotClasses(),
+                   [](auto* engine) { engine->eval("var keep = new snapshot.Counter();"); }),
+               Exception);
+}
+
+TEST(Snapshot, V8Mismatch) {
+  auto snapshot = v8_backend::V8Engine::createSnapshot(snapshotClasses());
+  EXPECT_THROW(new v8_backend::V8Engine({}, snapshot, {}), Exception);
+  EXPECT_THROW(new v8_backend::V8Engine({}, "not a snapshot", snapshotClasses()), Exception);
+}
+
+#endif
+
+}  // namespace script::test
@@ -0,0 +1,91 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+#include "test.h"
+
+namespace script::test {
+
+struct Point {
+  double x = 0;
+  double y = 0;
+};
+
+struct Shape {
+  std::string name;
+  std::vector<Point> points;
+  bool closed = false;
+  int32_t color = 0xff;
+};
+
+}  // namespace script::test
+
+SCRIPTX_STRUCT(script::test::Point, x, y);
+SCRIPTX_STRUCT(script::test::Shape, name, points, closed, color);
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(StructConverterTest);
+
+static_assert(converter::isConvertible<Point>);
+static_assert(converter::isConvertible<std::vector<Shape>>);
+
+TEST_F(StructConverterTest, ToScript) {
+  EngineScope engineScope(engine);
+  auto value = converter::Converter<Point>::toScript(Point{1, 2});
+  ASSERT_TRUE(value.isObject());
+  EXPECT_EQ(value.asObject().get("x").asNumber().toDouble(), 1);
+  EXPECT_EQ(value.asObject().get("y").asNumber().toDouble(), 2);
+}
+
+TEST_F(StructConverterTest, RoundTrip) {
+  EngineScope engineScope(engine);
+  Shape shape{"triangle", {{0, 0}, {1, 0}, {0, 1}}, true, 0x123456};
+  auto back = converter::Converter<Shape>::toCpp(converter::Converter<Shape>::toScript(shape));
+  EXPECT_EQ(back.name, shape.name);
+  ASSERT_EQ(back.points.size(), 3);
+  EXPECT_EQ(back.points[2].y, 1);
+  EXPECT_EQ(back.closed, true);
+  EXPECT_EQ(back.color, 0x123456);
+}
+
+TEST_F(StructConverterTest, MissingFields) {
+  EngineScope engineScope(engine);
+  auto object = Object::newObject();
+  object.set("name", "line");
+  auto shape = converter::Converter<Shape>::toCpp(object);
+  EXPECT_EQ(shape.name, "line");
+  EXPECT_TRUE(shape.points.empty());
+  // default member initializer kept
+  EXPECT_EQ(shape.color, 0xff);
+}
+
+TEST_F(StructConverterTest, Function) {
+  EngineScope engineScope(engine);
+  auto move = Function::newFunction([](Point point, double dx) {
+    point.x += dx;
+    return point;
+  });
+  engine->set("move", move);
+  auto ret = engine->eval(TS().js("move({x: 1, y: 2}, 10).x")
+                              .lua("return move({x = 1, y = 2}, 10).x")
+                              .select());
+  EXPECT_EQ(ret.asNumber().toDouble(), 11);
+}
+
+}  // namespace script::test
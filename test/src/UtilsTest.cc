@@ -15,6 +15,7 @@
  * limitations under the License.
  */
 
+#include "../../src/utils/Helper.hpp"
 #include "test.h"
 
 namespace script::test {
@@ -69,4 +70,21 @@ TEST_F(UtilsTest, Tracer) {
   Tracer::setDelegate(nullptr);
 }
 
-}  // namespace script::test
\ No newline at end of file
+TEST(Utils, IsAscii) {
+  EXPECT_TRUE(internal::isAscii(""));
+  EXPECT_TRUE(internal::isAscii("hello world"));
+  EXPECT_FALSE(internal::isAscii("caf\xc3\xa9"));
+
+  // cover the short, SIMD and tail paths
+  for (size_t length = 1; length < 100; ++length) {
+    std::string str(length, 'a');
+    EXPECT_TRUE(internal::isAscii(str)) << length;
+    for (size_t pos = 0; pos < length; ++pos) {
+      str[pos] = '\x80';
+      EXPECT_FALSE(internal::isAscii(str)) << length << " " << pos;
+      str[pos] = '\x7f';
+    }
+  }
+}
+
+}  // namespace script::test
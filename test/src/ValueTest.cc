@@ -184,6 +184,60 @@ TEST_F(ValueTest, String) {
   EXPECT_STREQ(string, str.toString().c_str());
 }
 
+TEST_F(ValueTest, StringHolder) {
+  EngineScope engineScope(engine);
+  // short, inline buffer boundary, long; ASCII and non-ASCII
+  std::string cases[] = {"",
+                         "hello",
+                         std::string(127, 'a'),
+                         std::string(128, 'a'),
+                         std::string(1000, 'a'),
+                         "caf\xc3\xa9",
+                         std::string(1000, 'a') + "\xe4\xbd\xa0\xe5\xa5\xbd"};
+  for (auto& str : cases) {
+    auto holder = String::newString(str).toStringHolder();
+    EXPECT_EQ(holder.stringView(), str);
+    EXPECT_EQ(holder.length(), str.length());
+    EXPECT_EQ(holder.c_str()[holder.length()], '\0');
+  }
+
+  // string_view parameter borrows from the StringHolder during the call
+  auto length = Function::newFunction([](std::string_view str) { return str.length(); });
+  for (auto& str : cases) {
+    EXPECT_EQ(length.call({}, str).asNumber().toInt64(), str.length());
+  }
+}
+
+TEST_F(ValueTest, ExternalString) {
+  std::weak_ptr<const std::string> weak;
+  {
+    EngineScope engineScope(engine);
+    auto utf8 = std::make_shared<const std::string>(std::string(1024, 'x') + "hello world");
+    weak = utf8;
+    auto str = String::newExternalString(utf8);
+    EXPECT_EQ(*utf8, str.toString());
+
+    auto nonAscii = String::newExternalString(std::make_shared<const std::string>("你好, 世界"));
+    EXPECT_EQ("你好, 世界", nonAscii.toString());
+
+    auto empty = String::newExternalString(std::make_shared<const std::string>());
+    EXPECT_EQ("", empty.toString());
+
+    auto literal = String::newExternalStaticString("hello world");
+    EXPECT_EQ("hello world", literal.toString());
+
+    engine->set("externalString", literal);
+    auto ret =
+        engine->eval(TS().js("externalString + '!'").lua("return externalString .. '!'").select());
+    EXPECT_EQ("hello world!", ret.asString().toString());
+
+    EXPECT_THROW(String::newExternalString(nullptr), Exception);
+  }
+  destroyEngine();
+  // released along with the engine
+  EXPECT_TRUE(weak.expired());
+}
+
 #ifdef __cpp_char8_t
 
 TEST_F(ValueTest, U8String) {
@@ -0,0 +1,242 @@
+/*
+ * Tencent is pleased to support the open source community by making ScriptX available.
+ * Copyright (C) 2023 THL A29 Limited, a Tencent company.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <future>
+#include <thread>
+#include "test.h"
+
+namespace script::test {
+
+DEFINE_ENGINE_TEST(WorkerTest);
+
+namespace {
+
+Local<String> workerScript() {
+  return TS().js("function onmessage(m) { postMessage({sum: m.a + m.b, twice: m.n * 2}); }")
+      .lua("function onmessage(m) postMessage({sum = m.a + m.b, twice = m.n * 2}) end")
+      .select();
+}
+
+ScriptEngine* newWorkerEngine(std::shared_ptr<utils::MessageQueue> queue) {
+  return new ScriptEngineImpl(std::move(queue));
+}
+
+void loadWorkerScript(utils::Worker& worker) {
+  worker.dispatch([](ScriptEngine* e) { e->eval(workerScript()); });
+}
+
+}  // namespace
+
+TEST_F(WorkerTest, PostMessage) {
+  utils::Worker worker(engine, newWorkerEngine);
+  loadWorkerScript(worker);
+
+  int sum = 0;
+  worker.setOnMessage([&sum](ScriptEngine* parent, const Local<Value>& message) {
+    sum = message.asObject().get("sum").asNumber().toInt32();
+    parent->messageQueue()->interrupt();
+  });
+
+  {
+    EngineScope engineScope(engine);
+    auto message = Object::newObject();
+    message.set("a", 1);
+    message.set("b", 2);
+    message.set("n", 0);
+    worker.postMessage(message);
+  }
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopAndWait);
+  EXPECT_EQ(sum, 3);
+}
+
+TEST_F(WorkerTest, ScriptObject) {
+  utils::Worker worker(engine, newWorkerEngine);
+  loadWorkerScript(worker);
+
+  {
+    EngineScope engineScope(engine);
+    engine->set("worker", worker.getScriptObject());
+    engine->set("done", Function::newFunction([this]() { engine->messageQueue()->interrupt(); }));
+    engine->eval(TS().js(R"(
+            var result = 0;
+            worker.onmessage = function(m) { result = m.twice; done(); };
+            worker.postMessage({a: 0, b: 0, n: 21});
+          )")
+                     .lua(R"(
+            result = 0
+            worker.onmessage = function(m) result = m.twice; done() end
+            worker.postMessage({a = 0, b = 0, n = 21})
+          )")
+                     .select());
+  }
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopAndWait);
+
+  EngineScope engineScope(engine);
+  EXPECT_EQ(engine->get("result").asNumber().toInt32(), 42);
+}
+
+TEST_F(WorkerTest, OnError) {
+  utils::Worker worker(engine, newWorkerEngine);
+  std::string error;
+  worker.setOnError([&error](ScriptEngine* parent, const Exception& e) {
+    error = e.message();
+    parent->messageQueue()->interrupt();
+  });
+
+  worker.dispatch([](ScriptEngine*) { throw Exception("oops"); });
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopAndWait);
+  EXPECT_NE(error.find("oops"), std::string::npos);
+
+  // the worker script throws in onmessage, the parent script gets onerror
+  worker.setOnError(nullptr);
+  worker.dispatch([](ScriptEngine* e) {
+    e->eval(TS().js("function onmessage(m) { throw new Error('bad ' + m); }")
+                .lua("function onmessage(m) error('bad ' .. m) end")
+                .select());
+  });
+  {
+    EngineScope engineScope(engine);
+    engine->set("worker", worker.getScriptObject());
+    engine->set("done", Function::newFunction([this]() { engine->messageQueue()->interrupt(); }));
+    engine->eval(TS().js(R"(
+            var errorMessage = "";
+            worker.onerror = function(e) { errorMessage = String(e); done(); };
+            worker.postMessage("message");
+          )")
+                     .lua(R"(
+            errorMessage = ""
+            worker.onerror = function(e) errorMessage = tostring(e); done() end
+            worker.postMessage("message")
+          )")
+                     .select());
+  }
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopAndWait);
+
+  EngineScope engineScope(engine);
+  EXPECT_NE(engine->get("errorMessage").asString().toString().find("bad message"),
+            std::string::npos);
+}
+
+TEST_F(WorkerTest, EngineOnWorkerThread) {
+  std::thread::id factoryThread;
+  utils::Worker worker(engine, [&factoryThread](std::shared_ptr<utils::MessageQueue> queue) {
+    factoryThread = std::this_thread::get_id();
+    return newWorkerEngine(std::move(queue));
+  });
+
+  std::promise<std::thread::id> taskThread;
+  worker.dispatch([&taskThread](ScriptEngine*) {
+    taskThread.set_value(std::this_thread::get_id());
+  });
+  auto id = taskThread.get_future().get();
+  EXPECT_EQ(factoryThread, id);
+  EXPECT_NE(factoryThread, std::this_thread::get_id());
+}
+
+TEST_F(WorkerTest, TerminateBusyWorker) {
+  utils::Worker worker(engine, newWorkerEngine);
+  std::promise<void> running;
+  worker.dispatch([&running](ScriptEngine* e) {
+    e->set("running", Function::newFunction([&running]() { running.set_value(); }));
+    e->eval(TS().js("running(); while (true) {}").lua("running(); while true do end").select());
+  });
+  running.get_future().wait();
+  // doesn't wait for the loop forever
+  worker.terminate();
+  EXPECT_EQ(worker.engine(), nullptr);
+}
+
+TEST_F(WorkerTest, TransferByteBuffer) {
+  utils::Worker worker(engine, newWorkerEngine);
+  worker.dispatch([](ScriptEngine* e) {
+    e->eval(TS().js("function onmessage(m) { received = m; postMessage(m.byteLength); }")
+                .lua("function onmessage(m) received = m; postMessage(1) end")
+                .select());
+  });
+  worker.setOnMessage([](ScriptEngine* parent, const Local<Value>&) {
+    parent->messageQueue()->interrupt();
+  });
+
+  {
+    EngineScope engineScope(engine);
+    auto buffer = ByteBuffer::newByteBuffer(4);
+    std::memcpy(buffer.getRawBytes(), "data", 4);
+    buffer.commit();
+    worker.postMessage(buffer, {buffer});
+#if defined(SCRIPTX_BACKEND_V8) && V8_MAJOR_VERSION >= 8
+    // moved to the worker
+    EXPECT_EQ(buffer.byteLength(), 0);
+#endif
+  }
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopAndWait);
+
+  std::promise<std::string> received;
+  worker.dispatch([&received](ScriptEngine* e) {
+    auto buffer = e->get("received").asByteBuffer();
+    buffer.sync();
+    received.set_value(
+        std::string(static_cast<const char*>(buffer.getRawBytes()), buffer.byteLength()));
+  });
+  EXPECT_EQ(received.get_future().get(), "data");
+}
+
+TEST_F(WorkerTest, TransferFromTerminatedWorker) {
+  utils::Worker worker(engine, newWorkerEngine);
+  Global<Value> received;
+  worker.setOnMessage([&received](ScriptEngine* parent, const Local<Value>& message) {
+    received = message;
+    parent->messageQueue()->interrupt();
+  });
+  worker.dispatch([](ScriptEngine* e) {
+    auto buffer = ByteBuffer::newByteBuffer(4);
+    std::memcpy(buffer.getRawBytes(), "data", 4);
+    buffer.commit();
+    e->get("postMessage").asFunction().call({}, buffer, Array::of(buffer));
+  });
+  engine->messageQueue()->loopQueue(utils::MessageQueue::LoopType::kLoopAndWait);
+
+  // the sender engine is gone before the buffer
+  worker.terminate();
+
+  EngineScope engineScope(engine);
+  auto buffer = received.get().asByteBuffer();
+  received.reset();
+  buffer.sync();
+  ASSERT_EQ(buffer.byteLength(), 4);
+  EXPECT_EQ(std::memcmp(buffer.getRawBytes(), "data", 4), 0);
+  engine->gc();
+}
+
+TEST_F(WorkerTest, Terminate) {
+  utils::Worker worker(engine, newWorkerEngine);
+  std::promise<void> created;
+  worker.dispatch([&created](ScriptEngine*) { created.set_value(); });
+  created.get_future().wait();
+  EXPECT_NE(worker.engine(), nullptr);
+  worker.terminate();
+  EXPECT_EQ(worker.engine(), nullptr);
+
+  EngineScope engineScope(engine);
+  EXPECT_THROW(worker.postMessage(Number::newNumber(1)), Exception);
+  EXPECT_THROW(worker.dispatch([](ScriptEngine*) {}), Exception);
+
+  // terminate twice is fine
+  worker.terminate();
+}
+
+}  // namespace script::test